@@ -0,0 +1,160 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+#include "scripter/Engine.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace scripter {
+
+    /**
+     * Bundle
+     *
+     * A precompiled bundle of scripts and their code caches created by
+     * scripter-compile, the file is mapped into memory and the scripts are
+     * served from it without touching the filesystem.
+     *
+     * The layout is a BundleHeader followed by the index table and then the
+     * paths, sources and code caches, every offset is from the start of the
+     * file. The paths are relative to the directory of the bundle file
+     */
+    class Bundle
+    {
+    public:
+        static const uint32 FORMAT_VERSION = 1;
+
+        struct Header
+        {
+            char magic[8];
+            uint32 formatVersion;
+            uint32 flagsHash;
+            char v8Version[32];
+            uint32 entryCount;
+            uint32 reserved;
+            uint64 indexOffset;
+        };
+
+        struct IndexEntry
+        {
+            uint64 pathOffset;
+            uint32 pathLength;
+            uint32 isModule;
+            uint64 sourceOffset;
+            uint64 sourceLength;
+            uint64 codeCacheOffset;
+            uint64 codeCacheLength;
+        };
+
+        struct Entry
+        {
+            const char* source;
+            size_t sourceLength;
+            const uint8* codeCache;
+            size_t codeCacheLength;
+            bool isModule;
+        };
+
+    private:
+        void* m_Data;
+        size_t m_Size;
+        bool m_CodeCacheValid;
+
+        std::unordered_map<String, Entry> m_Entries;
+
+    private:
+        Bundle(void* data, size_t size);
+
+    public:
+        ~Bundle();
+
+        /**
+         * Returns the entry for the absolute path or nullptr if the bundle
+         * doesn't contain it
+         */
+        const Entry* Find(const String& path) const;
+
+        /**
+         * Returns true if the code caches were created by the same V8 version
+         * with the same flags
+         */
+        bool IsCodeCacheValid() const { return m_CodeCacheValid; }
+
+        size_t GetEntryCount() const { return m_Entries.size(); }
+
+    public:
+        /**
+         * Maps a bundle file into memory, returns nullptr if the file can't be
+         * opened or isn't a valid bundle
+         */
+        static Bundle* Open(const String& path);
+    };
+
+    /**
+     * BundleWriter
+     *
+     * Compiles a script and everything it imports and writes them out as a
+     * bundle, this is what scripter-compile uses
+     */
+    class BundleWriter
+    {
+    private:
+        struct Item
+        {
+            String path;
+            String source;
+            bool isModule;
+            std::vector<uint8> codeCache;
+        };
+
+        Engine* m_Engine;
+
+        std::vector<Item> m_Items;
+        std::unordered_set<String> m_Added;
+
+    public:
+        BundleWriter(Engine* engine);
+        ~BundleWriter();
+
+        /**
+         * Adds a script and all the scripts it imports
+         * @param path the path to the script
+         * @param isModule if the script is a ES6 module
+         */
+        bool AddRoot(const String& path, bool isModule);
+
+        /**
+         * Writes the bundle to the file, the paths in the bundle are
+         * relative to the directory of the file
+         */
+        bool Write(const String& outputPath);
+
+    private:
+        bool AddScript(const String& path, bool isModule);
+    };
+
+} // namespace scripter
@@ -0,0 +1,97 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+#include "scripter/Engine.h"
+#include "scripter/Module.h"
+#include "scripter/ScriptEnv.h"
+
+#include <vector>
+
+namespace scripter {
+
+    /**
+     * ContextPool
+     *
+     * Keeps a number of warm script environments with the modules already
+     * imported, Acquire hands one out and Release resets it back to the
+     * baseline so the next user gets a clean environment
+     */
+    class ContextPool
+    {
+    private:
+        Engine* m_Engine;
+
+        std::vector<Module*> m_Modules;
+        std::vector<ScriptEnv*> m_Envs;
+        std::vector<ScriptEnv*> m_Available;
+
+    public:
+        /**
+         * Constructor
+         * @param engine the engine the script environments should use
+         * @param size the number of script environments to create up front
+         */
+        ContextPool(Engine* engine, int32 size);
+
+        ~ContextPool();
+
+        ContextPool(const ContextPool&) = delete;
+        ContextPool& operator=(const ContextPool&) = delete;
+
+        /**
+         * Adds a module that gets imported to every script environment in the
+         * pool, the pool doesn't take the ownership of the module
+         */
+        void AddModule(Module* module);
+
+        /**
+         * Returns a script environment from the pool, a new one is created if
+         * the pool is empty
+         */
+        ScriptEnv* Acquire();
+
+        /**
+         * Returns a script environment to the pool and resets it
+         */
+        void Release(ScriptEnv* env);
+
+        /**
+         * Returns the number of script environments ready to be acquired
+         */
+        size_t GetAvailableCount() const { return m_Available.size(); }
+
+        /**
+         * Deletes available script environments until only keepCount of them
+         * are left, the acquired ones are not touched
+         */
+        void Shrink(size_t keepCount);
+
+    private:
+        ScriptEnv* CreateEnv();
+        void ImportModules(ScriptEnv* env);
+    };
+
+} // namespace scripter
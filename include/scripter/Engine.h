@@ -26,14 +26,62 @@
 
 #include "scripter/Common.h"
 
+#include <functional>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include <libplatform/libplatform.h>
 #include <v8.h>
 
 namespace scripter {
 
+    class CodeCache;
+    class ContextPool;
+    class ModulePrefetcher;
+    class MemoryProfiler;
+    class Metrics;
+    class Platform;
+    struct NativeCallStats;
+    class ModuleRegistry;
+    class Profiler;
+    class ScriptError;
+
+    /**
+     * Statistics about the modules an engine owns
+     */
+    struct ModuleStats
+    {
+        size_t liveModules;
+        size_t referencedModules;
+        size_t liveBytes;
+    };
+
+    /**
+     * Statistics about the files read through the file cache, shared by all
+     * the engines
+     */
+    struct FileCacheStats
+    {
+        uint64 hits;
+        uint64 misses;
+        uint64 errors;
+        size_t entries;
+        size_t mappedBytes;
+    };
+
+    /**
+     * Options for the platform the engine runs V8 on
+     */
+    struct PlatformOptions
+    {
+        /** The number of worker threads, 0 uses the number of cores */
+        int32 workerCount = 0;
+
+        /** Pins every worker thread to its own core */
+        bool pinWorkers = false;
+    };
+
     /**
      * Engine
      *
@@ -42,11 +90,23 @@ namespace scripter {
     class Engine
     {
     private:
-        static std::unique_ptr<v8::Platform> s_Platform;
+        static std::unique_ptr<Platform> s_Platform;
 
     private:
         v8::Isolate* m_Isolate;
         v8::Isolate::CreateParams m_IsolateCreateParams;
+        CodeCache* m_CodeCache;
+        ModulePrefetcher* m_ModulePrefetcher;
+        ModuleRegistry* m_ModuleRegistry;
+        Profiler* m_Profiler;
+        MemoryProfiler* m_MemoryProfiler;
+        Metrics* m_Metrics;
+        bool m_NativeCallStats;
+        ScriptError* m_LastError;
+        bool m_HasLastError;
+        bool m_LogScriptErrors;
+        int32 m_StackTraceDepth;
+        std::vector<ContextPool*> m_ContextPools;
 
     public:
         Engine();
@@ -69,10 +129,70 @@ namespace scripter {
 
         /**
          * Checks a try catch if a exception was thrown, returns true if a
-         * exception was thrown
+         * exception was thrown. The exception is stored as the last error
+         * and logged if logging script errors is enabled
          */
         bool CheckTryCatch(v8::TryCatch* tryCatch);
 
+        /**
+         * Returns the last error caught by CheckTryCatch or nullptr, the
+         * error is formatted only when it's used. The error keeps its context
+         * alive until it's cleared or replaced
+         */
+        ScriptError* GetLastError() const
+        {
+            return m_HasLastError ? m_LastError : nullptr;
+        }
+
+        void ClearLastError();
+
+        /**
+         * Sets if CheckTryCatch logs the errors it catches, on by default.
+         * Turn it off if the scripts use exceptions for control flow and look
+         * at GetLastError instead
+         */
+        void SetLogScriptErrors(bool enabled) { m_LogScriptErrors = enabled; }
+
+        /**
+         * Sets how many stack frames are captured for uncaught exceptions,
+         * 0 disables capturing the stack
+         */
+        void SetStackTraceDepth(int32 depth);
+
+        int32 GetStackTraceDepth() const { return m_StackTraceDepth; }
+
+        /**
+         * Runs the tasks V8 has queued for this isolate, delayed tasks are
+         * run when their delay has passed. Call this regularly from the
+         * thread that owns the isolate, returns true if any task was run
+         */
+        bool RunPendingTasks();
+
+        /**
+         * Tells the engine it's idle until the deadline, the platform's idle
+         * tasks and V8's idle garbage collection are run in the idle time.
+         * Returns true if there's no idle work left
+         * @param deadlineInSeconds the deadline in the time of
+         * MonotonicallyIncreasingTime
+         */
+        bool NotifyIdle(double deadlineInSeconds);
+
+        /**
+         * Forwards a memory pressure notification to V8, the pooled script
+         * environments and the caches of the engine are shrunk too if
+         * shrinkCaches is true. Moderate pressure halves the idle
+         * environments and critical pressure drops everything that can be
+         * recreated
+         */
+        void OnMemoryPressure(v8::MemoryPressureLevel level,
+                              bool shrinkCaches = true);
+
+        /**
+         * Called by the context pools so the engine can shrink them
+         */
+        void AddContextPool(ContextPool* pool);
+        void RemoveContextPool(ContextPool* pool);
+
         /**
          * Prints an object and its properties
          */
@@ -94,6 +214,14 @@ namespace scripter {
          */
         v8::Local<v8::String> CreateString(const char* value);
 
+        /**
+         * Creates a javascript string from a buffer that doesn't need to be
+         * null terminated, returns an empty handle if the buffer is too large
+         * for a V8 string
+         */
+        v8::MaybeLocal<v8::String> CreateString(const char* value,
+                                                size_t length);
+
         String ConvertValueToString(v8::Local<v8::Value> value);
 
         /**
@@ -101,11 +229,169 @@ namespace scripter {
          */
         v8::Isolate* GetIsolate() const { return m_Isolate; }
 
+        /**
+         * Returns the code cache shared by all the script environments
+         */
+        CodeCache* GetCodeCache() const { return m_CodeCache; }
+
+        /**
+         * Returns the garbage collection and heap metrics of the engine
+         */
+        Metrics* GetMetrics() const { return m_Metrics; }
+
+        /**
+         * Enables recording the calls of native module functions, only the
+         * module objects generated after this is called are recorded
+         */
+        void SetNativeCallStatsEnabled(bool enabled)
+        {
+            m_NativeCallStats = enabled;
+        }
+
+        bool IsNativeCallStatsEnabled() const { return m_NativeCallStats; }
+
+        /**
+         * Returns the recorded calls of all the native modules the engine
+         * owns
+         */
+        std::vector<NativeCallStats> GetNativeCallStats() const;
+
+        /**
+         * Returns the registry of the modules imported by scripts
+         */
+        ModuleRegistry* GetModuleRegistry() const { return m_ModuleRegistry; }
+
+        /**
+         * Returns the number of modules the engine owns and how much memory
+         * they use
+         */
+        ModuleStats GetModuleStats() const;
+
+        /**
+         * Reads and parses a script and the scripts it imports on worker
+         * threads, the results are used when the scripts are compiled later
+         * @param rootPath the path to the root script
+         * @param isModule if the root script is a ES6 module
+         */
+        void PrefetchScripts(const String& rootPath, bool isModule);
+
+        /**
+         * Returns the prefetcher or nullptr if nothing has been prefetched
+         */
+        ModulePrefetcher* GetModulePrefetcher() const
+        {
+            return m_ModulePrefetcher;
+        }
+
+        /**
+         * Starts recording a cpu profile
+         * @param name the name of the profile, used to stop it later
+         * @param samplingIntervalUs how often the stack is sampled in
+         * microseconds, only used if no other profile is running
+         */
+        bool StartProfiling(const String& name,
+                            int32 samplingIntervalUs = 1000);
+
+        /**
+         * Stops a cpu profile and writes it to a file in the Chrome DevTools
+         * .cpuprofile format
+         * @param name the name of the profile
+         * @param outputPath the path of the file to write
+         */
+        bool StopProfiling(const String& name, const String& outputPath);
+
+        /**
+         * Starts a low frequency profile that logs the hottest functions
+         * every report interval, the report is logged from
+         * UpdateSamplingReport
+         * @param samplingIntervalUs how often the stack is sampled in
+         * microseconds
+         * @param reportIntervalMs how often the report is logged
+         * @param topCount the number of functions in the report
+         */
+        void StartSamplingReport(int32 samplingIntervalUs = 10000,
+                                 int32 reportIntervalMs = 60000,
+                                 int32 topCount = 10);
+
+        void StopSamplingReport();
+
+        /**
+         * Logs the sampling report if the report interval has passed, call
+         * this regularly from the thread that owns the isolate
+         */
+        void UpdateSamplingReport();
+
+        /**
+         * Writes a snapshot of the heap to a file in the Chrome DevTools
+         * .heapsnapshot format
+         * @param outputPath the path of the file to write
+         */
+        bool WriteHeapSnapshot(const String& outputPath);
+
+        /**
+         * Starts the sampling heap profiler
+         * @param sampleIntervalBytes the average number of bytes between
+         * samples
+         * @param stackDepth the maximum stack depth recorded for a sample
+         */
+        bool StartSamplingHeapProfiler(uint64 sampleIntervalBytes = 512 * 1024,
+                                       int32 stackDepth = 16);
+
+        void StopSamplingHeapProfiler();
+
+        /**
+         * Logs the top allocation sites recorded by the sampling heap
+         * profiler
+         * @param topCount the number of allocation sites in the report
+         */
+        void LogAllocationProfile(int32 topCount = 10);
+
+        /**
+         * Writes a heap snapshot automatically the first time the used heap
+         * size goes over the threshold, the snapshot is written the next time
+         * javascript runs after a garbage collection
+         * @param heapBytes the threshold in bytes, 0 disables it
+         * @param outputPath the path of the snapshot file
+         */
+        void SetHeapSnapshotThreshold(size_t heapBytes,
+                                      const String& outputPath);
+
     public:
         /**
          * Initializes the V8 library and some other systems ex. logger
+         * @param execPath the path to the executable
+         * @param moduleManifest optional manifest of native modules to load
+         * up front
+         * @param platformOptions the worker threads of the platform
+         */
+        static void InitializeV8(
+            const char* execPath, const char* moduleManifest = nullptr,
+            const PlatformOptions& platformOptions = PlatformOptions());
+
+        /**
+         * Runs a task on one of the platform's worker threads, the task runs
+         * before V8's own background work
+         */
+        static void PostBackgroundTask(std::function<void()> task);
+
+        /**
+         * Returns the platform's monotonic time in seconds, used for the idle
+         * deadlines
+         */
+        static double MonotonicallyIncreasingTime();
+
+        /**
+         * Returns how often the script and module files were found in the
+         * file cache
+         */
+        static FileCacheStats GetFileCacheStats();
+
+        /**
+         * Adds a directory that importModule searches for javascript modules
+         * and native module libraries, the directory of the importing script
+         * is always searched first. Call this after InitializeV8
          */
-        static void InitializeV8(const char* execPath);
+        static void AddModuleSearchPath(const String& directory);
 
         /**
          * Deinitializes the V8 library and some other systems
@@ -0,0 +1,82 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+#include "scripter/Engine.h"
+#include "scripter/ScriptEnv.h"
+
+#include <vector>
+
+namespace scripter {
+
+    class FileWatcher;
+
+    /**
+     * HotReloader
+     *
+     * Watches the files loaded by script environments with inotify and
+     * reloads the changed scripts and modules in place. The changes are only
+     * picked up when Update is called so a reload never happens in the middle
+     * of an invocation
+     */
+    class HotReloader
+    {
+    private:
+        Engine* m_Engine;
+        FileWatcher* m_Watcher;
+        std::vector<ScriptEnv*> m_Envs;
+
+    public:
+        /**
+         * Constructor
+         * @param engine the engine the script environments use
+         */
+        HotReloader(Engine* engine);
+        ~HotReloader();
+
+        /**
+         * Starts reloading a script environment, the environment needs to
+         * outlive the reloader or be removed first
+         */
+        void AddEnv(ScriptEnv* env);
+
+        /**
+         * Stops reloading a script environment, its files that no other
+         * environment uses are no longer watched
+         */
+        void RemoveEnv(ScriptEnv* env);
+
+        /**
+         * Reloads the files that changed since the last update, call this
+         * from the thread that owns the isolate between invocations. Returns
+         * the number of changed files
+         */
+        int32 Update();
+
+    private:
+        void WatchSources();
+    };
+
+} // namespace scripter
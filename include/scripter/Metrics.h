@@ -0,0 +1,185 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include <v8.h>
+
+namespace scripter {
+
+    class Engine;
+
+    /**
+     * A copy of the values in a histogram
+     */
+    struct HistogramSnapshot
+    {
+        static const uint32 BUCKET_COUNT = 32;
+
+        uint64 buckets[BUCKET_COUNT];
+        uint64 count;
+        uint64 sum;
+        uint64 max;
+    };
+
+    /**
+     * Histogram
+     *
+     * A lock free histogram with power of two buckets, bucket i counts the
+     * values less than 2^i. Values can be recorded from any thread
+     */
+    class Histogram
+    {
+    private:
+        std::atomic<uint64> m_Buckets[HistogramSnapshot::BUCKET_COUNT];
+        std::atomic<uint64> m_Count;
+        std::atomic<uint64> m_Sum;
+        std::atomic<uint64> m_Max;
+
+    public:
+        Histogram();
+
+        void Record(uint64 value);
+        void Reset();
+
+        HistogramSnapshot GetSnapshot() const;
+
+    public:
+        /**
+         * Returns the largest value a bucket counts, 2^i - 1, the last bucket
+         * has no bound. This is the le label of the exposition format
+         */
+        static uint64 GetBucketBound(uint32 index);
+    };
+
+    /**
+     * The statistics of one V8 heap space
+     */
+    struct HeapSpaceSnapshot
+    {
+        String name;
+        size_t size;
+        size_t used;
+        size_t available;
+        size_t physical;
+    };
+
+    /**
+     * A copy of all the metrics of an engine
+     */
+    struct MetricsSnapshot
+    {
+        /**
+         * The GC types V8 adds later are counted as other, the last type
+         */
+        static const uint32 GC_TYPE_COUNT = 5;
+
+        HistogramSnapshot gcPauses[GC_TYPE_COUNT];
+
+        size_t totalHeapSize;
+        size_t usedHeapSize;
+        size_t heapSizeLimit;
+        size_t mallocedMemory;
+        size_t externalMemory;
+        std::vector<HeapSpaceSnapshot> heapSpaces;
+    };
+
+    /**
+     * Metrics
+     *
+     * Records the garbage collection pauses and samples the heap statistics
+     * of an engine. The heap statistics are sampled after every garbage
+     * collection and when SampleHeapStatistics is called, snapshots can be
+     * taken from any thread
+     */
+    class Metrics
+    {
+    private:
+        struct HeapSpace
+        {
+            String name;
+            std::atomic<size_t> size;
+            std::atomic<size_t> used;
+            std::atomic<size_t> available;
+            std::atomic<size_t> physical;
+        };
+
+        Engine* m_Engine;
+
+        Histogram m_GCPauses[MetricsSnapshot::GC_TYPE_COUNT];
+        std::chrono::steady_clock::time_point
+            m_GCStart[MetricsSnapshot::GC_TYPE_COUNT];
+
+        std::atomic<size_t> m_TotalHeapSize;
+        std::atomic<size_t> m_UsedHeapSize;
+        std::atomic<size_t> m_HeapSizeLimit;
+        std::atomic<size_t> m_MallocedMemory;
+        std::atomic<size_t> m_ExternalMemory;
+        std::vector<HeapSpace*> m_HeapSpaces;
+
+    public:
+        Metrics(Engine* engine);
+        ~Metrics();
+
+        /**
+         * Reads the heap statistics from V8, needs to be called from the
+         * thread that owns the isolate
+         */
+        void SampleHeapStatistics();
+
+        MetricsSnapshot GetSnapshot() const;
+
+        /**
+         * Writes the metrics in the Prometheus text exposition format to a
+         * file
+         */
+        bool WriteExposition(const String& outputPath) const;
+
+        /**
+         * Writes the metrics in the Prometheus text exposition format to a
+         * UNIX socket
+         */
+        bool WriteExpositionToSocket(const String& socketPath) const;
+
+    public:
+        static String FormatExposition(const MetricsSnapshot& snapshot);
+
+        /**
+         * Returns the name of a garbage collection type index
+         */
+        static const char* GetGCTypeName(uint32 index);
+
+    private:
+        static void GCPrologueCallback(v8::Isolate* isolate, v8::GCType type,
+                                       v8::GCCallbackFlags flags, void* data);
+        static void GCEpilogueCallback(v8::Isolate* isolate, v8::GCType type,
+                                       v8::GCCallbackFlags flags, void* data);
+    };
+
+} // namespace scripter
@@ -138,6 +138,11 @@ namespace scripter {
         virtual v8::Local<v8::Object> GenerateObject() = 0;
 
         virtual String GetPackageName() = 0;
+
+        /**
+         * Returns an estimate of the memory the module uses
+         */
+        virtual size_t GetMemoryUsage() { return sizeof(Module); }
     };
 
 } // namespace scripter
\ No newline at end of file
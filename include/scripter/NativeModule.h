@@ -23,15 +23,70 @@
  */
 #pragma once
 
+#include "scripter/Metrics.h"
 #include "scripter/Module.h"
 
+#include <memory>
+#include <vector>
+
+/**
+ * Registers a native module that is linked into the binary so importModule
+ * can find it without loading a shared library, use it once in the source
+ * file of the module
+ */
+#define SCRIPTER_REGISTER_NATIVE_MODULE(name, type)                            \
+    static ::scripter::Module* ScripterCreateNativeModule_##type(              \
+        ::scripter::Engine* engine)                                            \
+    {                                                                          \
+        return new type(engine);                                               \
+    }                                                                          \
+    [[maybe_unused]] static bool s_ScripterNativeModuleRegistered_##type =     \
+        ::scripter::NativeModule::Register(                                    \
+            name, ScripterCreateNativeModule_##type)
+
 namespace scripter {
 
+    typedef Module* (*CreateModuleFunc)(Engine*);
+
+    /**
+     * The recorded calls of a native function
+     */
+    struct NativeCallStats
+    {
+        String module;
+        String function;
+        uint64 calls;
+        uint64 totalNanoseconds;
+        HistogramSnapshot latency;
+    };
+
     class NativeModule : public Module
     {
+    private:
+        static const uint32 CALL_SHARD_COUNT = 16;
+
+        // NOTE(patrik): Every thread records into its own shard so the calls
+        // don't fight over the same cache line, the shards are merged on read
+        struct alignas(64) CallShard
+        {
+            std::atomic<uint64> calls;
+            std::atomic<uint64> totalNanoseconds;
+            Histogram latency;
+        };
+
+        struct NativeFunction
+        {
+            const char* traceName = nullptr;
+            v8::FunctionCallback callback;
+            std::unique_ptr<CallShard[]> shards;
+        };
+
     protected:
         std::unordered_map<String, v8::FunctionCallback> m_Functions;
 
+    private:
+        std::unordered_map<String, NativeFunction> m_NativeFunctions;
+
     protected:
         NativeModule(Engine* engine);
 
@@ -41,6 +96,40 @@ namespace scripter {
         virtual v8::Local<v8::Object> GenerateObject() override;
 
         virtual String GetPackageName() override = 0;
+
+        virtual size_t GetMemoryUsage() override;
+
+        /**
+         * Returns the recorded calls of a function, returns false if the
+         * function has no recorded calls
+         */
+        bool GetCallStats(const String& functionName,
+                          NativeCallStats* result);
+
+        /**
+         * Returns the recorded calls of all the functions in the module
+         */
+        std::vector<NativeCallStats> GetCallStats();
+
+    public:
+        /**
+         * Registers a function that creates a native module, this is called
+         * by SCRIPTER_REGISTER_NATIVE_MODULE before main runs
+         */
+        static bool Register(const String& name, CreateModuleFunc func);
+
+        /**
+         * Returns the registered function for the module or nullptr
+         */
+        static CreateModuleFunc FindRegistered(const String& name);
+
+    private:
+        void MergeCallStats(const String& functionName,
+                            const NativeFunction& function,
+                            NativeCallStats* result);
+
+        static void
+        InstrumentedCall(const v8::FunctionCallbackInfo<v8::Value>& args);
     };
 
 } // namespace scripter
\ No newline at end of file
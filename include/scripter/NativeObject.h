@@ -0,0 +1,98 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+#include "scripter/Engine.h"
+
+#include <initializer_list>
+
+#include <v8.h>
+
+namespace scripter {
+
+    /**
+     * NativeObject
+     *
+     * Ties a C++ object to a javascript object made from a native class
+     * template. The C++ object is kept in the internal field and deleted
+     * when the javascript object is garbage collected
+     */
+    class NativeObject
+    {
+    public:
+        typedef void (*DeleteFunc)(void* object);
+
+        struct Method
+        {
+            const char* name;
+            v8::FunctionCallback callback;
+        };
+
+    public:
+        /**
+         * Creates a class template with one internal field, the methods get
+         * a signature so V8 only calls them on instances of the class
+         */
+        static v8::Local<v8::FunctionTemplate>
+        CreateClass(Engine* engine, const char* name,
+                    v8::FunctionCallback constructor,
+                    std::initializer_list<Method> methods);
+
+        /**
+         * Returns true if the constructor was called with new, throws and
+         * returns false otherwise
+         */
+        static bool
+        CheckConstructCall(Engine* engine,
+                           const v8::FunctionCallbackInfo<v8::Value>& args,
+                           const char* functionName);
+
+        /**
+         * Stores the object in the instance being constructed, the instance
+         * owns the object after this
+         */
+        template <typename T>
+        static void Wrap(Engine* engine, v8::Local<v8::Object> instance,
+                         T* object)
+        {
+            WrapPointer(engine, instance, object,
+                        [](void* pointer) { delete (T*)pointer; });
+        }
+
+        /**
+         * Returns the object of the receiver of a method
+         */
+        template <typename T>
+        static T* Unwrap(const v8::FunctionCallbackInfo<v8::Value>& args)
+        {
+            return (T*)args.This()->GetAlignedPointerFromInternalField(0);
+        }
+
+    private:
+        static void WrapPointer(Engine* engine, v8::Local<v8::Object> instance,
+                                void* object, DeleteFunc deleteFunc);
+    };
+
+} // namespace scripter
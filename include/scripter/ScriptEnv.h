@@ -23,14 +23,19 @@
  */
 #pragma once
 
+#include "scripter/Bundle.h"
 #include "scripter/Common.h"
 #include "scripter/Engine.h"
 #include "scripter/Module.h"
 
 #include <v8.h>
 
+#include <vector>
+
 namespace scripter {
 
+    class ModuleGraph;
+
     /**
      * ScriptEnv
      *
@@ -44,6 +49,13 @@ namespace scripter {
         Engine* m_Engine;
         v8::Persistent<v8::Context, v8::CopyablePersistentTraits<v8::Context>>
             m_Context;
+        v8::Persistent<v8::ObjectTemplate,
+                       v8::CopyablePersistentTraits<v8::ObjectTemplate>>
+            m_GlobalTemplate;
+        ModuleGraph* m_ModuleGraph;
+        Bundle* m_Bundle;
+        std::vector<Module*> m_ImportedModules;
+        std::vector<String> m_ScriptPaths;
 
     public:
         /**
@@ -64,6 +76,13 @@ namespace scripter {
          */
         void Disable();
 
+        /**
+         * Throws away the current context and creates a new one with the
+         * same global template, the global proxy object is reused. The script
+         * environment can't be active when this is called
+         */
+        void Reset();
+
         /**
          * Sets a global variable
          */
@@ -72,16 +91,63 @@ namespace scripter {
         v8::MaybeLocal<v8::Value> GetGlobal(const String& name);
 
         /**
-         * Imports an module
+         * Imports an module, the module object is created the first time the
+         * script uses it so the module needs to outlive the environment
          * @param module the module to import
          */
         void ImportModule(Module* module);
 
+        /**
+         * Holds a reference to a module owned by the engine's module registry,
+         * the reference is released when the environment is reset or deleted
+         */
+        void AddImportedModule(Module* module);
+
         /**
          * Compiles and runs a javascript script
          */
         v8::MaybeLocal<v8::Value> CompileAndRun(const String& filePath);
 
+        /**
+         * Compiles and runs a javascript script, the file is read in chunks
+         * and parsed on the platform's worker threads while the rest is still
+         * being read. Use this for large scripts, a script in the bundle is
+         * run like CompileAndRun does
+         */
+        v8::MaybeLocal<v8::Value> CompileAndRunStreamed(const String& filePath);
+
+        /**
+         * Maps a bundle created by scripter-compile, scripts and modules found
+         * in the bundle are loaded from it instead of the filesystem
+         * @param bundlePath the path to the bundle file
+         */
+        bool LoadBundle(const String& bundlePath);
+
+        /**
+         * Compiles and runs a javascript file as a ES6 module, imports are
+         * resolved relative to the importing file. Returns the module
+         * namespace object
+         */
+        v8::MaybeLocal<v8::Value> CompileAndRunModule(const String& filePath);
+
+        /**
+         * Recompiles the changed scripts and modules, the classic scripts are
+         * run again so the vars and functions they declare are replaced and
+         * the modules are replaced in the module graph with the modules that
+         * import them. Classic scripts with top level let, const or class
+         * can't be run twice in a context, they fail without running and need
+         * a Reset. Call this between invocations, returns false if anything
+         * failed
+         * @param changedPaths the absolute paths of the changed files
+         */
+        bool Reload(const std::vector<String>& changedPaths);
+
+        /**
+         * Returns the paths of the scripts and modules loaded in this
+         * environment
+         */
+        std::vector<String> GetSourcePaths() const;
+
         /**
          * Returns the V8 Context.
          */
@@ -92,6 +158,36 @@ namespace scripter {
          * @param name the name of the function
          */
         v8::MaybeLocal<v8::Function> GetFunction(const String& name);
+
+        /**
+         * Returns the engine this script environment uses
+         */
+        Engine* GetEngine() const { return m_Engine; }
+
+        /**
+         * Returns the ES6 modules compiled in this script environment
+         */
+        ModuleGraph* GetModuleGraph() const { return m_ModuleGraph; }
+
+    public:
+        /**
+         * Returns the script environment that owns the context
+         */
+        static ScriptEnv* FromContext(v8::Local<v8::Context> context);
+
+    private:
+        /**
+         * Compiles and runs a javascript script, compiled is set to true if
+         * the script compiled and was run
+         */
+        v8::MaybeLocal<v8::Value> CompileAndRunScript(const String& filePath,
+                                                      bool* compiled);
+
+        void SetupContext(v8::Local<v8::Context> context);
+        void ReleaseImportedModules();
+        void AddScriptPath(const String& filePath);
+        v8::ScriptOrigin CreateScriptOrigin(const String& filePath);
+        String ResolveScriptPath(const String& filePath);
     };
 
 } // namespace scripter
\ No newline at end of file
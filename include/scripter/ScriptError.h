@@ -0,0 +1,138 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+
+#include <vector>
+
+#include <v8.h>
+
+namespace scripter {
+
+    class Engine;
+
+    /**
+     * A frame in the stack trace of a script error
+     */
+    struct ScriptErrorFrame
+    {
+        String function;
+        String scriptName;
+        int32 lineNumber;
+        int32 column;
+    };
+
+    /**
+     * ScriptError
+     *
+     * A javascript exception caught by a try catch, only the handles are
+     * copied when the error is created and the strings are converted the
+     * first time they're used so an error that is never looked at is cheap
+     */
+    class ScriptError
+    {
+    private:
+        Engine* m_Engine;
+        v8::Persistent<v8::Context, v8::CopyablePersistentTraits<v8::Context>>
+            m_Context;
+        v8::Persistent<v8::Value, v8::CopyablePersistentTraits<v8::Value>>
+            m_Exception;
+        v8::Persistent<v8::Message, v8::CopyablePersistentTraits<v8::Message>>
+            m_Message;
+
+        bool m_Converted;
+        String m_Text;
+        String m_ScriptName;
+        String m_SourceLine;
+        int32 m_LineNumber;
+        int32 m_Column;
+
+        bool m_FramesConverted;
+        std::vector<ScriptErrorFrame> m_Frames;
+
+    public:
+        /**
+         * Creates an empty error that is filled in with Set
+         */
+        ScriptError(Engine* engine);
+
+        /**
+         * Constructor
+         * @param engine the engine the exception was thrown in
+         * @param tryCatch the try catch that caught the exception
+         */
+        ScriptError(Engine* engine, v8::TryCatch* tryCatch);
+        ~ScriptError();
+
+        ScriptError(const ScriptError&) = delete;
+        ScriptError& operator=(const ScriptError&) = delete;
+
+        /**
+         * Replaces the error with the exception caught by the try catch, the
+         * memory of the error is reused
+         */
+        void Set(v8::TryCatch* tryCatch);
+
+        /**
+         * Releases the handles of the error
+         */
+        void Clear();
+
+        /**
+         * Returns the exception value
+         */
+        v8::Local<v8::Value> GetException();
+
+        /**
+         * Returns the exception converted to a string
+         */
+        const String& GetText();
+
+        const String& GetScriptName();
+        const String& GetSourceLine();
+        int32 GetLineNumber();
+        int32 GetColumn();
+
+        /**
+         * Returns the captured stack frames, the number of frames is limited
+         * by Engine::SetStackTraceDepth
+         */
+        const std::vector<ScriptErrorFrame>& GetFrames();
+
+        /**
+         * Formats the whole error with the stack trace
+         */
+        String Format();
+
+        /**
+         * Logs the formatted error with the scripter logger
+         */
+        void Log();
+
+    private:
+        void Convert();
+    };
+
+} // namespace scripter
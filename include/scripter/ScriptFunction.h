@@ -0,0 +1,256 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+#include "scripter/Engine.h"
+#include "scripter/Logger.h"
+#include "scripter/ScriptEnv.h"
+
+#include <v8.h>
+
+namespace scripter {
+
+    /**
+     * ValueConverter
+     *
+     * Converts values between C++ and javascript, specialize this for your own
+     * record types to use them with ScriptFunction::InvokeBatch
+     */
+    template <typename T>
+    struct ValueConverter;
+
+    template <>
+    struct ValueConverter<double>
+    {
+        static v8::Local<v8::Value> ToValue(Engine* engine, const double& value)
+        {
+            return v8::Number::New(engine->GetIsolate(), value);
+        }
+
+        static bool FromValue(Engine* engine, v8::Local<v8::Value> value,
+                              double* result)
+        {
+            v8::Isolate* isolate = engine->GetIsolate();
+            return value->NumberValue(isolate->GetCurrentContext()).To(result);
+        }
+    };
+
+    template <>
+    struct ValueConverter<int32>
+    {
+        static v8::Local<v8::Value> ToValue(Engine* engine, const int32& value)
+        {
+            return v8::Integer::New(engine->GetIsolate(), value);
+        }
+
+        static bool FromValue(Engine* engine, v8::Local<v8::Value> value,
+                              int32* result)
+        {
+            v8::Isolate* isolate = engine->GetIsolate();
+            return value->Int32Value(isolate->GetCurrentContext()).To(result);
+        }
+    };
+
+    template <>
+    struct ValueConverter<bool>
+    {
+        static v8::Local<v8::Value> ToValue(Engine* engine, const bool& value)
+        {
+            return v8::Boolean::New(engine->GetIsolate(), value);
+        }
+
+        static bool FromValue(Engine* engine, v8::Local<v8::Value> value,
+                              bool* result)
+        {
+            *result = value->BooleanValue(engine->GetIsolate());
+            return true;
+        }
+    };
+
+    template <>
+    struct ValueConverter<String>
+    {
+        static v8::Local<v8::Value> ToValue(Engine* engine, const String& value)
+        {
+            return engine->CreateString(value);
+        }
+
+        static bool FromValue(Engine* engine, v8::Local<v8::Value> value,
+                              String* result)
+        {
+            *result = engine->ConvertValueToString(value);
+            return true;
+        }
+    };
+
+    /**
+     * ScriptFunction
+     *
+     * A handle to a javascript function inside a script environment, used to
+     * call into javascript from C++ without setting up the scopes every call
+     */
+    class ScriptFunction
+    {
+    private:
+        ScriptEnv* m_Env;
+        Engine* m_Engine;
+        v8::Persistent<v8::Function, v8::CopyablePersistentTraits<v8::Function>>
+            m_Function;
+
+    public:
+        /**
+         * Constructor
+         * @param env the script environment the function lives in
+         * @param function the function to call
+         */
+        ScriptFunction(ScriptEnv* env, v8::Local<v8::Function> function);
+
+        ~ScriptFunction();
+
+        /**
+         * Calls the function once with the arguments
+         */
+        v8::MaybeLocal<v8::Value> Invoke(int32 argc,
+                                         v8::Local<v8::Value> argv[]);
+
+        /**
+         * Calls the function once for every record, the context is only
+         * entered once for the whole batch. Returns the number of records
+         * processed, if a exception is thrown the batch stops at that record
+         * @param records the input records
+         * @param results preallocated output buffer with count elements
+         * @param count the number of records
+         */
+        template <typename TRecord, typename TResult>
+        size_t InvokeBatch(const TRecord* records, TResult* results,
+                           size_t count)
+        {
+            v8::Isolate* isolate = m_Engine->GetIsolate();
+
+            v8::HandleScope handleScope(isolate);
+            v8::Local<v8::Context> context = m_Env->GetContext();
+            v8::Context::Scope contextScope(context);
+            v8::TryCatch tryCatch(isolate);
+
+            v8::Local<v8::Function> function = m_Function.Get(isolate);
+            v8::Local<v8::Value> receiver = v8::Undefined(isolate);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                v8::HandleScope recordScope(isolate);
+
+                v8::Local<v8::Value> argv[] = {
+                    ValueConverter<TRecord>::ToValue(m_Engine, records[i])};
+
+                v8::Local<v8::Value> result;
+                if (!function->Call(context, receiver, 1, argv)
+                         .ToLocal(&result))
+                {
+                    m_Engine->CheckTryCatch(&tryCatch);
+                    return i;
+                }
+
+                if (!ValueConverter<TResult>::FromValue(m_Engine, result,
+                                                        &results[i]))
+                {
+                    m_Engine->CheckTryCatch(&tryCatch);
+                    return i;
+                }
+            }
+
+            return count;
+        }
+
+        /**
+         * Calls the function once with all the records packed into one
+         * javascript array, the function needs to return an array with the
+         * same length. Returns the number of results written
+         * @param records the input records
+         * @param results preallocated output buffer with count elements
+         * @param count the number of records
+         */
+        template <typename TRecord, typename TResult>
+        size_t InvokeBatchArray(const TRecord* records, TResult* results,
+                                size_t count)
+        {
+            v8::Isolate* isolate = m_Engine->GetIsolate();
+
+            v8::HandleScope handleScope(isolate);
+            v8::Local<v8::Context> context = m_Env->GetContext();
+            v8::Context::Scope contextScope(context);
+            v8::TryCatch tryCatch(isolate);
+
+            v8::Local<v8::Array> input = v8::Array::New(isolate, (int)count);
+            for (size_t i = 0; i < count; i++)
+            {
+                input->Set(
+                    context, (uint32)i,
+                    ValueConverter<TRecord>::ToValue(m_Engine, records[i]))
+                    .FromJust();
+            }
+
+            v8::Local<v8::Value> argv[] = {input};
+
+            v8::Local<v8::Value> output;
+            if (!m_Function.Get(isolate)
+                     ->Call(context, v8::Undefined(isolate), 1, argv)
+                     .ToLocal(&output))
+            {
+                m_Engine->CheckTryCatch(&tryCatch);
+                return 0;
+            }
+
+            if (!output->IsArray())
+            {
+                SCRIPTER_LOG_ERROR("ScriptFunction::InvokeBatchArray: The "
+                                   "function needs to return an array");
+                return 0;
+            }
+
+            v8::Local<v8::Array> array = v8::Local<v8::Array>::Cast(output);
+            size_t length = array->Length() < count ? array->Length() : count;
+
+            for (size_t i = 0; i < length; i++)
+            {
+                v8::Local<v8::Value> value;
+                if (!array->Get(context, (uint32)i).ToLocal(&value) ||
+                    !ValueConverter<TResult>::FromValue(m_Engine, value,
+                                                        &results[i]))
+                {
+                    m_Engine->CheckTryCatch(&tryCatch);
+                    return i;
+                }
+            }
+
+            return length;
+        }
+
+        /**
+         * Returns the V8 function
+         */
+        v8::Local<v8::Function> GetFunction();
+    };
+
+} // namespace scripter
@@ -0,0 +1,149 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include <v8-platform.h>
+
+#define SCRIPTER_TRACE_CONCAT_INTERNAL(a, b) a##b
+#define SCRIPTER_TRACE_CONCAT(a, b) SCRIPTER_TRACE_CONCAT_INTERNAL(a, b)
+
+/**
+ * Records a trace event for the rest of the scope, the name needs to outlive
+ * the trace so use a string literal or Tracer::InternName
+ */
+#define SCRIPTER_TRACE_SCOPE(name)                                             \
+    ::scripter::TraceScope SCRIPTER_TRACE_CONCAT(_traceScope, __LINE__)(name)
+
+namespace scripter {
+
+    /**
+     * Tracer
+     *
+     * Records the trace events of the library into per thread ring buffers
+     * and writes them together with V8's own trace events to a Chrome trace
+     * file that can be opened in chrome://tracing or Perfetto
+     */
+    class Tracer
+    {
+    private:
+        static std::atomic<bool> s_Enabled;
+
+    private:
+        Tracer();
+
+    public:
+        /**
+         * Starts recording, can be called before Engine::InitializeV8 to
+         * trace the startup
+         * @param outputPath the path of the trace file
+         * @param v8Categories comma separated list of V8 trace categories to
+         * enable, ex. "v8,disabled-by-default-v8.compile"
+         */
+        static void Start(const String& outputPath,
+                          const String& v8Categories);
+
+        /**
+         * Stops recording and writes the trace file
+         */
+        static bool Stop();
+
+        /**
+         * Returns true if events are being recorded
+         */
+        static bool IsEnabled()
+        {
+            return s_Enabled.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Adds a complete event to the ring buffer of the current thread
+         */
+        static void AddEvent(const char* name, int64 start, int64 duration);
+
+        /**
+         * Returns a copy of the name that lives as long as the program
+         */
+        static const char* InternName(const String& name);
+
+        /**
+         * Returns the current time in microseconds, the same clock as V8's
+         * trace events
+         */
+        static int64 Now()
+        {
+            auto now = std::chrono::steady_clock::now().time_since_epoch();
+            return std::chrono::duration_cast<std::chrono::microseconds>(now)
+                .count();
+        }
+
+        /**
+         * Creates the tracing controller given to the V8 platform, called by
+         * Engine::InitializeV8
+         */
+        static std::unique_ptr<v8::TracingController> CreateTracingController();
+
+        /**
+         * Forgets the tracing controller, called when the platform is
+         * destroyed
+         */
+        static void ReleaseTracingController();
+    };
+
+    /**
+     * TraceScope
+     *
+     * Records a trace event from the construction to the destruction
+     */
+    class TraceScope
+    {
+    private:
+        const char* m_Name;
+        int64 m_Start;
+
+    public:
+        /**
+         * Constructor
+         * @param name the name of the event, nothing is recorded if it's
+         * nullptr
+         */
+        TraceScope(const char* name)
+            : m_Name(name),
+              m_Start(name && Tracer::IsEnabled() ? Tracer::Now() : -1)
+        {
+        }
+
+        ~TraceScope()
+        {
+            if (m_Start >= 0)
+                Tracer::AddEvent(m_Name, m_Start, Tracer::Now() - m_Start);
+        }
+    };
+
+} // namespace scripter
@@ -0,0 +1,213 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+#include "scripter/Engine.h"
+
+#include <string.h>
+
+#include <utility>
+#include <vector>
+
+#include <v8.h>
+
+namespace scripter {
+
+    /**
+     * A pointer and a length to the elements of a typed array, only valid
+     * while the array is alive and its buffer isn't detached
+     */
+    template <typename T>
+    struct ArraySpan
+    {
+        T* data = nullptr;
+        size_t size = 0;
+
+        T* begin() const { return data; }
+        T* end() const { return data + size; }
+
+        T& operator[](size_t index) const { return data[index]; }
+
+        bool empty() const { return size == 0; }
+    };
+
+    /**
+     * TypedArrayTraits
+     *
+     * Maps a C++ element type to its javascript typed array
+     */
+    template <typename T>
+    struct TypedArrayTraits;
+
+#define SCRIPTER_TYPED_ARRAY_TRAITS(type, arrayType)                           \
+    template <>                                                                \
+    struct TypedArrayTraits<type>                                              \
+    {                                                                          \
+        typedef v8::arrayType Type;                                            \
+        static bool Is(v8::Local<v8::Value> value)                             \
+        {                                                                      \
+            return value->Is##arrayType();                                     \
+        }                                                                      \
+    }
+
+    SCRIPTER_TYPED_ARRAY_TRAITS(int8, Int8Array);
+    SCRIPTER_TYPED_ARRAY_TRAITS(uint8, Uint8Array);
+    SCRIPTER_TYPED_ARRAY_TRAITS(int16, Int16Array);
+    SCRIPTER_TYPED_ARRAY_TRAITS(uint16, Uint16Array);
+    SCRIPTER_TYPED_ARRAY_TRAITS(int32, Int32Array);
+    SCRIPTER_TYPED_ARRAY_TRAITS(uint32, Uint32Array);
+    SCRIPTER_TYPED_ARRAY_TRAITS(float, Float32Array);
+    SCRIPTER_TYPED_ARRAY_TRAITS(double, Float64Array);
+
+#undef SCRIPTER_TYPED_ARRAY_TRAITS
+
+    /**
+     * TypedArray
+     *
+     * Moves contiguous C++ data in and out of javascript typed arrays without
+     * converting the elements one by one
+     */
+    class TypedArray
+    {
+    public:
+        typedef void (*FreeBufferFunc)(void* owner);
+
+    public:
+        /**
+         * Creates a typed array with a copy of the data
+         */
+        template <typename T>
+        static v8::Local<typename TypedArrayTraits<T>::Type>
+        Copy(Engine* engine, const T* data, size_t count)
+        {
+            v8::Local<v8::ArrayBuffer> buffer =
+                v8::ArrayBuffer::New(engine->GetIsolate(), count * sizeof(T));
+
+            if (count > 0)
+                memcpy(buffer->GetContents().Data(), data, count * sizeof(T));
+
+            return TypedArrayTraits<T>::Type::New(buffer, 0, count);
+        }
+
+        /**
+         * Creates a typed array that takes the ownership of the vector, the
+         * vector is freed when the array is garbage collected
+         */
+        template <typename T>
+        static v8::Local<typename TypedArrayTraits<T>::Type>
+        Adopt(Engine* engine, std::vector<T>&& data)
+        {
+            std::vector<T>* owner = new std::vector<T>(std::move(data));
+            v8::Local<v8::ArrayBuffer> buffer = CreateBuffer(
+                engine, owner->data(), owner->size() * sizeof(T), owner,
+                [](void* vector) { delete (std::vector<T>*)vector; });
+
+            return TypedArrayTraits<T>::Type::New(buffer, 0, owner->size());
+        }
+
+        /**
+         * Creates a typed array that borrows the data, the data needs to stay
+         * alive until the array is detached with Detach
+         */
+        template <typename T>
+        static v8::Local<typename TypedArrayTraits<T>::Type>
+        Borrow(Engine* engine, T* data, size_t count)
+        {
+            v8::Local<v8::ArrayBuffer> buffer = CreateBuffer(
+                engine, data, count * sizeof(T), nullptr, nullptr);
+
+            return TypedArrayTraits<T>::Type::New(buffer, 0, count);
+        }
+
+        /**
+         * Returns the elements of a typed array, returns false if the value
+         * isn't a typed array of the type
+         */
+        template <typename T>
+        static bool GetSpan(v8::Local<v8::Value> value, ArraySpan<T>* result)
+        {
+            if (!TypedArrayTraits<T>::Is(value))
+                return false;
+
+            v8::Local<v8::ArrayBufferView> view =
+                value.As<v8::ArrayBufferView>();
+            uint8* data = (uint8*)view->Buffer()->GetContents().Data();
+
+            result->data = data ? (T*)(data + view->ByteOffset()) : nullptr;
+            result->size = view->ByteLength() / sizeof(T);
+            return true;
+        }
+
+        /**
+         * Copies the elements of a typed array to a vector, returns false if
+         * the value isn't a typed array of the type
+         */
+        template <typename T>
+        static bool ToVector(v8::Local<v8::Value> value,
+                             std::vector<T>* result)
+        {
+            ArraySpan<T> span;
+            if (!GetSpan(value, &span))
+                return false;
+
+            result->assign(span.begin(), span.end());
+            return true;
+        }
+
+        /**
+         * Returns the bytes of any ArrayBufferView ex. a DataView or a typed
+         * array of any type, returns false if the value isn't a view
+         */
+        static bool GetBytes(v8::Local<v8::Value> value,
+                             ArraySpan<uint8>* result);
+
+        /**
+         * Returns the bytes of a view like GetBytes or a string converted to
+         * UTF-8 into the buffer, returns false for any other value
+         * @param buffer holds the converted string, the result points into
+         * it so it needs to outlive the result
+         */
+        static bool GetBytesOrUtf8(Engine* engine, v8::Local<v8::Value> value,
+                                   String& buffer, ArraySpan<uint8>* result);
+
+        /**
+         * Detaches the buffer of a borrowed array so scripts can't reach the
+         * data anymore, the array reads as empty after this
+         */
+        static void Detach(v8::Local<v8::ArrayBufferView> array);
+
+        /**
+         * Creates an array buffer for external memory, the free function is
+         * called with the owner when the buffer is garbage collected. A null
+         * free function borrows the memory
+         */
+        static v8::Local<v8::ArrayBuffer> CreateBuffer(Engine* engine,
+                                                       void* data,
+                                                       size_t byteLength,
+                                                       void* owner,
+                                                       FreeBufferFunc freeFunc);
+    };
+
+} // namespace scripter
@@ -0,0 +1,73 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+#include "scripter/NativeModule.h"
+
+#include <string_view>
+
+namespace scripter { namespace modules {
+
+    /**
+     * Json
+     *
+     * A JSON module that parses straight into V8 values without going
+     * through a javascript string and JSON.parse, it also has a streaming
+     * parser for newline delimited JSON
+     */
+    class Json : public NativeModule
+    {
+    private:
+        v8::Persistent<v8::FunctionTemplate> m_ParserTemplate;
+
+    public:
+        Json(Engine* engine);
+        ~Json();
+
+        virtual v8::Local<v8::Object> GenerateObject() override;
+
+        virtual String GetPackageName() override;
+
+    public:
+        /**
+         * Parses a JSON document into V8 values, throws a SyntaxError in the
+         * isolate and returns an empty handle if the document is invalid
+         * @param engine the engine the values are created in, needs an
+         * entered context
+         * @param json the UTF-8 document
+         */
+        static v8::MaybeLocal<v8::Value> Parse(Engine* engine,
+                                               std::string_view json);
+
+        /**
+         * Appends a value as JSON to the output, throws in the isolate and
+         * returns false if the value can't be converted. Values that have no
+         * JSON form ex. undefined append nothing and return true
+         */
+        static bool Stringify(Engine* engine, v8::Local<v8::Value> value,
+                              String& out);
+    };
+
+}} // namespace scripter::modules
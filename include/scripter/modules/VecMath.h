@@ -0,0 +1,52 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+#include "scripter/NativeModule.h"
+
+namespace scripter { namespace modules {
+
+    /**
+     * VecMath
+     *
+     * Math over whole Float32Array, Float64Array and Int32Array arrays with
+     * the vector instructions of the cpu, the arrays are changed in place.
+     *
+     * axpy and scale compute in the element type of the array. The scalar
+     * of a Float32Array is rounded to a float and every step is rounded to a
+     * float, where a javascript loop computes in doubles and only rounds on
+     * store, so the results can differ in the last bit. The scalar of an
+     * Int32Array has to be an int32 and the math wraps around
+     */
+    class VecMath : public NativeModule
+    {
+    public:
+        VecMath(Engine* engine);
+        ~VecMath();
+
+        virtual String GetPackageName() override;
+    };
+
+}} // namespace scripter::modules
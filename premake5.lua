@@ -58,6 +58,32 @@ project "TestProgram"
     defines { "NDEBUG" }
     optimize "On"
 
+project "scripter-compile"
+  kind "ConsoleApp"
+  
+  language "C++"
+  cppdialect "C++17"
+
+  targetdir "bin/%{cfg.buildcfg}"
+  objdir "bin/%{cfg.buildcfg}/obj/%{prj.name}"
+
+  files { "src/compiler/**.h", "src/compiler/**.cpp" }
+
+  filter "system:linux"
+    toolset "clang"
+    includedirs { "include/", "vendor/v8/include", "vendor/spdlog/include" }
+    links { "Scripter", "dl" }
+    buildoptions { "-Wall", "-Wextra", "-Wno-unused-parameter", "-Wno-unused-result"}
+    defines { "SCRIPTER_PLATFORM_LINUX" }
+
+  filter "configurations:Debug"
+    defines { "DEBUG" }
+    symbols "On"
+
+  filter "configurations:Release"
+    defines { "NDEBUG" }
+    optimize "On"
+
 project "Test"
   kind "SharedLib"
   
@@ -0,0 +1,102 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <scripter/Logger.h>
+#include <scripter/Engine.h>
+#include <scripter/ScriptEnv.h>
+#include <scripter/Bundle.h>
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace scripter;
+
+static void PrintUsage(const char* program)
+{
+    printf("Usage: %s [options] <root script> -o <output>\n", program);
+    printf("Options:\n");
+    printf("  -o <output>  The bundle file to write\n");
+    printf("  --module     The root script is a ES6 module\n");
+}
+
+int main(int argc, const char** argv)
+{
+    String rootPath;
+    String outputPath;
+    bool isModule = false;
+
+    for (int32 i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--module") == 0)
+        {
+            isModule = true;
+        }
+        else if (argv[i][0] != '-' && rootPath.empty())
+        {
+            rootPath = argv[i];
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (rootPath.empty() || outputPath.empty())
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    Engine::InitializeV8(argv[0]);
+
+    Engine* engine = new Engine();
+    v8::Isolate* isolate = engine->GetIsolate();
+
+    bool result = false;
+
+    engine->StartIsolate();
+    {
+        v8::HandleScope handleScope(isolate);
+
+        // NOTE(patrik): Nothing is run, the context is only there so compile
+        // errors can be reported
+        ScriptEnv env(engine);
+        env.Enable();
+
+        BundleWriter writer(engine);
+        result = writer.AddRoot(rootPath, isModule) && writer.Write(outputPath);
+
+        env.Disable();
+    }
+    engine->EndIsolate();
+
+    delete engine;
+    Engine::DeinitializeV8();
+
+    return result ? 0 : 1;
+}
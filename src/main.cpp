@@ -24,14 +24,39 @@
 #include <scripter/Logger.h>
 #include <scripter/Engine.h>
 #include <scripter/ScriptEnv.h>
+#include <scripter/Tracing.h>
 
 #include <scripter/modules/System.h>
 #include <scripter/modules/Console.h>
 
+#include <string.h>
+
 using namespace scripter;
 
 int main(int argc, const char** argv)
 {
+    // NOTE(patrik): --cpu-profile <path> writes a .cpuprofile of the run,
+    // --trace <path> writes a Chrome trace of the whole program and
+    // --script <path> runs the main function of another script ex.
+    // tests/vecmathBench.js
+    const char* cpuProfilePath = nullptr;
+    const char* scriptPath = "tests/test.js";
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--cpu-profile") == 0 && i + 1 < argc)
+        {
+            cpuProfilePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            Tracer::Start(argv[++i], "v8");
+        }
+        else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc)
+        {
+            scriptPath = argv[++i];
+        }
+    }
+
     Engine::InitializeV8(argv[0]);
 
     Engine* engine = new Engine();
@@ -53,13 +78,27 @@ int main(int argc, const char** argv)
         env.ImportModule(systemModule);
         env.ImportModule(consoleModule);
 
-        env.CompileAndRun("tests/test.js");
+        if (cpuProfilePath)
+            engine->StartProfiling("TestProgram");
+
+        engine->PrefetchScripts(scriptPath, false);
+        env.CompileAndRun(scriptPath);
 
         auto function = env.GetFunction("main").ToLocalChecked();
 
         function->Call(v8::Null(isolate), 0, {});
         engine->CheckTryCatch(&tryCatch);
 
+        env.CompileAndRunModule("tests/moduleTest.js");
+
+        // NOTE(patrik): Runs the tasks V8 queued while the scripts ran
+        while (engine->RunPendingTasks())
+        {
+        }
+
+        if (cpuProfilePath)
+            engine->StopProfiling("TestProgram", cpuProfilePath);
+
         env.Disable();
 
         delete systemModule;
@@ -0,0 +1,424 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/Bundle.h"
+
+#include "scripter/Logger.h"
+#include "scripter/ModuleGraph.h"
+#include "scripter/ModulePrefetcher.h"
+#include "scripter/ScriptEnv.h"
+
+#include "scripter/utils/File.h"
+#include "scripter/utils/Path.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace scripter {
+
+    static const char s_BundleMagic[8] = {'S', 'C', 'R', 'B', 'N', 'D', 'L', 0};
+
+    static uint64 Align(uint64 offset, uint64 alignment)
+    {
+        return (offset + alignment - 1) & ~(alignment - 1);
+    }
+
+    static String GetRelativePath(const String& path, const String& base)
+    {
+        String directory = base;
+        String prefix;
+
+        while (!directory.empty() && directory != "/")
+        {
+            if (path.compare(0, directory.length(), directory) == 0 &&
+                path.length() > directory.length() &&
+                path[directory.length()] == '/')
+            {
+                return prefix + path.substr(directory.length() + 1);
+            }
+
+            directory = Path::GetDirectoryPath(directory);
+            prefix.append("../");
+        }
+
+        return prefix + path.substr(1);
+    }
+
+    /**
+     * Returns true if the range is inside the file, the offset and the
+     * length are checked one by one so a bad bundle can't wrap the sum
+     */
+    static bool IsInFile(uint64 offset, uint64 length, size_t size)
+    {
+        return offset <= size && length <= size - offset;
+    }
+
+    Bundle::Bundle(void* data, size_t size)
+        : m_Data(data), m_Size(size), m_CodeCacheValid(false)
+    {
+    }
+
+    Bundle::~Bundle()
+    {
+        if (m_Data)
+        {
+            munmap(m_Data, m_Size);
+            m_Data = nullptr;
+        }
+    }
+
+    const Bundle::Entry* Bundle::Find(const String& path) const
+    {
+        auto it = m_Entries.find(path);
+        if (it == m_Entries.end())
+            return nullptr;
+
+        return &it->second;
+    }
+
+    Bundle* Bundle::Open(const String& path)
+    {
+        String fullPath = Path::GetFullPath(path);
+
+        int32 fd = open(fullPath.c_str(), O_RDONLY);
+        if (fd == -1)
+        {
+            SCRIPTER_LOG_ERROR("Could not open bundle '{0}'", path);
+            return nullptr;
+        }
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) == -1 ||
+            (size_t)fileStat.st_size < sizeof(Header))
+        {
+            SCRIPTER_LOG_ERROR("Bundle '{0}' is too small", path);
+            close(fd);
+            return nullptr;
+        }
+
+        size_t size = (size_t)fileStat.st_size;
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if (data == MAP_FAILED)
+        {
+            SCRIPTER_LOG_ERROR("Could not map bundle '{0}': {1}", path,
+                               strerror(errno));
+            return nullptr;
+        }
+
+        Bundle* bundle = new Bundle(data, size);
+
+        const uint8* base = (const uint8*)data;
+        const Header* header = (const Header*)base;
+
+        if (memcmp(header->magic, s_BundleMagic, sizeof(s_BundleMagic)) != 0 ||
+            header->formatVersion != FORMAT_VERSION)
+        {
+            SCRIPTER_LOG_ERROR("'{0}' is not a valid bundle", path);
+            delete bundle;
+            return nullptr;
+        }
+
+        uint64 indexSize = (uint64)header->entryCount * sizeof(IndexEntry);
+        if (!IsInFile(header->indexOffset, indexSize, size))
+        {
+            SCRIPTER_LOG_ERROR("Bundle '{0}' is truncated", path);
+            delete bundle;
+            return nullptr;
+        }
+
+        // NOTE(patrik): The sources are still usable if the code caches are
+        // from another V8 version, V8 would reject them anyway
+        String v8Version(header->v8Version,
+                         strnlen(header->v8Version, sizeof(header->v8Version)));
+        bundle->m_CodeCacheValid =
+            header->flagsHash == v8::ScriptCompiler::CachedDataVersionTag() &&
+            v8Version == v8::V8::GetVersion();
+
+        if (!bundle->m_CodeCacheValid)
+        {
+            SCRIPTER_LOG_WARNING("Bundle '{0}' was compiled with V8 {1}, "
+                                 "ignoring the code caches",
+                                 path, v8Version);
+        }
+
+        String directory = Path::GetDirectoryPath(fullPath);
+
+        const IndexEntry* index =
+            (const IndexEntry*)(base + header->indexOffset);
+        for (uint32 i = 0; i < header->entryCount; i++)
+        {
+            const IndexEntry& indexEntry = index[i];
+            if (!IsInFile(indexEntry.pathOffset, indexEntry.pathLength, size) ||
+                !IsInFile(indexEntry.sourceOffset, indexEntry.sourceLength,
+                          size) ||
+                !IsInFile(indexEntry.codeCacheOffset,
+                          indexEntry.codeCacheLength, size))
+            {
+                SCRIPTER_LOG_ERROR("Bundle '{0}' is truncated", path);
+                delete bundle;
+                return nullptr;
+            }
+
+            String entryPath((const char*)base + indexEntry.pathOffset,
+                             indexEntry.pathLength);
+
+            Entry entry = {};
+            entry.source = (const char*)base + indexEntry.sourceOffset;
+            entry.sourceLength = indexEntry.sourceLength;
+            entry.codeCache = base + indexEntry.codeCacheOffset;
+            entry.codeCacheLength = indexEntry.codeCacheLength;
+            entry.isModule = indexEntry.isModule != 0;
+
+            if (!bundle->m_CodeCacheValid)
+                entry.codeCacheLength = 0;
+
+            bundle->m_Entries[Path::Normalize(
+                Path::Append(directory, entryPath))] = entry;
+        }
+
+        SCRIPTER_LOG_INFO("Loaded bundle '{0}' with {1} scripts", path,
+                          bundle->m_Entries.size());
+
+        return bundle;
+    }
+
+    BundleWriter::BundleWriter(Engine* engine) : m_Engine(engine) {}
+
+    BundleWriter::~BundleWriter() {}
+
+    bool BundleWriter::AddRoot(const String& path, bool isModule)
+    {
+        String fullPath = Path::GetFullPath(path);
+        if (fullPath.empty())
+        {
+            SCRIPTER_LOG_ERROR("Could not find '{0}'", path);
+            return false;
+        }
+
+        return AddScript(fullPath, isModule);
+    }
+
+    bool BundleWriter::Write(const String& outputPath)
+    {
+        Bundle::Header header = {};
+        memcpy(header.magic, s_BundleMagic, sizeof(s_BundleMagic));
+        header.formatVersion = Bundle::FORMAT_VERSION;
+        header.flagsHash = v8::ScriptCompiler::CachedDataVersionTag();
+        strncpy(header.v8Version, v8::V8::GetVersion(),
+                sizeof(header.v8Version) - 1);
+        header.entryCount = (uint32)m_Items.size();
+        header.indexOffset = Align(sizeof(Bundle::Header), 16);
+
+        // NOTE(patrik): Open resolves the paths against the canonical
+        // directory of the bundle so they're stored relative to the same
+        String directory = Path::GetDirectoryPath(
+            Path::GetAbsolutePath(outputPath));
+        String fullDirectory = Path::GetFullPath(directory);
+        if (!fullDirectory.empty())
+            directory = fullDirectory;
+
+        std::vector<Bundle::IndexEntry> index(m_Items.size());
+        std::vector<String> paths(m_Items.size());
+
+        uint64 offset =
+            header.indexOffset + m_Items.size() * sizeof(Bundle::IndexEntry);
+
+        for (size_t i = 0; i < m_Items.size(); i++)
+        {
+            const Item& item = m_Items[i];
+            Bundle::IndexEntry& entry = index[i];
+
+            paths[i] = GetRelativePath(item.path, directory);
+
+            offset = Align(offset, 8);
+            entry.pathOffset = offset;
+            entry.pathLength = (uint32)paths[i].length();
+            offset += entry.pathLength;
+
+            offset = Align(offset, 16);
+            entry.sourceOffset = offset;
+            entry.sourceLength = item.source.length();
+            offset += entry.sourceLength;
+
+            offset = Align(offset, 16);
+            entry.codeCacheOffset = offset;
+            entry.codeCacheLength = item.codeCache.size();
+            offset += entry.codeCacheLength;
+
+            entry.isModule = item.isModule ? 1 : 0;
+        }
+
+        std::vector<uint8> buffer(offset, 0);
+        memcpy(buffer.data(), &header, sizeof(header));
+        memcpy(buffer.data() + header.indexOffset, index.data(),
+               index.size() * sizeof(Bundle::IndexEntry));
+
+        for (size_t i = 0; i < m_Items.size(); i++)
+        {
+            const Item& item = m_Items[i];
+            const Bundle::IndexEntry& entry = index[i];
+
+            memcpy(buffer.data() + entry.pathOffset, paths[i].data(),
+                   entry.pathLength);
+            memcpy(buffer.data() + entry.sourceOffset, item.source.data(),
+                   entry.sourceLength);
+            memcpy(buffer.data() + entry.codeCacheOffset,
+                   item.codeCache.data(), entry.codeCacheLength);
+        }
+
+        FILE* file = fopen(outputPath.c_str(), "wb");
+        if (!file)
+        {
+            SCRIPTER_LOG_ERROR("Could not open '{0}' for writing", outputPath);
+            return false;
+        }
+
+        size_t written = fwrite(buffer.data(), 1, buffer.size(), file);
+        fclose(file);
+
+        if (written != buffer.size())
+        {
+            SCRIPTER_LOG_ERROR("Could not write the bundle '{0}'", outputPath);
+            return false;
+        }
+
+        SCRIPTER_LOG_INFO("Wrote bundle '{0}' with {1} scripts ({2} bytes)",
+                          outputPath, m_Items.size(), buffer.size());
+
+        return true;
+    }
+
+    bool BundleWriter::AddScript(const String& path, bool isModule)
+    {
+        if (m_Added.find(path) != m_Added.end())
+            return true;
+
+        m_Added.insert(path);
+
+        if (!File::Exists(path))
+        {
+            SCRIPTER_LOG_ERROR("Could not find '{0}'", path);
+            return false;
+        }
+
+        Item item;
+        item.path = path;
+        item.source = File::ReadFile(path);
+        item.isModule = isModule;
+
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+        v8::HandleScope handleScope(isolate);
+        v8::TryCatch tryCatch(isolate);
+
+        v8::ScriptOrigin origin(
+            m_Engine->CreateString(path),
+            v8::Local<v8::Integer>(),         // resource_line_offset
+            v8::Local<v8::Integer>(),         // resource_column_offset
+            v8::False(isolate),               // resource_is_shared_cross_origin
+            v8::Local<v8::Integer>(),         // script_id
+            v8::Local<v8::Value>(),           // source_map_url
+            v8::False(isolate),               // resource_is_opaque
+            v8::False(isolate),               // is_wasm
+            v8::Boolean::New(isolate, isModule), // is_module
+            v8::Local<v8::PrimitiveArray>()); // host_defined_options
+
+        v8::ScriptCompiler::Source source(m_Engine->CreateString(item.source),
+                                          origin);
+
+        v8::ScriptCompiler::CachedData* cachedData = nullptr;
+        if (isModule)
+        {
+            v8::Local<v8::Module> module;
+            if (!v8::ScriptCompiler::CompileModule(isolate, &source)
+                     .ToLocal(&module))
+            {
+                m_Engine->CheckTryCatch(&tryCatch);
+                return false;
+            }
+
+            cachedData = v8::ScriptCompiler::CreateCodeCache(
+                module->GetUnboundModuleScript());
+        }
+        else
+        {
+            v8::Local<v8::UnboundScript> script;
+            if (!v8::ScriptCompiler::CompileUnboundScript(isolate, &source)
+                     .ToLocal(&script))
+            {
+                m_Engine->CheckTryCatch(&tryCatch);
+                return false;
+            }
+
+            cachedData = v8::ScriptCompiler::CreateCodeCache(script);
+        }
+
+        if (cachedData)
+        {
+            item.codeCache.assign(cachedData->data,
+                                  cachedData->data + cachedData->length);
+            delete cachedData;
+        }
+
+        std::vector<String> moduleImports;
+        std::vector<String> scriptImports;
+        ModulePrefetcher::ScanImports(item.source, &moduleImports,
+                                      &scriptImports);
+
+        m_Items.push_back(std::move(item));
+
+        bool result = true;
+        for (const String& specifier : moduleImports)
+        {
+            String modulePath = ModuleGraph::ResolvePath(specifier, path);
+            if (modulePath.empty())
+            {
+                SCRIPTER_LOG_WARNING("Could not resolve '{0}' in '{1}'",
+                                     specifier, path);
+                continue;
+            }
+
+            result &= AddScript(modulePath, true);
+        }
+
+        String directory = Path::GetDirectoryPath(path);
+        for (const String& name : scriptImports)
+        {
+            String scriptPath = Path::Append(directory, name);
+            scriptPath.append(".js");
+
+            // NOTE(patrik): Native modules can't be bundled
+            if (File::Exists(scriptPath))
+                result &= AddScript(Path::GetFullPath(scriptPath), false);
+        }
+
+        return result;
+    }
+
+} // namespace scripter
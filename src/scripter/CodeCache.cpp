@@ -0,0 +1,92 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/CodeCache.h"
+
+#include <string.h>
+
+#include <functional>
+#include <string_view>
+
+namespace scripter {
+
+    CodeCache::CodeCache() {}
+    CodeCache::~CodeCache() {}
+
+    v8::ScriptCompiler::CachedData* CodeCache::Get(const String& path,
+                                                   uint64 sourceHash)
+    {
+        auto it = m_Entries.find(path);
+        if (it == m_Entries.end() || it->second.sourceHash != sourceHash)
+            return nullptr;
+
+        // NOTE(patrik): The entry can be replaced while V8 still reads the
+        // data so the cached data gets its own copy of the buffer
+        const std::vector<uint8>& data = it->second.data;
+        uint8* buffer = new uint8[data.size()];
+        memcpy(buffer, data.data(), data.size());
+
+        return new v8::ScriptCompiler::CachedData(
+            buffer, (int)data.size(),
+            v8::ScriptCompiler::CachedData::BufferOwned);
+    }
+
+    void CodeCache::Store(const String& path, uint64 sourceHash,
+                          v8::ScriptCompiler::CachedData* cachedData)
+    {
+        if (!cachedData)
+            return;
+
+        Entry& entry = m_Entries[path];
+        entry.sourceHash = sourceHash;
+        entry.data.assign(cachedData->data,
+                          cachedData->data + cachedData->length);
+
+        delete cachedData;
+    }
+
+    void CodeCache::Invalidate(const String& path) { m_Entries.erase(path); }
+
+    void CodeCache::Clear() { m_Entries.clear(); }
+
+    size_t CodeCache::GetMemoryUsage() const
+    {
+        size_t result = 0;
+        for (const auto& it : m_Entries)
+            result += it.second.data.size();
+
+        return result;
+    }
+
+    uint64 CodeCache::HashSource(const String& source)
+    {
+        return std::hash<String>()(source);
+    }
+
+    uint64 CodeCache::HashSource(const char* source, size_t length)
+    {
+        // NOTE(patrik): Gives the same hash as the string version
+        return std::hash<std::string_view>()(std::string_view(source, length));
+    }
+
+} // namespace scripter
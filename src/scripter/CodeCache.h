@@ -0,0 +1,90 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+
+#include <unordered_map>
+#include <vector>
+
+#include <v8.h>
+
+namespace scripter {
+
+    /**
+     * CodeCache
+     *
+     * Holds the V8 code cache for compiled scripts and modules keyed by the
+     * absolute path, an entry is only used if the source hash still matches
+     */
+    class CodeCache
+    {
+    private:
+        struct Entry
+        {
+            uint64 sourceHash;
+            std::vector<uint8> data;
+        };
+
+        std::unordered_map<String, Entry> m_Entries;
+
+    public:
+        CodeCache();
+        ~CodeCache();
+
+        /**
+         * Returns a new cached data object that can be passed to a
+         * ScriptCompiler::Source or nullptr if there's no valid entry, the
+         * returned object owns a copy of the buffer
+         */
+        v8::ScriptCompiler::CachedData* Get(const String& path,
+                                            uint64 sourceHash);
+
+        /**
+         * Stores the cached data for a path, takes the ownership of the
+         * cached data
+         */
+        void Store(const String& path, uint64 sourceHash,
+                   v8::ScriptCompiler::CachedData* cachedData);
+
+        /**
+         * Removes the entry for a path
+         */
+        void Invalidate(const String& path);
+
+        /**
+         * Removes all the entries
+         */
+        void Clear();
+
+        /**
+         * Returns the number of bytes of cached data held
+         */
+        size_t GetMemoryUsage() const;
+
+        static uint64 HashSource(const String& source);
+        static uint64 HashSource(const char* source, size_t length);
+    };
+
+} // namespace scripter
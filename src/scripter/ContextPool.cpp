@@ -0,0 +1,136 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/ContextPool.h"
+
+#include "scripter/Logger.h"
+
+#include <algorithm>
+
+namespace scripter {
+
+    ContextPool::ContextPool(Engine* engine, int32 size) : m_Engine(engine)
+    {
+        SCRIPTER_ASSERT(engine);
+
+        m_Engine->AddContextPool(this);
+
+        m_Envs.reserve(size);
+        m_Available.reserve(size);
+
+        for (int32 i = 0; i < size; i++)
+        {
+            m_Available.push_back(CreateEnv());
+        }
+    }
+
+    ContextPool::~ContextPool()
+    {
+        m_Engine->RemoveContextPool(this);
+
+        for (ScriptEnv* env : m_Envs)
+        {
+            delete env;
+        }
+
+        m_Envs.clear();
+        m_Available.clear();
+    }
+
+    void ContextPool::AddModule(Module* module)
+    {
+        SCRIPTER_ASSERT(module);
+
+        m_Modules.push_back(module);
+
+        v8::HandleScope handleScope(m_Engine->GetIsolate());
+        for (ScriptEnv* env : m_Available)
+        {
+            env->Enable();
+            env->ImportModule(module);
+            env->Disable();
+        }
+    }
+
+    ScriptEnv* ContextPool::Acquire()
+    {
+        if (m_Available.empty())
+        {
+            SCRIPTER_LOG_WARNING(
+                "ContextPool::Acquire: Pool is empty, creating a new context");
+            return CreateEnv();
+        }
+
+        ScriptEnv* env = m_Available.back();
+        m_Available.pop_back();
+
+        return env;
+    }
+
+    void ContextPool::Release(ScriptEnv* env)
+    {
+        SCRIPTER_ASSERT(env);
+        SCRIPTER_ASSERT(std::find(m_Envs.begin(), m_Envs.end(), env) !=
+                            m_Envs.end(),
+                        "The script environment is not from this pool");
+
+        env->Reset();
+        ImportModules(env);
+
+        m_Available.push_back(env);
+    }
+
+    void ContextPool::Shrink(size_t keepCount)
+    {
+        while (m_Available.size() > keepCount)
+        {
+            ScriptEnv* env = m_Available.back();
+            m_Available.pop_back();
+
+            m_Envs.erase(std::find(m_Envs.begin(), m_Envs.end(), env));
+            delete env;
+        }
+    }
+
+    ScriptEnv* ContextPool::CreateEnv()
+    {
+        ScriptEnv* env = new ScriptEnv(m_Engine);
+        ImportModules(env);
+
+        m_Envs.push_back(env);
+        return env;
+    }
+
+    void ContextPool::ImportModules(ScriptEnv* env)
+    {
+        v8::HandleScope handleScope(m_Engine->GetIsolate());
+
+        env->Enable();
+        for (Module* module : m_Modules)
+        {
+            env->ImportModule(module);
+        }
+        env->Disable();
+    }
+
+} // namespace scripter
@@ -24,33 +24,261 @@
 
 #include "scripter/Engine.h"
 
+#include "scripter/CodeCache.h"
+#include "scripter/ContextPool.h"
 #include "scripter/Logger.h"
+#include "scripter/ModuleGraph.h"
+#include "scripter/JavascriptModuleImporter.h"
+#include "scripter/MemoryProfiler.h"
+#include "scripter/Metrics.h"
+#include "scripter/ModulePrefetcher.h"
+#include "scripter/ModuleRegistry.h"
+#include "scripter/NativeModule.h"
 #include "scripter/NativeModuleImporter.h"
+#include "scripter/Platform.h"
+#include "scripter/Profiler.h"
+#include "scripter/ScriptError.h"
+#include "scripter/Tracing.h"
+
+#include "scripter/utils/FileCache.h"
+
+#include <algorithm>
 
 namespace scripter {
 
-    std::unique_ptr<v8::Platform> Engine::s_Platform;
+    std::unique_ptr<Platform> Engine::s_Platform;
 
     Engine::Engine()
     {
+        SCRIPTER_TRACE_SCOPE("Engine::CreateIsolate");
+
         m_IsolateCreateParams.array_buffer_allocator =
             v8::ArrayBuffer::Allocator::NewDefaultAllocator();
         m_Isolate = v8::Isolate::New(m_IsolateCreateParams);
 
         m_Isolate->SetData(0, this);
-        m_Isolate->SetCaptureStackTraceForUncaughtExceptions(true);
+        m_StackTraceDepth = 10;
+        m_Isolate->SetCaptureStackTraceForUncaughtExceptions(true,
+                                                             m_StackTraceDepth);
+        m_Isolate->SetHostImportModuleDynamicallyCallback(
+            ModuleGraph::ImportModuleDynamically);
+
+        m_CodeCache = new CodeCache();
+        m_ModulePrefetcher = nullptr;
+        m_ModuleRegistry = new ModuleRegistry();
+        m_Profiler = nullptr;
+        m_MemoryProfiler = nullptr;
+        m_Metrics = new Metrics(this);
+        m_NativeCallStats = false;
+        m_LastError = new ScriptError(this);
+        m_HasLastError = false;
+        m_LogScriptErrors = true;
     }
 
     Engine::~Engine()
     {
+        // NOTE(patrik): The modules hold handles so they need to be deleted
+        // before the isolate
+        delete m_ModuleRegistry;
+        delete m_ModulePrefetcher;
+        delete m_Profiler;
+        delete m_MemoryProfiler;
+        delete m_Metrics;
+        delete m_LastError;
+        delete m_CodeCache;
+
+        // NOTE(patrik): V8 can still ask for the task runner while it's
+        // disposed so the runner is dropped after, like d8 does
         m_Isolate->Dispose();
+        s_Platform->UnregisterIsolate(m_Isolate);
         delete m_IsolateCreateParams.array_buffer_allocator;
     }
 
     void Engine::StartIsolate() { m_Isolate->Enter(); }
 
+    bool Engine::RunPendingTasks()
+    {
+        return s_Platform->RunForegroundTasks(m_Isolate);
+    }
+
+    bool Engine::NotifyIdle(double deadlineInSeconds)
+    {
+        SCRIPTER_TRACE_SCOPE("Engine::NotifyIdle");
+
+        double idleTime =
+            deadlineInSeconds - s_Platform->MonotonicallyIncreasingTime();
+        if (idleTime <= 0.0)
+            return false;
+
+        bool tasksLeft = s_Platform->RunIdleTasks(m_Isolate, idleTime);
+
+        // NOTE(patrik): V8 does incremental marking and the other idle GC
+        // work with the time that is left after the idle tasks
+        bool gcDone = m_Isolate->IdleNotificationDeadline(deadlineInSeconds);
+
+        return gcDone && !tasksLeft;
+    }
+
+    void Engine::OnMemoryPressure(v8::MemoryPressureLevel level,
+                                  bool shrinkCaches)
+    {
+        SCRIPTER_TRACE_SCOPE("Engine::OnMemoryPressure");
+
+        if (shrinkCaches && level != v8::MemoryPressureLevel::kNone)
+        {
+            bool critical = level == v8::MemoryPressureLevel::kCritical;
+
+            for (ContextPool* pool : m_ContextPools)
+                pool->Shrink(critical ? 0 : pool->GetAvailableCount() / 2);
+
+            if (critical)
+            {
+                SCRIPTER_LOG_INFO("Critical memory pressure, dropping {0} "
+                                  "bytes of code cache",
+                                  m_CodeCache->GetMemoryUsage());
+
+                m_CodeCache->Clear();
+                m_ModuleRegistry->Purge();
+                FileCache::Clear();
+            }
+        }
+
+        // NOTE(patrik): Called after the pools are shrunk so the garbage
+        // collection V8 does here can collect the dropped contexts
+        m_Isolate->MemoryPressureNotification(level);
+    }
+
+    void Engine::AddContextPool(ContextPool* pool)
+    {
+        m_ContextPools.push_back(pool);
+    }
+
+    void Engine::RemoveContextPool(ContextPool* pool)
+    {
+        auto it = std::find(m_ContextPools.begin(), m_ContextPools.end(), pool);
+        if (it != m_ContextPools.end())
+            m_ContextPools.erase(it);
+    }
+
     void Engine::EndIsolate() { m_Isolate->Exit(); }
 
+    ModuleStats Engine::GetModuleStats() const
+    {
+        return m_ModuleRegistry->GetStats();
+    }
+
+    std::vector<NativeCallStats> Engine::GetNativeCallStats() const
+    {
+        std::vector<NativeCallStats> result;
+
+        for (Module* module : m_ModuleRegistry->GetModules())
+        {
+            NativeModule* nativeModule = dynamic_cast<NativeModule*>(module);
+            if (!nativeModule)
+                continue;
+
+            std::vector<NativeCallStats> stats = nativeModule->GetCallStats();
+            result.insert(result.end(), stats.begin(), stats.end());
+        }
+
+        return result;
+    }
+
+    void Engine::PrefetchScripts(const String& rootPath, bool isModule)
+    {
+        if (!m_ModulePrefetcher)
+        {
+            m_ModulePrefetcher =
+                new ModulePrefetcher(this, ThreadPool::GetDefaultThreadCount());
+        }
+
+        m_ModulePrefetcher->Prefetch(rootPath, isModule);
+    }
+
+    bool Engine::StartProfiling(const String& name, int32 samplingIntervalUs)
+    {
+        if (!m_Profiler)
+            m_Profiler = new Profiler(this);
+
+        return m_Profiler->Start(name, samplingIntervalUs);
+    }
+
+    bool Engine::StopProfiling(const String& name, const String& outputPath)
+    {
+        if (!m_Profiler)
+        {
+            SCRIPTER_LOG_WARNING("Profile '{0}' is not running", name);
+            return false;
+        }
+
+        return m_Profiler->Stop(name, outputPath);
+    }
+
+    void Engine::StartSamplingReport(int32 samplingIntervalUs,
+                                     int32 reportIntervalMs, int32 topCount)
+    {
+        if (!m_Profiler)
+            m_Profiler = new Profiler(this);
+
+        m_Profiler->StartSamplingReport(samplingIntervalUs, reportIntervalMs,
+                                        topCount);
+    }
+
+    void Engine::StopSamplingReport()
+    {
+        if (m_Profiler)
+            m_Profiler->StopSamplingReport();
+    }
+
+    void Engine::UpdateSamplingReport()
+    {
+        if (m_Profiler)
+            m_Profiler->UpdateSamplingReport();
+    }
+
+    bool Engine::WriteHeapSnapshot(const String& outputPath)
+    {
+        if (!m_MemoryProfiler)
+            m_MemoryProfiler = new MemoryProfiler(this);
+
+        return m_MemoryProfiler->WriteHeapSnapshot(outputPath);
+    }
+
+    bool Engine::StartSamplingHeapProfiler(uint64 sampleIntervalBytes,
+                                           int32 stackDepth)
+    {
+        if (!m_MemoryProfiler)
+            m_MemoryProfiler = new MemoryProfiler(this);
+
+        return m_MemoryProfiler->StartSampling(sampleIntervalBytes, stackDepth);
+    }
+
+    void Engine::StopSamplingHeapProfiler()
+    {
+        if (m_MemoryProfiler)
+            m_MemoryProfiler->StopSampling();
+    }
+
+    void Engine::LogAllocationProfile(int32 topCount)
+    {
+        if (!m_MemoryProfiler)
+        {
+            SCRIPTER_LOG_WARNING("The sampling heap profiler is not running");
+            return;
+        }
+
+        m_MemoryProfiler->LogAllocationProfile(topCount);
+    }
+
+    void Engine::SetHeapSnapshotThreshold(size_t heapBytes,
+                                          const String& outputPath)
+    {
+        if (!m_MemoryProfiler)
+            m_MemoryProfiler = new MemoryProfiler(this);
+
+        m_MemoryProfiler->SetSnapshotThreshold(heapBytes, outputPath);
+    }
+
     void Engine::ThrowException(const char* format, ...)
     {
         char buffer[1024] = {};
@@ -68,74 +296,31 @@ namespace scripter {
     {
         SCRIPTER_ASSERT(tryCatch);
 
-        if (tryCatch->HasCaught())
-        {
-            v8::Local<v8::Value> ex = tryCatch->Exception();
-            v8::Local<v8::Message> message = tryCatch->Message();
-            v8::Local<v8::StackTrace> stackTrace = message->GetStackTrace();
-
-            SCRIPTER_LOG_ERROR(
-                "------------ JAVASCRIPT EXCEPTION ------------");
-
-            if (stackTrace->GetFrameCount() > 1)
-            {
-                String functionName = ConvertValueToString(
-                    stackTrace->GetFrame(m_Isolate, 0)->GetFunctionName());
-                if (functionName != "")
-                {
-                    SCRIPTER_LOG_ERROR("Function - {0}", functionName);
-                }
-            }
-
-            SCRIPTER_LOG_ERROR(
-                "File - {0}:{1}:{2}",
-                ConvertValueToString(message->GetScriptResourceName()),
-                message->GetLineNumber(m_Isolate->GetCurrentContext())
-                    .ToChecked(),
-                message->GetStartColumn(m_Isolate->GetCurrentContext())
-                    .ToChecked());
+        if (!tryCatch->HasCaught())
+            return false;
 
-            SCRIPTER_LOG_ERROR(
-                "Code - {0}",
-                ConvertValueToString(
-                    message->GetSourceLine(m_Isolate->GetCurrentContext())
-                        .ToLocalChecked()));
+        // NOTE(patrik): Only the handles are stored here, the strings are
+        // converted if someone formats the error. The same error is reused
+        // so catching doesn't allocate
+        m_LastError->Set(tryCatch);
+        m_HasLastError = true;
 
-            SCRIPTER_LOG_ERROR("Message - {0}", ConvertValueToString(ex));
+        if (m_LogScriptErrors)
+            m_LastError->Log();
 
-            SCRIPTER_LOG_ERROR("-- Stacktrace --");
-            for (int i = 0; i < stackTrace->GetFrameCount(); i++)
-            {
-                v8::Local<v8::StackFrame> frame =
-                    stackTrace->GetFrame(m_Isolate, i);
-
-                std::string function =
-                    ConvertValueToString(frame->GetFunctionName());
-
-                std::string scriptName =
-                    ConvertValueToString(frame->GetScriptName());
-
-                int lineNumber = frame->GetLineNumber();
-                int columnNumber = frame->GetColumn();
-
-                if (function == "")
-                {
-                    SCRIPTER_LOG_ERROR("\tat {0}:{1}:{2}", scriptName,
-                                       lineNumber, columnNumber);
-                }
-                else
-                {
-                    SCRIPTER_LOG_ERROR("\tat {0} ({1}:{2}:{3})", function,
-                                       scriptName, lineNumber, columnNumber);
-                }
-            }
+        return true;
+    }
 
-            SCRIPTER_LOG_ERROR(
-                "----------------------------------------------");
+    void Engine::ClearLastError()
+    {
+        m_LastError->Clear();
+        m_HasLastError = false;
+    }
 
-            return true;
-        }
-        return false;
+    void Engine::SetStackTraceDepth(int32 depth)
+    {
+        m_StackTraceDepth = depth;
+        m_Isolate->SetCaptureStackTraceForUncaughtExceptions(depth > 0, depth);
     }
 
     void Engine::PrintObject(v8::Local<v8::Context> context,
@@ -184,37 +369,85 @@ namespace scripter {
             .ToLocalChecked();
     }
 
+    v8::MaybeLocal<v8::String> Engine::CreateString(const char* value,
+                                                    size_t length)
+    {
+        if (length > (size_t)v8::String::kMaxLength)
+            return v8::MaybeLocal<v8::String>();
+
+        return v8::String::NewFromUtf8(m_Isolate, value,
+                                       v8::NewStringType::kNormal, (int)length);
+    }
+
     String Engine::ConvertValueToString(v8::Local<v8::Value> string)
     {
         v8::String::Utf8Value value(m_Isolate, string);
         return String(*value);
     }
 
-    void Engine::InitializeV8(const char* execPath)
+    void Engine::InitializeV8(const char* execPath, const char* moduleManifest,
+                              const PlatformOptions& platformOptions)
     {
+        SCRIPTER_TRACE_SCOPE("Engine::InitializeV8");
+
+        // Initialize Logger
+        Logger::Initialize();
+
         // Initialize V8.
         v8::V8::InitializeICUDefaultLocation(execPath);
         v8::V8::InitializeExternalStartupData(execPath);
 
-        s_Platform = v8::platform::NewDefaultPlatform();
+        // NOTE(patrik): The tracing controller can only be given to the
+        // platform when it's created, it records nothing until
+        // Tracer::Start is called
+        s_Platform = std::make_unique<Platform>(
+            platformOptions.workerCount, platformOptions.pinWorkers,
+            Tracer::CreateTracingController());
         v8::V8::InitializePlatform(s_Platform.get());
         v8::V8::Initialize();
 
-        // Initialize NativeModuleImporter
+        // Initialize the module importers
         NativeModuleImporter::Initialize();
+        JavascriptModuleImporter::Initialize();
 
-        // Initialize Logger
-        Logger::Initialize();
+        if (moduleManifest)
+            NativeModuleImporter::Get()->PreloadManifest(moduleManifest);
+    }
+
+    void Engine::PostBackgroundTask(std::function<void()> task)
+    {
+        s_Platform->PostBackgroundTask(std::move(task));
+    }
+
+    double Engine::MonotonicallyIncreasingTime()
+    {
+        return s_Platform->MonotonicallyIncreasingTime();
+    }
+
+    FileCacheStats Engine::GetFileCacheStats()
+    {
+        return FileCache::GetStats();
+    }
+
+    void Engine::AddModuleSearchPath(const String& directory)
+    {
+        NativeModuleImporter::Get()->AddSearchPath(directory);
+        JavascriptModuleImporter::Get()->AddSearchPath(directory);
     }
 
     void Engine::DeinitializeV8()
     {
+        // Writes the trace if it's still recording
+        Tracer::ReleaseTracingController();
+
         // Deinitalize V8
         v8::V8::Dispose();
         v8::V8::ShutdownPlatform();
+        s_Platform.reset();
 
-        // Deinitalize NativeModuleImporter
+        // Deinitalize the module importers
         NativeModuleImporter::Deinitialize();
+        JavascriptModuleImporter::Deinitialize();
 
         // Deinitialize Logger
         Logger::Deinitialize();
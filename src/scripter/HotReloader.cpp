@@ -0,0 +1,127 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/HotReloader.h"
+
+#include "scripter/CodeCache.h"
+#include "scripter/Logger.h"
+#include "scripter/Tracing.h"
+
+#include "scripter/utils/FileCache.h"
+#include "scripter/utils/FileWatcher.h"
+#include "scripter/utils/Path.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace scripter {
+
+    HotReloader::HotReloader(Engine* engine) : m_Engine(engine)
+    {
+        SCRIPTER_ASSERT(engine);
+
+        m_Watcher = new FileWatcher();
+    }
+
+    HotReloader::~HotReloader() { delete m_Watcher; }
+
+    void HotReloader::AddEnv(ScriptEnv* env)
+    {
+        SCRIPTER_ASSERT(env);
+        SCRIPTER_ASSERT(env->GetEngine() == m_Engine);
+
+        m_Envs.push_back(env);
+        WatchSources();
+    }
+
+    void HotReloader::RemoveEnv(ScriptEnv* env)
+    {
+        auto it = std::find(m_Envs.begin(), m_Envs.end(), env);
+        if (it == m_Envs.end())
+            return;
+
+        m_Envs.erase(it);
+
+        // NOTE(patrik): The files can be loaded by the other environments
+        // too, those are still watched
+        std::unordered_set<String> usedPaths;
+        for (ScriptEnv* other : m_Envs)
+        {
+            for (const String& path : other->GetSourcePaths())
+                usedPaths.insert(path);
+        }
+
+        for (const String& path : env->GetSourcePaths())
+        {
+            if (usedPaths.find(path) == usedPaths.end())
+                m_Watcher->Unwatch(path);
+        }
+    }
+
+    int32 HotReloader::Update()
+    {
+        // NOTE(patrik): The scripts may have imported new files since the
+        // last update
+        WatchSources();
+
+        std::vector<String> changedPaths = m_Watcher->Poll();
+        if (changedPaths.empty())
+            return 0;
+
+        SCRIPTER_TRACE_SCOPE("HotReloader::Update");
+
+        // NOTE(patrik): A file that was moved in place can change where a
+        // link points
+        Path::ClearCache();
+
+        CodeCache* codeCache = m_Engine->GetCodeCache();
+        for (const String& path : changedPaths)
+        {
+            SCRIPTER_LOG_INFO("'{0}' changed", path);
+            codeCache->Invalidate(path);
+            FileCache::Invalidate(path);
+        }
+
+        for (ScriptEnv* env : m_Envs)
+        {
+            if (!env->Reload(changedPaths))
+                SCRIPTER_LOG_WARNING("Could not reload all the changed files");
+        }
+
+        // NOTE(patrik): A reloaded module can import files that weren't
+        // loaded before
+        WatchSources();
+
+        return (int32)changedPaths.size();
+    }
+
+    void HotReloader::WatchSources()
+    {
+        for (ScriptEnv* env : m_Envs)
+        {
+            for (const String& path : env->GetSourcePaths())
+                m_Watcher->Watch(path);
+        }
+    }
+
+} // namespace scripter
@@ -25,13 +25,11 @@
 
 namespace scripter {
 
-    JavascriptModule::JavascriptModule(
-        Engine* engine, const String& name,
-        v8::Persistent<v8::Object, v8::CopyablePersistentTraits<v8::Object>>
-            obj)
+    JavascriptModule::JavascriptModule(Engine* engine, const String& name,
+                                       v8::Local<v8::Object> obj)
         : Module(engine), m_Name(name)
     {
-        m_Object = obj;
+        m_Object.Reset(engine->GetIsolate(), obj);
     }
 
     JavascriptModule::~JavascriptModule() { m_Object.Reset(); }
@@ -45,4 +43,9 @@ namespace scripter {
 
     String JavascriptModule::GetPackageName() { return m_Name; }
 
+    size_t JavascriptModule::GetMemoryUsage()
+    {
+        return sizeof(JavascriptModule) + m_Name.capacity();
+    }
+
 } // namespace scripter
\ No newline at end of file
@@ -37,15 +37,15 @@ namespace scripter {
             m_Object;
 
     public:
-        JavascriptModule(
-            Engine* engine, const String& name,
-            v8::Persistent<v8::Object, v8::CopyablePersistentTraits<v8::Object>>
-                obj);
+        JavascriptModule(Engine* engine, const String& name,
+                         v8::Local<v8::Object> obj);
         ~JavascriptModule();
 
         virtual v8::Local<v8::Object> GenerateObject() override;
 
         virtual String GetPackageName() override;
+
+        virtual size_t GetMemoryUsage() override;
     };
 
 } // namespace scripter
\ No newline at end of file
@@ -25,21 +25,21 @@
 
 #include "scripter/Logger.h"
 
-#include "scripter/utils/File.h"
 #include "scripter/utils/Path.h"
 
 #include "scripter/ScriptEnv.h"
 #include "scripter/JavascriptModule.h"
-
-#include "scripter/modules/Console.h"
+#include "scripter/ModuleRegistry.h"
+#include "scripter/NativeModuleImporter.h"
 
 namespace scripter {
 
     struct ModuleExports
     {
     public:
-        std::vector<
-            v8::Persistent<v8::Value, v8::CopyablePersistentTraits<v8::Value>>>
+        std::vector<std::pair<
+            String,
+            v8::Persistent<v8::Value, v8::CopyablePersistentTraits<v8::Value>>>>
             exportedValues;
     };
 
@@ -53,10 +53,37 @@ namespace scripter {
 
         ModuleExports* exports =
             (ModuleExports*)v8::Local<v8::External>::Cast(args.Data())->Value();
-        // TODO(patrik): Change this
-        exports->exportedValues.push_back(
+
+        // NOTE(patrik): addExport(func) exports the function under its own
+        // name and addExport(name, value) exports any value
+        String name;
+        v8::Local<v8::Value> value;
+        if (args.Length() >= 2)
+        {
+            JS_CHECK_ARG(JS_TYPE_STRING, 0);
+
+            name = engine->ConvertValueToString(args[0]);
+            value = args[1];
+        }
+        else
+        {
+            JS_CHECK_ARG(JS_TYPE_FUNCTION, 0);
+
+            name = engine->ConvertValueToString(
+                v8::Local<v8::Function>::Cast(args[0])->GetName());
+            value = args[0];
+        }
+
+        if (name.empty())
+        {
+            engine->ThrowException("addExport: The export needs a name");
+            return;
+        }
+
+        exports->exportedValues.push_back(std::make_pair(
+            name,
             v8::Persistent<v8::Value, v8::CopyablePersistentTraits<v8::Value>>(
-                isolate, args[0]));
+                isolate, value)));
     }
 
     JavascriptModuleImporter* JavascriptModuleImporter::s_Instance;
@@ -68,17 +95,29 @@ namespace scripter {
                                                    const String& moduleName,
                                                    const String& scriptPath)
     {
-        // TODO(patrik): Make this search for other places
-        String directory = Path::GetDirectoryPath(scriptPath);
-        String modulePath = Path::Append(directory, moduleName);
-        modulePath.append(".js");
+        String modulePath = m_SearchPath.Find(
+            moduleName + ".js", Path::GetDirectoryPath(scriptPath));
+        if (modulePath.empty())
+            return nullptr;
 
-        if (File::Exists(modulePath))
-        {
-            return LoadModule(engine, modulePath);
-        }
+        // NOTE(patrik): The same file gives the same module instance
+        String key = "js:" + modulePath;
+
+        ModuleRegistry* registry = engine->GetModuleRegistry();
+        Module* module = registry->Acquire(key);
+        if (module)
+            return module;
 
-        return nullptr;
+        module = LoadModule(engine, modulePath);
+        if (!module)
+            return nullptr;
+
+        return registry->Add(key, module);
+    }
+
+    void JavascriptModuleImporter::AddSearchPath(const String& directory)
+    {
+        m_SearchPath.Add(directory);
     }
 
     Module* JavascriptModuleImporter::LoadModule(Engine* engine,
@@ -101,29 +140,32 @@ namespace scripter {
 
         env->SetGlobal("addExport", function);
 
-        modules::Console* console = new modules::Console(engine);
-        env->ImportModule(console);
+        // NOTE(patrik): The console object is created lazily so the module
+        // is taken from the registry to keep it alive with the engine
+        Module* console =
+            NativeModuleImporter::Get()->ImportModule(engine, "console");
+        if (console)
+        {
+            env->AddImportedModule(console);
+            env->ImportModule(console);
+        }
 
         env->CompileAndRun(modulePath);
 
-        v8::Local<v8::Function> addFunc = v8::Local<v8::Function>::Cast(
-            exports.exportedValues[0].Get(isolate));
-
         v8::Local<v8::Object> object = v8::Object::New(isolate);
 
-        // v8::Local<v8::Object> val = addFunc->();
-        if (addFunc->IsUndefined())
+        for (auto& exported : exports.exportedValues)
         {
-            SCRIPTER_LOG_ERROR("UNDEFINED");
+            object->Set(engine->CreateString(exported.first),
+                        exported.second.Get(isolate));
+            exported.second.Reset();
         }
 
-        object->Set(engine->CreateString("addFunc"), addFunc);
-
-        v8::Persistent<v8::Object> objectPresistent =
-            v8::Persistent<v8::Object>(isolate, object);
+        String moduleName = Path::GetFileName(modulePath);
+        moduleName = moduleName.substr(0, moduleName.find_last_of('.'));
 
         JavascriptModule* module =
-            new JavascriptModule(engine, "test", objectPresistent);
+            new JavascriptModule(engine, moduleName, object);
 
         env->Disable();
 
@@ -27,13 +27,20 @@
 
 #include "scripter/Module.h"
 
+#include "scripter/utils/SearchPath.h"
+
 namespace scripter {
 
     class JavascriptModuleImporter
     {
+    public:
+        friend class Engine;
+
     private:
         static JavascriptModuleImporter* s_Instance;
 
+        SearchPath m_SearchPath;
+
     private:
         JavascriptModuleImporter();
 
@@ -43,9 +50,18 @@ namespace scripter {
     public:
         static JavascriptModuleImporter* Get();
 
+        /**
+         * Finds and imports a javascript module, the directory of the
+         * importing script is searched before the search path
+         */
         Module* ImportModule(Engine* engine, const String& moduleName,
                              const String& scriptPath);
 
+        /**
+         * Adds a directory that is searched for the modules
+         */
+        void AddSearchPath(const String& directory);
+
     private:
         Module* LoadModule(Engine* engine, const String& modulePath);
 
@@ -0,0 +1,285 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/MemoryProfiler.h"
+
+#include "scripter/Engine.h"
+#include "scripter/Logger.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace scripter {
+
+    class FileOutputStream : public v8::OutputStream
+    {
+    private:
+        FILE* m_File;
+        bool m_Failed;
+
+    public:
+        FileOutputStream(FILE* file) : m_File(file), m_Failed(false) {}
+
+        virtual void EndOfStream() override {}
+
+        virtual int GetChunkSize() override { return 64 * 1024; }
+
+        virtual WriteResult WriteAsciiChunk(char* data, int size) override
+        {
+            if (fwrite(data, 1, size, m_File) != (size_t)size)
+            {
+                m_Failed = true;
+                return kAbort;
+            }
+
+            return kContinue;
+        }
+
+        bool HasFailed() const { return m_Failed; }
+    };
+
+    MemoryProfiler::MemoryProfiler(Engine* engine)
+        : m_Engine(engine), m_Sampling(false), m_SnapshotThreshold(0),
+          m_SnapshotRequested(false)
+    {
+    }
+
+    MemoryProfiler::~MemoryProfiler()
+    {
+        StopSampling();
+        SetSnapshotThreshold(0, "");
+    }
+
+    bool MemoryProfiler::WriteHeapSnapshot(const String& outputPath)
+    {
+        FILE* file = fopen(outputPath.c_str(), "wb");
+        if (!file)
+        {
+            SCRIPTER_LOG_ERROR("Could not open '{0}' for writing", outputPath);
+            return false;
+        }
+
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+        v8::HandleScope handleScope(isolate);
+
+        v8::HeapProfiler* heapProfiler = isolate->GetHeapProfiler();
+        const v8::HeapSnapshot* snapshot = heapProfiler->TakeHeapSnapshot();
+
+        FileOutputStream stream(file);
+        snapshot->Serialize(&stream, v8::HeapSnapshot::kJSON);
+        fclose(file);
+
+        // NOTE(patrik): The snapshot keeps a copy of the whole heap graph so
+        // it's deleted right away
+        const_cast<v8::HeapSnapshot*>(snapshot)->Delete();
+
+        if (stream.HasFailed())
+        {
+            SCRIPTER_LOG_ERROR("Could not write the heap snapshot '{0}'",
+                               outputPath);
+            return false;
+        }
+
+        SCRIPTER_LOG_INFO("Wrote heap snapshot '{0}'", outputPath);
+        return true;
+    }
+
+    bool MemoryProfiler::StartSampling(uint64 sampleIntervalBytes,
+                                       int32 stackDepth)
+    {
+        if (m_Sampling)
+            return true;
+
+        v8::HeapProfiler* heapProfiler =
+            m_Engine->GetIsolate()->GetHeapProfiler();
+        m_Sampling = heapProfiler->StartSamplingHeapProfiler(
+            sampleIntervalBytes, stackDepth);
+
+        return m_Sampling;
+    }
+
+    void MemoryProfiler::StopSampling()
+    {
+        if (!m_Sampling)
+            return;
+
+        m_Engine->GetIsolate()->GetHeapProfiler()->StopSamplingHeapProfiler();
+        m_Sampling = false;
+    }
+
+    void MemoryProfiler::LogAllocationProfile(int32 topCount)
+    {
+        if (!m_Sampling)
+        {
+            SCRIPTER_LOG_WARNING("The sampling heap profiler is not running");
+            return;
+        }
+
+        struct SiteBytes
+        {
+            String name;
+            String script;
+            int32 line;
+            size_t bytes;
+        };
+
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+        v8::HandleScope handleScope(isolate);
+
+        v8::AllocationProfile* profile =
+            isolate->GetHeapProfiler()->GetAllocationProfile();
+        if (!profile)
+            return;
+
+        std::unordered_map<String, SiteBytes> sites;
+        size_t totalBytes = 0;
+
+        std::vector<v8::AllocationProfile::Node*> stack;
+        stack.push_back(profile->GetRootNode());
+
+        while (!stack.empty())
+        {
+            v8::AllocationProfile::Node* node = stack.back();
+            stack.pop_back();
+
+            for (v8::AllocationProfile::Node* child : node->children)
+                stack.push_back(child);
+
+            size_t bytes = 0;
+            for (const v8::AllocationProfile::Allocation& allocation :
+                 node->allocations)
+            {
+                bytes += allocation.size * allocation.count;
+            }
+
+            if (bytes == 0)
+                continue;
+
+            totalBytes += bytes;
+
+            String name = m_Engine->ConvertValueToString(node->name);
+            if (name.empty())
+                name = "(anonymous)";
+
+            String script = m_Engine->ConvertValueToString(node->script_name);
+
+            String key =
+                name + "@" + script + ":" + std::to_string(node->line_number);
+            auto it = sites.find(key);
+            if (it == sites.end())
+                sites[key] = {name, script, node->line_number, bytes};
+            else
+                it->second.bytes += bytes;
+        }
+
+        delete profile;
+
+        if (totalBytes == 0)
+            return;
+
+        std::vector<SiteBytes> sorted;
+        sorted.reserve(sites.size());
+        for (auto& site : sites)
+            sorted.push_back(site.second);
+
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const SiteBytes& a, const SiteBytes& b) {
+                      return a.bytes > b.bytes;
+                  });
+
+        size_t count = std::min(sorted.size(), (size_t)topCount);
+
+        SCRIPTER_LOG_INFO("------------ ALLOCATION PROFILE ({0} KB live) "
+                          "------------",
+                          totalBytes / 1024);
+        for (size_t i = 0; i < count; i++)
+        {
+            const SiteBytes& site = sorted[i];
+
+            if (site.script.empty())
+            {
+                SCRIPTER_LOG_INFO("{0:>10} KB {1}", site.bytes / 1024,
+                                  site.name);
+            }
+            else
+            {
+                SCRIPTER_LOG_INFO("{0:>10} KB {1} ({2}:{3})",
+                                  site.bytes / 1024, site.name, site.script,
+                                  site.line);
+            }
+        }
+    }
+
+    void MemoryProfiler::SetSnapshotThreshold(size_t heapBytes,
+                                              const String& outputPath)
+    {
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+
+        if (m_SnapshotThreshold > 0)
+            isolate->RemoveGCEpilogueCallback(GCEpilogueCallback, this);
+
+        m_SnapshotThreshold = heapBytes;
+        m_SnapshotThresholdPath = outputPath;
+        m_SnapshotRequested = false;
+
+        if (m_SnapshotThreshold > 0)
+            isolate->AddGCEpilogueCallback(GCEpilogueCallback, this);
+    }
+
+    void MemoryProfiler::GCEpilogueCallback(v8::Isolate* isolate,
+                                            v8::GCType type,
+                                            v8::GCCallbackFlags flags,
+                                            void* data)
+    {
+        MemoryProfiler* profiler = (MemoryProfiler*)data;
+        if (profiler->m_SnapshotRequested)
+            return;
+
+        v8::HeapStatistics statistics;
+        isolate->GetHeapStatistics(&statistics);
+
+        if (statistics.used_heap_size() < profiler->m_SnapshotThreshold)
+            return;
+
+        // NOTE(patrik): The heap can't be walked from inside a GC callback,
+        // so the snapshot is written the next time V8 checks for interrupts
+        profiler->m_SnapshotRequested = true;
+        isolate->RequestInterrupt(SnapshotInterrupt, profiler);
+    }
+
+    void MemoryProfiler::SnapshotInterrupt(v8::Isolate* isolate, void* data)
+    {
+        MemoryProfiler* profiler = (MemoryProfiler*)data;
+        if (profiler->m_SnapshotThreshold == 0)
+            return;
+
+        SCRIPTER_LOG_WARNING("The heap usage went over {0} bytes, writing a "
+                             "heap snapshot to '{1}'",
+                             profiler->m_SnapshotThreshold,
+                             profiler->m_SnapshotThresholdPath);
+
+        profiler->WriteHeapSnapshot(profiler->m_SnapshotThresholdPath);
+    }
+
+} // namespace scripter
@@ -0,0 +1,83 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+
+#include <v8-profiler.h>
+#include <v8.h>
+
+namespace scripter {
+
+    class Engine;
+
+    /**
+     * MemoryProfiler
+     *
+     * Wrapper around V8's heap profiler, writes heap snapshots that can be
+     * opened in Chrome DevTools and reports the top allocation sites from the
+     * sampling heap profiler
+     */
+    class MemoryProfiler
+    {
+    private:
+        Engine* m_Engine;
+        bool m_Sampling;
+
+        size_t m_SnapshotThreshold;
+        String m_SnapshotThresholdPath;
+        bool m_SnapshotRequested;
+
+    public:
+        MemoryProfiler(Engine* engine);
+        ~MemoryProfiler();
+
+        /**
+         * Writes a snapshot of the heap in the .heapsnapshot format, the
+         * snapshot is streamed to the file while it's serialized
+         */
+        bool WriteHeapSnapshot(const String& outputPath);
+
+        bool StartSampling(uint64 sampleIntervalBytes, int32 stackDepth);
+        void StopSampling();
+
+        /**
+         * Logs the functions that allocated the most memory since the
+         * sampling started
+         */
+        void LogAllocationProfile(int32 topCount);
+
+        /**
+         * Writes a heap snapshot once the used heap size goes over the
+         * threshold, 0 disables the threshold
+         */
+        void SetSnapshotThreshold(size_t heapBytes, const String& outputPath);
+
+    private:
+        static void GCEpilogueCallback(v8::Isolate* isolate, v8::GCType type,
+                                       v8::GCCallbackFlags flags, void* data);
+        static void SnapshotInterrupt(v8::Isolate* isolate, void* data);
+    };
+
+} // namespace scripter
@@ -0,0 +1,403 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/Metrics.h"
+
+#include "scripter/Engine.h"
+#include "scripter/Logger.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace scripter {
+
+    static uint32 GetGCTypeIndex(v8::GCType type)
+    {
+        switch (type)
+        {
+            case v8::kGCTypeScavenge: return 0;
+            case v8::kGCTypeMarkSweepCompact: return 1;
+            case v8::kGCTypeIncrementalMarking: return 2;
+            case v8::kGCTypeProcessWeakCallbacks: return 3;
+            default: return 4;
+        }
+    }
+
+    static void AppendLine(String& out, const char* name, const String& labels,
+                           uint64 value)
+    {
+        out += name;
+        if (!labels.empty())
+            out += "{" + labels + "}";
+        out += " " + std::to_string(value) + "\n";
+    }
+
+    Histogram::Histogram() { Reset(); }
+
+    void Histogram::Record(uint64 value)
+    {
+        uint32 index = 0;
+        while (index < HistogramSnapshot::BUCKET_COUNT - 1 &&
+               (value >> index) != 0)
+        {
+            index++;
+        }
+
+        m_Buckets[index].fetch_add(1, std::memory_order_relaxed);
+        m_Count.fetch_add(1, std::memory_order_relaxed);
+        m_Sum.fetch_add(value, std::memory_order_relaxed);
+
+        uint64 max = m_Max.load(std::memory_order_relaxed);
+        while (value > max &&
+               !m_Max.compare_exchange_weak(max, value,
+                                            std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void Histogram::Reset()
+    {
+        for (uint32 i = 0; i < HistogramSnapshot::BUCKET_COUNT; i++)
+            m_Buckets[i].store(0, std::memory_order_relaxed);
+
+        m_Count.store(0, std::memory_order_relaxed);
+        m_Sum.store(0, std::memory_order_relaxed);
+        m_Max.store(0, std::memory_order_relaxed);
+    }
+
+    HistogramSnapshot Histogram::GetSnapshot() const
+    {
+        HistogramSnapshot snapshot = {};
+
+        for (uint32 i = 0; i < HistogramSnapshot::BUCKET_COUNT; i++)
+            snapshot.buckets[i] = m_Buckets[i].load(std::memory_order_relaxed);
+
+        snapshot.count = m_Count.load(std::memory_order_relaxed);
+        snapshot.sum = m_Sum.load(std::memory_order_relaxed);
+        snapshot.max = m_Max.load(std::memory_order_relaxed);
+
+        return snapshot;
+    }
+
+    uint64 Histogram::GetBucketBound(uint32 index)
+    {
+        if (index >= HistogramSnapshot::BUCKET_COUNT - 1)
+            return UINT64_MAX;
+
+        return ((uint64)1 << index) - 1;
+    }
+
+    Metrics::Metrics(Engine* engine)
+        : m_Engine(engine), m_TotalHeapSize(0), m_UsedHeapSize(0),
+          m_HeapSizeLimit(0), m_MallocedMemory(0), m_ExternalMemory(0)
+    {
+        v8::Isolate* isolate = engine->GetIsolate();
+
+        size_t spaceCount = isolate->NumberOfHeapSpaces();
+        for (size_t i = 0; i < spaceCount; i++)
+        {
+            v8::HeapSpaceStatistics statistics;
+            isolate->GetHeapSpaceStatistics(&statistics, i);
+
+            HeapSpace* space = new HeapSpace();
+            space->name = statistics.space_name();
+            space->size = 0;
+            space->used = 0;
+            space->available = 0;
+            space->physical = 0;
+            m_HeapSpaces.push_back(space);
+        }
+
+        isolate->AddGCPrologueCallback(GCPrologueCallback, this);
+        isolate->AddGCEpilogueCallback(GCEpilogueCallback, this);
+    }
+
+    Metrics::~Metrics()
+    {
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+        isolate->RemoveGCPrologueCallback(GCPrologueCallback, this);
+        isolate->RemoveGCEpilogueCallback(GCEpilogueCallback, this);
+
+        for (HeapSpace* space : m_HeapSpaces)
+            delete space;
+
+        m_HeapSpaces.clear();
+    }
+
+    void Metrics::SampleHeapStatistics()
+    {
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+
+        v8::HeapStatistics statistics;
+        isolate->GetHeapStatistics(&statistics);
+
+        m_TotalHeapSize.store(statistics.total_heap_size(),
+                              std::memory_order_relaxed);
+        m_UsedHeapSize.store(statistics.used_heap_size(),
+                             std::memory_order_relaxed);
+        m_HeapSizeLimit.store(statistics.heap_size_limit(),
+                              std::memory_order_relaxed);
+        m_MallocedMemory.store(statistics.malloced_memory(),
+                               std::memory_order_relaxed);
+        m_ExternalMemory.store(statistics.external_memory(),
+                               std::memory_order_relaxed);
+
+        for (size_t i = 0; i < m_HeapSpaces.size(); i++)
+        {
+            v8::HeapSpaceStatistics spaceStatistics;
+            if (!isolate->GetHeapSpaceStatistics(&spaceStatistics, i))
+                continue;
+
+            HeapSpace* space = m_HeapSpaces[i];
+            space->size.store(spaceStatistics.space_size(),
+                              std::memory_order_relaxed);
+            space->used.store(spaceStatistics.space_used_size(),
+                              std::memory_order_relaxed);
+            space->available.store(spaceStatistics.space_available_size(),
+                                   std::memory_order_relaxed);
+            space->physical.store(spaceStatistics.physical_space_size(),
+                                  std::memory_order_relaxed);
+        }
+    }
+
+    MetricsSnapshot Metrics::GetSnapshot() const
+    {
+        MetricsSnapshot snapshot = {};
+
+        for (uint32 i = 0; i < MetricsSnapshot::GC_TYPE_COUNT; i++)
+            snapshot.gcPauses[i] = m_GCPauses[i].GetSnapshot();
+
+        snapshot.totalHeapSize =
+            m_TotalHeapSize.load(std::memory_order_relaxed);
+        snapshot.usedHeapSize = m_UsedHeapSize.load(std::memory_order_relaxed);
+        snapshot.heapSizeLimit =
+            m_HeapSizeLimit.load(std::memory_order_relaxed);
+        snapshot.mallocedMemory =
+            m_MallocedMemory.load(std::memory_order_relaxed);
+        snapshot.externalMemory =
+            m_ExternalMemory.load(std::memory_order_relaxed);
+
+        for (HeapSpace* space : m_HeapSpaces)
+        {
+            HeapSpaceSnapshot spaceSnapshot;
+            spaceSnapshot.name = space->name;
+            spaceSnapshot.size = space->size.load(std::memory_order_relaxed);
+            spaceSnapshot.used = space->used.load(std::memory_order_relaxed);
+            spaceSnapshot.available =
+                space->available.load(std::memory_order_relaxed);
+            spaceSnapshot.physical =
+                space->physical.load(std::memory_order_relaxed);
+            snapshot.heapSpaces.push_back(spaceSnapshot);
+        }
+
+        return snapshot;
+    }
+
+    bool Metrics::WriteExposition(const String& outputPath) const
+    {
+        String text = FormatExposition(GetSnapshot());
+
+        FILE* file = fopen(outputPath.c_str(), "wb");
+        if (!file)
+        {
+            SCRIPTER_LOG_ERROR("Could not open '{0}' for writing", outputPath);
+            return false;
+        }
+
+        size_t written = fwrite(text.data(), 1, text.size(), file);
+        fclose(file);
+
+        if (written != text.size())
+        {
+            SCRIPTER_LOG_ERROR("Could not write the metrics '{0}'", outputPath);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool Metrics::WriteExpositionToSocket(const String& socketPath) const
+    {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path))
+        {
+            SCRIPTER_LOG_ERROR("The socket path '{0}' is too long", socketPath);
+            return false;
+        }
+        strcpy(address.sun_path, socketPath.c_str());
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd == -1)
+        {
+            SCRIPTER_LOG_ERROR("Could not create a socket: {0}",
+                               strerror(errno));
+            return false;
+        }
+
+        if (connect(fd, (sockaddr*)&address, sizeof(address)) == -1)
+        {
+            SCRIPTER_LOG_ERROR("Could not connect to '{0}': {1}", socketPath,
+                               strerror(errno));
+            close(fd);
+            return false;
+        }
+
+        String text = FormatExposition(GetSnapshot());
+
+        size_t offset = 0;
+        while (offset < text.size())
+        {
+            ssize_t result = send(fd, text.data() + offset,
+                                  text.size() - offset, MSG_NOSIGNAL);
+            if (result == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                SCRIPTER_LOG_ERROR("Could not write the metrics to '{0}': {1}",
+                                   socketPath, strerror(errno));
+                close(fd);
+                return false;
+            }
+
+            offset += result;
+        }
+
+        close(fd);
+        return true;
+    }
+
+    String Metrics::FormatExposition(const MetricsSnapshot& snapshot)
+    {
+        String out;
+
+        out += "# HELP scripter_gc_pause_microseconds Garbage collection "
+               "pauses\n";
+        out += "# TYPE scripter_gc_pause_microseconds histogram\n";
+        for (uint32 i = 0; i < MetricsSnapshot::GC_TYPE_COUNT; i++)
+        {
+            const HistogramSnapshot& pauses = snapshot.gcPauses[i];
+            String type = String("type=\"") + GetGCTypeName(i) + "\"";
+
+            // NOTE(patrik): The exposition format uses cumulative buckets
+            uint64 cumulative = 0;
+            for (uint32 j = 0; j < HistogramSnapshot::BUCKET_COUNT; j++)
+            {
+                cumulative += pauses.buckets[j];
+
+                uint64 bound = Histogram::GetBucketBound(j);
+                String le = bound == UINT64_MAX ? String("+Inf")
+                                                : std::to_string(bound);
+                AppendLine(out, "scripter_gc_pause_microseconds_bucket",
+                           type + ",le=\"" + le + "\"", cumulative);
+            }
+
+            AppendLine(out, "scripter_gc_pause_microseconds_sum", type,
+                       pauses.sum);
+            AppendLine(out, "scripter_gc_pause_microseconds_count", type,
+                       pauses.count);
+        }
+
+        out += "# TYPE scripter_heap_total_bytes gauge\n";
+        AppendLine(out, "scripter_heap_total_bytes", "",
+                   snapshot.totalHeapSize);
+        out += "# TYPE scripter_heap_used_bytes gauge\n";
+        AppendLine(out, "scripter_heap_used_bytes", "", snapshot.usedHeapSize);
+        out += "# TYPE scripter_heap_limit_bytes gauge\n";
+        AppendLine(out, "scripter_heap_limit_bytes", "",
+                   snapshot.heapSizeLimit);
+        out += "# TYPE scripter_malloced_bytes gauge\n";
+        AppendLine(out, "scripter_malloced_bytes", "", snapshot.mallocedMemory);
+        out += "# TYPE scripter_external_bytes gauge\n";
+        AppendLine(out, "scripter_external_bytes", "", snapshot.externalMemory);
+
+        out += "# TYPE scripter_heap_space_size_bytes gauge\n";
+        for (const HeapSpaceSnapshot& space : snapshot.heapSpaces)
+        {
+            AppendLine(out, "scripter_heap_space_size_bytes",
+                       "space=\"" + space.name + "\"", space.size);
+        }
+
+        out += "# TYPE scripter_heap_space_used_bytes gauge\n";
+        for (const HeapSpaceSnapshot& space : snapshot.heapSpaces)
+        {
+            AppendLine(out, "scripter_heap_space_used_bytes",
+                       "space=\"" + space.name + "\"", space.used);
+        }
+
+        out += "# TYPE scripter_heap_space_available_bytes gauge\n";
+        for (const HeapSpaceSnapshot& space : snapshot.heapSpaces)
+        {
+            AppendLine(out, "scripter_heap_space_available_bytes",
+                       "space=\"" + space.name + "\"", space.available);
+        }
+
+        out += "# TYPE scripter_heap_space_physical_bytes gauge\n";
+        for (const HeapSpaceSnapshot& space : snapshot.heapSpaces)
+        {
+            AppendLine(out, "scripter_heap_space_physical_bytes",
+                       "space=\"" + space.name + "\"", space.physical);
+        }
+
+        return out;
+    }
+
+    const char* Metrics::GetGCTypeName(uint32 index)
+    {
+        static const char* names[MetricsSnapshot::GC_TYPE_COUNT] = {
+            "scavenge", "mark_sweep_compact", "incremental_marking",
+            "process_weak_callbacks", "other"};
+
+        if (index >= MetricsSnapshot::GC_TYPE_COUNT)
+            return "unknown";
+
+        return names[index];
+    }
+
+    void Metrics::GCPrologueCallback(v8::Isolate* isolate, v8::GCType type,
+                                     v8::GCCallbackFlags flags, void* data)
+    {
+        Metrics* metrics = (Metrics*)data;
+        metrics->m_GCStart[GetGCTypeIndex(type)] =
+            std::chrono::steady_clock::now();
+    }
+
+    void Metrics::GCEpilogueCallback(v8::Isolate* isolate, v8::GCType type,
+                                     v8::GCCallbackFlags flags, void* data)
+    {
+        Metrics* metrics = (Metrics*)data;
+
+        uint32 index = GetGCTypeIndex(type);
+        auto pause = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - metrics->m_GCStart[index]);
+
+        metrics->m_GCPauses[index].Record(pause.count());
+        metrics->SampleHeapStatistics();
+    }
+
+} // namespace scripter
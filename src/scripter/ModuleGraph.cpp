@@ -0,0 +1,495 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/ModuleGraph.h"
+
+#include "scripter/CodeCache.h"
+#include "scripter/Logger.h"
+#include "scripter/ModulePrefetcher.h"
+#include "scripter/ScriptEnv.h"
+#include "scripter/Tracing.h"
+
+#include "scripter/utils/File.h"
+#include "scripter/utils/FileCache.h"
+#include "scripter/utils/Path.h"
+
+namespace scripter {
+
+    ModuleGraph::ModuleGraph(Engine* engine)
+        : m_Engine(engine), m_Bundle(nullptr)
+    {
+    }
+
+    ModuleGraph::~ModuleGraph() { Clear(); }
+
+    v8::MaybeLocal<v8::Module> ModuleGraph::Load(const String& modulePath)
+    {
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+        v8::EscapableHandleScope handleScope(isolate);
+
+        auto it = m_Modules.find(modulePath);
+        if (it != m_Modules.end())
+        {
+            return handleScope.Escape(it->second.Get(isolate));
+        }
+
+        CodeCache* codeCache = m_Engine->GetCodeCache();
+
+        v8::Local<v8::String> sourceString;
+        v8::ScriptCompiler::CachedData* cachedData = nullptr;
+        uint64 sourceHash = 0;
+
+        const Bundle::Entry* bundled =
+            m_Bundle ? m_Bundle->Find(modulePath) : nullptr;
+
+        if (bundled)
+        {
+            // NOTE(patrik): The code cache is used straight from the mapped
+            // bundle file
+            sourceString = v8::String::NewFromUtf8(isolate, bundled->source,
+                                                   v8::NewStringType::kNormal,
+                                                   (int)bundled->sourceLength)
+                               .ToLocalChecked();
+
+            if (bundled->codeCacheLength > 0)
+            {
+                cachedData = new v8::ScriptCompiler::CachedData(
+                    bundled->codeCache, (int)bundled->codeCacheLength,
+                    v8::ScriptCompiler::CachedData::BufferNotOwned);
+            }
+        }
+        else
+        {
+            ModulePrefetcher* prefetcher = m_Engine->GetModulePrefetcher();
+            std::unique_ptr<ModulePrefetcher::Entry> prefetched =
+                prefetcher ? prefetcher->Take(modulePath) : nullptr;
+
+            if (prefetched)
+            {
+                sourceString = m_Engine->CreateString(prefetched->source);
+                sourceHash = prefetched->sourceHash;
+            }
+            else
+            {
+                // NOTE(patrik): The source is copied straight from the mapped
+                // file into the V8 string
+                std::shared_ptr<const MappedFile> file =
+                    FileCache::Read(modulePath);
+                if (!file || !m_Engine
+                                  ->CreateString(file->GetData(),
+                                                 file->GetSize())
+                                  .ToLocal(&sourceString))
+                {
+                    m_Engine->ThrowException("Could not read module '%s'",
+                                             modulePath.c_str());
+                    return v8::MaybeLocal<v8::Module>();
+                }
+
+                sourceHash =
+                    CodeCache::HashSource(file->GetData(), file->GetSize());
+            }
+
+            cachedData = codeCache->Get(modulePath, sourceHash);
+        }
+
+        v8::ScriptOrigin origin(
+            m_Engine->CreateString(modulePath),
+            v8::Local<v8::Integer>(),         // resource_line_offset
+            v8::Local<v8::Integer>(),         // resource_column_offset
+            v8::False(isolate),               // resource_is_shared_cross_origin
+            v8::Local<v8::Integer>(),         // script_id
+            v8::Local<v8::Value>(),           // source_map_url
+            v8::False(isolate),               // resource_is_opaque
+            v8::False(isolate),               // is_wasm
+            v8::True(isolate),                // is_module
+            v8::Local<v8::PrimitiveArray>()); // host_defined_options
+
+        v8::ScriptCompiler::Source source(sourceString, origin, cachedData);
+
+        v8::ScriptCompiler::CompileOptions options =
+            cachedData ? v8::ScriptCompiler::kConsumeCodeCache
+                       : v8::ScriptCompiler::kNoCompileOptions;
+
+        v8::Local<v8::Module> module;
+        {
+            SCRIPTER_TRACE_SCOPE("ModuleGraph::Compile");
+
+            if (!v8::ScriptCompiler::CompileModule(isolate, &source, options)
+                     .ToLocal(&module))
+            {
+                return v8::MaybeLocal<v8::Module>();
+            }
+        }
+
+        if (!bundled && (!cachedData || source.GetCachedData()->rejected))
+        {
+            codeCache->Store(modulePath, sourceHash,
+                             v8::ScriptCompiler::CreateCodeCache(
+                                 module->GetUnboundModuleScript()));
+        }
+
+        m_Modules[modulePath] =
+            v8::Persistent<v8::Module,
+                           v8::CopyablePersistentTraits<v8::Module>>(isolate,
+                                                                     module);
+        AddModulePath(module, modulePath);
+
+        return handleScope.Escape(module);
+    }
+
+    v8::MaybeLocal<v8::Value> ModuleGraph::Import(v8::Local<v8::Context> context,
+                                                  const String& modulePath)
+    {
+        v8::EscapableHandleScope handleScope(m_Engine->GetIsolate());
+
+        v8::Local<v8::Module> module;
+        if (!Load(modulePath).ToLocal(&module))
+            return v8::MaybeLocal<v8::Value>();
+
+        if (module->GetStatus() == v8::Module::kUninstantiated)
+        {
+            SCRIPTER_TRACE_SCOPE("ModuleGraph::Instantiate");
+
+            bool instantiated = false;
+            if (!module->InstantiateModule(context, ResolveModule)
+                     .To(&instantiated) ||
+                !instantiated)
+            {
+                return v8::MaybeLocal<v8::Value>();
+            }
+        }
+
+        if (module->GetStatus() == v8::Module::kInstantiated)
+        {
+            SCRIPTER_TRACE_SCOPE("ModuleGraph::Evaluate");
+
+            v8::Local<v8::Value> result;
+            if (!module->Evaluate(context).ToLocal(&result))
+                return v8::MaybeLocal<v8::Value>();
+        }
+
+        if (module->GetStatus() == v8::Module::kErrored)
+        {
+            m_Engine->GetIsolate()->ThrowException(module->GetException());
+            return v8::MaybeLocal<v8::Value>();
+        }
+
+        return handleScope.Escape(module->GetModuleNamespace());
+    }
+
+    String ModuleGraph::GetModulePath(v8::Local<v8::Module> module)
+    {
+        auto range = m_ModulePaths.equal_range(module->GetIdentityHash());
+        for (auto it = range.first; it != range.second; it++)
+        {
+            if (it->second.module == module)
+                return it->second.path;
+        }
+
+        return String();
+    }
+
+    void ModuleGraph::AddModulePath(v8::Local<v8::Module> module,
+                                    const String& path)
+    {
+        // NOTE(patrik): The handle is set in place, a copy of a persistent
+        // is a new handle that would have to be reset too
+        auto it = m_ModulePaths.emplace(module->GetIdentityHash(),
+                                        ModulePathEntry());
+        it->second.module.Reset(m_Engine->GetIsolate(), module);
+        it->second.path = path;
+    }
+
+    void ModuleGraph::RemoveModulePath(v8::Local<v8::Module> module)
+    {
+        auto range = m_ModulePaths.equal_range(module->GetIdentityHash());
+        for (auto it = range.first; it != range.second; it++)
+        {
+            if (it->second.module == module)
+            {
+                it->second.module.Reset();
+                m_ModulePaths.erase(it);
+                return;
+            }
+        }
+    }
+
+    std::vector<String> ModuleGraph::GetModulePaths() const
+    {
+        std::vector<String> result;
+        result.reserve(m_Modules.size());
+
+        for (auto it = m_Modules.begin(); it != m_Modules.end(); it++)
+            result.push_back(it->first);
+
+        return result;
+    }
+
+    bool ModuleGraph::Reload(v8::Local<v8::Context> context,
+                             const std::vector<String>& changedPaths)
+    {
+        SCRIPTER_TRACE_SCOPE("ModuleGraph::Reload");
+
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+        v8::HandleScope handleScope(isolate);
+
+        // NOTE(patrik): Every module that imports a changed module has to be
+        // recompiled too because the imports are bound when it's instantiated
+        std::vector<String> stale;
+        std::unordered_set<String> visited;
+        for (const String& path : changedPaths)
+        {
+            if (m_Modules.find(path) != m_Modules.end() &&
+                visited.insert(path).second)
+            {
+                stale.push_back(path);
+            }
+        }
+
+        for (size_t i = 0; i < stale.size(); i++)
+        {
+            auto it = m_Dependents.find(stale[i]);
+            if (it == m_Dependents.end())
+                continue;
+
+            for (const String& dependent : it->second)
+            {
+                if (m_Modules.find(dependent) != m_Modules.end() &&
+                    visited.insert(dependent).second)
+                {
+                    stale.push_back(dependent);
+                }
+            }
+        }
+
+        if (stale.empty())
+            return true;
+
+        decltype(m_Modules) oldModules;
+        for (const String& path : stale)
+        {
+            // NOTE(patrik): A copy of a persistent is a new handle so every
+            // handle that is dropped from a map is reset
+            oldModules[path] = m_Modules[path];
+            m_Modules[path].Reset();
+            m_Modules.erase(path);
+        }
+
+        // NOTE(patrik): Everything is compiled and instantiated before
+        // anything is evaluated so a syntax error or a missing import leaves
+        // the old modules in place
+        bool reloaded = true;
+        for (const String& path : stale)
+        {
+            if (Load(path).IsEmpty())
+            {
+                reloaded = false;
+                break;
+            }
+        }
+
+        for (size_t i = 0; reloaded && i < stale.size(); i++)
+        {
+            SCRIPTER_TRACE_SCOPE("ModuleGraph::Instantiate");
+
+            v8::Local<v8::Module> module = m_Modules[stale[i]].Get(isolate);
+            if (module->GetStatus() != v8::Module::kUninstantiated)
+                continue;
+
+            bool instantiated = false;
+            if (!module->InstantiateModule(context, ResolveModule)
+                     .To(&instantiated) ||
+                !instantiated)
+            {
+                reloaded = false;
+            }
+        }
+
+        // NOTE(patrik): A module that throws while it's evaluated puts the
+        // old modules back too, what the new modules did before that can't
+        // be undone
+        for (size_t i = 0; reloaded && i < stale.size(); i++)
+        {
+            if (Import(context, stale[i]).IsEmpty())
+                reloaded = false;
+        }
+
+        if (!reloaded)
+        {
+            for (auto& it : oldModules)
+            {
+                auto newModule = m_Modules.find(it.first);
+                if (newModule != m_Modules.end())
+                {
+                    RemoveModulePath(newModule->second.Get(isolate));
+                    newModule->second.Reset();
+                }
+
+                m_Modules[it.first] = it.second;
+                it.second.Reset();
+            }
+
+            return false;
+        }
+
+        // NOTE(patrik): The old modules are only kept alive by the functions
+        // the scripts still hold
+        for (auto& it : oldModules)
+        {
+            RemoveModulePath(it.second.Get(isolate));
+            it.second.Reset();
+        }
+
+        SCRIPTER_LOG_INFO("Reloaded {0} modules", stale.size());
+        return true;
+    }
+
+    void ModuleGraph::Clear()
+    {
+        for (auto it = m_Modules.begin(); it != m_Modules.end(); it++)
+        {
+            it->second.Reset();
+        }
+
+        m_Modules.clear();
+
+        for (auto it = m_ModulePaths.begin(); it != m_ModulePaths.end(); it++)
+        {
+            it->second.module.Reset();
+        }
+
+        m_ModulePaths.clear();
+        m_Dependents.clear();
+    }
+
+    String ModuleGraph::ResolvePath(const String& specifier,
+                                    const String& referrerPath,
+                                    const Bundle* bundle)
+    {
+        String modulePath = specifier;
+        if (specifier.empty() || specifier[0] != '/')
+        {
+            String directory = Path::GetDirectoryPath(referrerPath);
+            modulePath = Path::Append(directory, specifier);
+        }
+
+        if (bundle)
+        {
+            String bundlePath = Path::Normalize(modulePath);
+            if (bundle->Find(bundlePath))
+                return bundlePath;
+
+            bundlePath.append(".js");
+            if (bundle->Find(bundlePath))
+                return bundlePath;
+        }
+
+        if (!File::Exists(modulePath))
+            modulePath.append(".js");
+
+        if (!File::Exists(modulePath))
+            return String();
+
+        return Path::GetFullPath(modulePath);
+    }
+
+    v8::MaybeLocal<v8::Module>
+    ModuleGraph::ResolveModule(v8::Local<v8::Context> context,
+                               v8::Local<v8::String> specifier,
+                               v8::Local<v8::Module> referrer)
+    {
+        ScriptEnv* env = ScriptEnv::FromContext(context);
+        Engine* engine = env->GetEngine();
+        ModuleGraph* graph = env->GetModuleGraph();
+
+        String name = engine->ConvertValueToString(specifier);
+        String referrerPath = graph->GetModulePath(referrer);
+        String modulePath =
+            ResolvePath(name, referrerPath, graph->GetBundle());
+
+        if (modulePath.empty())
+        {
+            engine->ThrowException("Could not resolve module '%s'",
+                                   name.c_str());
+            return v8::MaybeLocal<v8::Module>();
+        }
+
+        graph->m_Dependents[modulePath].insert(referrerPath);
+        return graph->Load(modulePath);
+    }
+
+    v8::MaybeLocal<v8::Promise>
+    ModuleGraph::ImportModuleDynamically(v8::Local<v8::Context> context,
+                                         v8::Local<v8::ScriptOrModule> referrer,
+                                         v8::Local<v8::String> specifier)
+    {
+        v8::Isolate* isolate = context->GetIsolate();
+        v8::EscapableHandleScope handleScope(isolate);
+
+        v8::Local<v8::Promise::Resolver> resolver;
+        if (!v8::Promise::Resolver::New(context).ToLocal(&resolver))
+            return v8::MaybeLocal<v8::Promise>();
+
+        ScriptEnv* env = ScriptEnv::FromContext(context);
+        Engine* engine = env->GetEngine();
+
+        String name = engine->ConvertValueToString(specifier);
+        String referrerPath =
+            engine->ConvertValueToString(referrer->GetResourceName());
+        String modulePath = ResolvePath(name, referrerPath,
+                                        env->GetModuleGraph()->GetBundle());
+
+        v8::TryCatch tryCatch(isolate);
+
+        v8::Local<v8::Value> moduleNamespace;
+        if (modulePath.empty())
+        {
+            resolver
+                ->Reject(context,
+                         v8::Exception::Error(engine->CreateString(
+                             "Could not resolve module '" + name + "'")))
+                .FromJust();
+        }
+        else if (env->GetModuleGraph()
+                     ->Import(context, modulePath)
+                     .ToLocal(&moduleNamespace))
+        {
+            resolver->Resolve(context, moduleNamespace).FromJust();
+        }
+        else if (tryCatch.HasCaught())
+        {
+            resolver->Reject(context, tryCatch.Exception()).FromJust();
+        }
+        else
+        {
+            resolver
+                ->Reject(context,
+                         v8::Exception::Error(engine->CreateString(
+                             "Could not import module '" + name + "'")))
+                .FromJust();
+        }
+
+        return handleScope.Escape(resolver->GetPromise());
+    }
+
+} // namespace scripter
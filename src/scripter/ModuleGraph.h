@@ -0,0 +1,144 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Bundle.h"
+#include "scripter/Common.h"
+#include "scripter/Engine.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <v8.h>
+
+namespace scripter {
+
+    /**
+     * ModuleGraph
+     *
+     * Keeps track of the ES6 modules compiled in a script environment, keyed
+     * by the absolute path so every module is only compiled once per context
+     */
+    class ModuleGraph
+    {
+    private:
+        Engine* m_Engine;
+        const Bundle* m_Bundle;
+
+        std::unordered_map<
+            String,
+            v8::Persistent<v8::Module, v8::CopyablePersistentTraits<v8::Module>>>
+            m_Modules;
+        /**
+         * The identity hash of a module isn't unique so the paths are found
+         * by the hash and then the module handles are compared
+         */
+        struct ModulePathEntry
+        {
+            v8::Persistent<v8::Module,
+                           v8::CopyablePersistentTraits<v8::Module>>
+                module;
+            String path;
+        };
+
+        std::unordered_multimap<int32, ModulePathEntry> m_ModulePaths;
+        std::unordered_map<String, std::unordered_set<String>> m_Dependents;
+
+    public:
+        ModuleGraph(Engine* engine);
+        ~ModuleGraph();
+
+        /**
+         * Compiles the module at the path or returns the already compiled
+         * module, the path needs to be absolute
+         */
+        v8::MaybeLocal<v8::Module> Load(const String& modulePath);
+
+        /**
+         * Loads, instantiates and evaluates the module at the path and
+         * returns the module namespace object
+         */
+        v8::MaybeLocal<v8::Value> Import(v8::Local<v8::Context> context,
+                                         const String& modulePath);
+
+        /**
+         * Returns the absolute path of a compiled module
+         */
+        String GetModulePath(v8::Local<v8::Module> module);
+
+        /**
+         * Sets the bundle the modules are loaded from before the filesystem
+         */
+        void SetBundle(const Bundle* bundle) { m_Bundle = bundle; }
+
+        const Bundle* GetBundle() const { return m_Bundle; }
+
+        /**
+         * Returns the paths of all the compiled modules
+         */
+        std::vector<String> GetModulePaths() const;
+
+        /**
+         * Recompiles the changed modules and the modules that import them,
+         * the other modules and their state are kept. The old modules are
+         * put back if a new module fails to compile, instantiate or
+         * evaluate, returns false and leaves the exception in the isolate if
+         * the reload failed
+         * @param changedPaths the absolute paths of the changed files
+         */
+        bool Reload(v8::Local<v8::Context> context,
+                    const std::vector<String>& changedPaths);
+
+        /**
+         * Removes all the modules from the graph
+         */
+        void Clear();
+
+    private:
+        void AddModulePath(v8::Local<v8::Module> module, const String& path);
+        void RemoveModulePath(v8::Local<v8::Module> module);
+
+    public:
+        /**
+         * Resolves a module specifier relative to the referrer's path, the
+         * bundle is checked before the filesystem. Returns an empty string if
+         * the module can't be found
+         */
+        static String ResolvePath(const String& specifier,
+                                  const String& referrerPath,
+                                  const Bundle* bundle = nullptr);
+
+        static v8::MaybeLocal<v8::Module>
+        ResolveModule(v8::Local<v8::Context> context,
+                      v8::Local<v8::String> specifier,
+                      v8::Local<v8::Module> referrer);
+
+        static v8::MaybeLocal<v8::Promise>
+        ImportModuleDynamically(v8::Local<v8::Context> context,
+                                v8::Local<v8::ScriptOrModule> referrer,
+                                v8::Local<v8::String> specifier);
+    };
+
+} // namespace scripter
@@ -0,0 +1,416 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/ModulePrefetcher.h"
+
+#include "scripter/CodeCache.h"
+#include "scripter/Logger.h"
+#include "scripter/ModuleGraph.h"
+#include "scripter/SourceStream.h"
+
+#include "scripter/utils/File.h"
+#include "scripter/utils/Path.h"
+
+#include <ctype.h>
+
+namespace scripter {
+
+    static bool IsIdentifierStart(char c)
+    {
+        return isalpha((unsigned char)c) || c == '_' || c == '$';
+    }
+
+    static bool IsIdentifierChar(char c)
+    {
+        return isalnum((unsigned char)c) || c == '_' || c == '$';
+    }
+
+    static bool IsQuote(char c) { return c == '"' || c == '\'' || c == '`'; }
+
+    static size_t SkipComment(const String& source, size_t index)
+    {
+        if (source.compare(index, 2, "//") == 0)
+        {
+            size_t end = source.find('\n', index);
+            return end == String::npos ? source.length() : end + 1;
+        }
+
+        if (source.compare(index, 2, "/*") == 0)
+        {
+            size_t end = source.find("*/", index + 2);
+            return end == String::npos ? source.length() : end + 2;
+        }
+
+        return index;
+    }
+
+    static size_t SkipWhitespace(const String& source, size_t index)
+    {
+        while (index < source.length())
+        {
+            if (isspace((unsigned char)source[index]))
+            {
+                index++;
+                continue;
+            }
+
+            size_t next = SkipComment(source, index);
+            if (next == index)
+                break;
+
+            index = next;
+        }
+
+        return index;
+    }
+
+    static size_t ReadString(const String& source, size_t index,
+                             String* result)
+    {
+        char quote = source[index];
+        size_t start = ++index;
+
+        while (index < source.length() && source[index] != quote)
+        {
+            if (source[index] == '\\')
+                index++;
+            index++;
+        }
+
+        if (result)
+            *result = source.substr(start, index - start);
+
+        return index < source.length() ? index + 1 : index;
+    }
+
+    static size_t ReadWord(const String& source, size_t index, String* result)
+    {
+        size_t start = index;
+        while (index < source.length() && IsIdentifierChar(source[index]))
+            index++;
+
+        *result = source.substr(start, index - start);
+        return index;
+    }
+
+    ModulePrefetcher::ModulePrefetcher(Engine* engine, int32 threadCount)
+        : m_Engine(engine), m_PendingReads(0)
+    {
+        m_ThreadPool = new ThreadPool(threadCount);
+    }
+
+    ModulePrefetcher::~ModulePrefetcher()
+    {
+        // NOTE(patrik): Waits for the streaming tasks that still use the
+        // entries
+        delete m_ThreadPool;
+        m_Entries.clear();
+    }
+
+    void ModulePrefetcher::Prefetch(const String& rootPath, bool isModule)
+    {
+        String fullPath = Path::GetFullPath(rootPath);
+        if (fullPath.empty())
+        {
+            SCRIPTER_LOG_ERROR("ModulePrefetcher: Could not find '{0}'",
+                               rootPath);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            Schedule(fullPath, isModule);
+        }
+
+        while (true)
+        {
+            Entry* entry = nullptr;
+
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Condition.wait(lock, [this]() {
+                    return !m_ReadEntries.empty() || m_PendingReads == 0;
+                });
+
+                if (m_ReadEntries.empty())
+                    break;
+
+                entry = m_ReadEntries.front();
+                m_ReadEntries.pop_front();
+            }
+
+            // NOTE(patrik): The imports are resolved here and not on the
+            // workers because the path resolving isn't thread safe
+            for (const String& specifier : entry->moduleImports)
+            {
+                String path = ModuleGraph::ResolvePath(specifier, entry->path);
+                if (!path.empty())
+                {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    Schedule(path, true);
+                }
+            }
+
+            String directory = Path::GetDirectoryPath(entry->path);
+            for (const String& name : entry->scriptImports)
+            {
+                String path = Path::Append(directory, name);
+                path.append(".js");
+
+                // NOTE(patrik): Native modules are skipped here
+                if (File::Exists(path))
+                {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    Schedule(Path::GetFullPath(path), false);
+                }
+            }
+
+            if (!entry->isModule)
+                StartStreaming(entry);
+        }
+    }
+
+    std::unique_ptr<ModulePrefetcher::Entry>
+    ModulePrefetcher::Take(const String& path)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+
+        auto it = m_Entries.find(path);
+        if (it == m_Entries.end())
+            return nullptr;
+
+        Entry* entry = it->second.get();
+        m_Condition.wait(lock, [entry]() {
+            return !entry->streamedSource || entry->streamingDone;
+        });
+
+        std::unique_ptr<Entry> result = std::move(it->second);
+        m_Entries.erase(it);
+
+        return result;
+    }
+
+    void ModulePrefetcher::ScanImports(const String& source,
+                                       std::vector<String>* moduleImports,
+                                       std::vector<String>* scriptImports)
+    {
+        size_t index = 0;
+        while (index < source.length())
+        {
+            char c = source[index];
+
+            size_t next = SkipComment(source, index);
+            if (next != index)
+            {
+                index = next;
+                continue;
+            }
+
+            if (IsQuote(c))
+            {
+                index = ReadString(source, index, nullptr);
+                continue;
+            }
+
+            if (!IsIdentifierStart(c) ||
+                (index > 0 && (IsIdentifierChar(source[index - 1]) ||
+                               source[index - 1] == '.')))
+            {
+                index++;
+                continue;
+            }
+
+            String word;
+            index = ReadWord(source, index, &word);
+
+            size_t cursor = SkipWhitespace(source, index);
+            if (cursor >= source.length())
+                break;
+
+            String specifier;
+            if (word == "import")
+            {
+                if (source[cursor] == '(')
+                {
+                    // import("module")
+                    cursor = SkipWhitespace(source, cursor + 1);
+                    if (cursor < source.length() && IsQuote(source[cursor]))
+                    {
+                        index = ReadString(source, cursor, &specifier);
+                        moduleImports->push_back(specifier);
+                    }
+                    continue;
+                }
+
+                if (source[cursor] == '.')
+                    continue;
+
+                // import x from "module" or import "module", the specifier
+                // is the first string in the statement
+                while (cursor < source.length() && source[cursor] != ';')
+                {
+                    size_t skipped = SkipComment(source, cursor);
+                    if (skipped != cursor)
+                    {
+                        cursor = skipped;
+                        continue;
+                    }
+
+                    if (IsQuote(source[cursor]))
+                    {
+                        index = ReadString(source, cursor, &specifier);
+                        moduleImports->push_back(specifier);
+                        break;
+                    }
+
+                    cursor++;
+                }
+            }
+            else if (word == "export")
+            {
+                // export * from "module" or export { x } from "module"
+                if (source[cursor] == '{')
+                {
+                    cursor = source.find('}', cursor);
+                    if (cursor == String::npos)
+                        break;
+                    cursor++;
+                }
+                else if (source[cursor] == '*')
+                {
+                    cursor = SkipWhitespace(source, cursor + 1);
+
+                    String as;
+                    ReadWord(source, cursor, &as);
+                    if (as == "as")
+                    {
+                        cursor = SkipWhitespace(source, cursor + 2);
+                        cursor = ReadWord(source, cursor, &as);
+                    }
+                }
+                else
+                {
+                    continue;
+                }
+
+                cursor = SkipWhitespace(source, cursor);
+
+                String from;
+                cursor = ReadWord(source, cursor, &from);
+                if (from != "from")
+                    continue;
+
+                cursor = SkipWhitespace(source, cursor);
+                if (cursor < source.length() && IsQuote(source[cursor]))
+                {
+                    index = ReadString(source, cursor, &specifier);
+                    moduleImports->push_back(specifier);
+                }
+            }
+            else if (word == "importModule" && source[cursor] == '(')
+            {
+                // importModule("module")
+                cursor = SkipWhitespace(source, cursor + 1);
+                if (cursor < source.length() && IsQuote(source[cursor]))
+                {
+                    index = ReadString(source, cursor, &specifier);
+                    scriptImports->push_back(specifier);
+                }
+            }
+        }
+    }
+
+    void ModulePrefetcher::Schedule(const String& path, bool isModule)
+    {
+        if (m_Scheduled.find(path) != m_Scheduled.end())
+            return;
+
+        m_Scheduled.insert(path);
+        m_PendingReads++;
+
+        m_ThreadPool->Submit(
+            [this, path, isModule]() { ReadEntry(path, isModule); });
+    }
+
+    void ModulePrefetcher::ReadEntry(const String& path, bool isModule)
+    {
+        std::unique_ptr<Entry> entry;
+
+        if (File::Exists(path))
+        {
+            entry.reset(new Entry());
+            entry->path = path;
+            entry->source = File::ReadFile(path);
+            entry->sourceHash = CodeCache::HashSource(entry->source);
+            entry->isModule = isModule;
+            entry->streamingDone = false;
+
+            ScanImports(entry->source, &entry->moduleImports,
+                        &entry->scriptImports);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            if (entry)
+            {
+                m_ReadEntries.push_back(entry.get());
+                m_Entries[path] = std::move(entry);
+            }
+
+            m_PendingReads--;
+        }
+
+        m_Condition.notify_all();
+    }
+
+    void ModulePrefetcher::StartStreaming(Entry* entry)
+    {
+        entry->streamedSource.reset(new v8::ScriptCompiler::StreamedSource(
+            new StringSourceStream(entry->source),
+            v8::ScriptCompiler::StreamedSource::UTF8));
+
+        v8::ScriptCompiler::ScriptStreamingTask* task =
+            v8::ScriptCompiler::StartStreamingScript(
+                m_Engine->GetIsolate(), entry->streamedSource.get());
+
+        if (!task)
+        {
+            entry->streamedSource.reset();
+            return;
+        }
+
+        m_ThreadPool->Submit([this, entry, task]() {
+            task->Run();
+            delete task;
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                entry->streamingDone = true;
+            }
+
+            m_Condition.notify_all();
+        });
+    }
+
+} // namespace scripter
@@ -0,0 +1,115 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+#include "scripter/Engine.h"
+
+#include "scripter/utils/ThreadPool.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <v8.h>
+
+namespace scripter {
+
+    /**
+     * ModulePrefetcher
+     *
+     * Walks the import graph of a script before it runs, the files are read,
+     * hashed and scanned for imports on worker threads and classic scripts
+     * are parsed in the background with V8's script streaming. The scan is
+     * only a best effort, an import that isn't found here is loaded the
+     * normal way when it runs
+     */
+    class ModulePrefetcher
+    {
+    public:
+        struct Entry
+        {
+            String path;
+            String source;
+            uint64 sourceHash;
+            bool isModule;
+
+            std::vector<String> moduleImports;
+            std::vector<String> scriptImports;
+
+            std::unique_ptr<v8::ScriptCompiler::StreamedSource> streamedSource;
+            bool streamingDone;
+        };
+
+    private:
+        Engine* m_Engine;
+        ThreadPool* m_ThreadPool;
+
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+
+        std::unordered_map<String, std::unique_ptr<Entry>> m_Entries;
+        std::unordered_set<String> m_Scheduled;
+        std::deque<Entry*> m_ReadEntries;
+        int32 m_PendingReads;
+
+    public:
+        ModulePrefetcher(Engine* engine, int32 threadCount);
+        ~ModulePrefetcher();
+
+        /**
+         * Reads the root file and everything it imports, blocks until all the
+         * files are read but the parsing keeps running in the background
+         * @param rootPath the path to the root script
+         * @param isModule if the root is a ES6 module or a classic script
+         */
+        void Prefetch(const String& rootPath, bool isModule);
+
+        /**
+         * Removes and returns the prefetched entry for the path, waits for the
+         * background parsing if its still running. Returns nullptr if the
+         * path wasn't prefetched
+         */
+        std::unique_ptr<Entry> Take(const String& path);
+
+    public:
+        /**
+         * Finds the specifiers used by import statements and importModule
+         * calls in the source
+         */
+        static void ScanImports(const String& source,
+                                std::vector<String>* moduleImports,
+                                std::vector<String>* scriptImports);
+
+    private:
+        void Schedule(const String& path, bool isModule);
+        void ReadEntry(const String& path, bool isModule);
+        void StartStreaming(Entry* entry);
+    };
+
+} // namespace scripter
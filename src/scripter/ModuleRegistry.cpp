@@ -0,0 +1,126 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/ModuleRegistry.h"
+
+#include "scripter/Logger.h"
+
+namespace scripter {
+
+    ModuleRegistry::ModuleRegistry() {}
+
+    ModuleRegistry::~ModuleRegistry()
+    {
+        for (auto it = m_Entries.begin(); it != m_Entries.end(); it++)
+        {
+            delete it->second.module;
+        }
+
+        m_Entries.clear();
+        m_Keys.clear();
+    }
+
+    Module* ModuleRegistry::Acquire(const String& key)
+    {
+        auto it = m_Entries.find(key);
+        if (it == m_Entries.end())
+            return nullptr;
+
+        it->second.refCount++;
+        return it->second.module;
+    }
+
+    Module* ModuleRegistry::Add(const String& key, Module* module)
+    {
+        SCRIPTER_ASSERT(module);
+        SCRIPTER_ASSERT(m_Entries.find(key) == m_Entries.end(),
+                        "Module '{0}' is already registered", key);
+
+        m_Entries[key] = {module, 1};
+        m_Keys[module] = key;
+
+        return module;
+    }
+
+    void ModuleRegistry::Release(Module* module)
+    {
+        auto it = m_Keys.find(module);
+        if (it == m_Keys.end())
+            return;
+
+        Entry& entry = m_Entries[it->second];
+        SCRIPTER_ASSERT(entry.refCount > 0);
+
+        entry.refCount--;
+    }
+
+    void ModuleRegistry::Purge()
+    {
+        for (auto it = m_Entries.begin(); it != m_Entries.end();)
+        {
+            if (it->second.refCount == 0)
+            {
+                m_Keys.erase(it->second.module);
+                delete it->second.module;
+                it = m_Entries.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
+    }
+
+    bool ModuleRegistry::Contains(Module* module) const
+    {
+        return m_Keys.find(module) != m_Keys.end();
+    }
+
+    std::vector<Module*> ModuleRegistry::GetModules() const
+    {
+        std::vector<Module*> result;
+        result.reserve(m_Entries.size());
+
+        for (auto it = m_Entries.begin(); it != m_Entries.end(); it++)
+            result.push_back(it->second.module);
+
+        return result;
+    }
+
+    ModuleStats ModuleRegistry::GetStats() const
+    {
+        ModuleStats stats = {};
+
+        for (auto it = m_Entries.begin(); it != m_Entries.end(); it++)
+        {
+            stats.liveModules++;
+            if (it->second.refCount > 0)
+                stats.referencedModules++;
+
+            stats.liveBytes += it->second.module->GetMemoryUsage();
+        }
+
+        return stats;
+    }
+
+} // namespace scripter
@@ -0,0 +1,95 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+#include "scripter/Engine.h"
+#include "scripter/Module.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace scripter {
+
+    /**
+     * ModuleRegistry
+     *
+     * Owns the modules created by importModule for an engine, importing the
+     * same module again returns the same instance. The script environments
+     * hold a reference to the modules they import and all the modules are
+     * deleted when the engine is deleted
+     */
+    class ModuleRegistry
+    {
+    private:
+        struct Entry
+        {
+            Module* module;
+            int32 refCount;
+        };
+
+        std::unordered_map<String, Entry> m_Entries;
+        std::unordered_map<Module*, String> m_Keys;
+
+    public:
+        ModuleRegistry();
+        ~ModuleRegistry();
+
+        /**
+         * Returns the module registered with the key and adds a reference to
+         * it, returns nullptr if there's no module with the key
+         */
+        Module* Acquire(const String& key);
+
+        /**
+         * Registers a new module with one reference, the registry takes the
+         * ownership of the module
+         */
+        Module* Add(const String& key, Module* module);
+
+        /**
+         * Removes a reference from a module, the module stays alive until the
+         * registry is deleted or Purge is called
+         */
+        void Release(Module* module);
+
+        /**
+         * Deletes the modules that no script environment references
+         */
+        void Purge();
+
+        /**
+         * Returns true if the registry owns the module
+         */
+        bool Contains(Module* module) const;
+
+        /**
+         * Returns all the modules the registry owns
+         */
+        std::vector<Module*> GetModules() const;
+
+        ModuleStats GetStats() const;
+    };
+
+} // namespace scripter
@@ -23,25 +23,199 @@
  */
 #include "scripter/NativeModule.h"
 
+#include "scripter/Tracing.h"
+
+#include <chrono>
+
 namespace scripter {
 
+    // NOTE(patrik): A function static so the registry exists before the static
+    // initializers of other files use it
+    static std::unordered_map<String, CreateModuleFunc>& GetRegistry()
+    {
+        static std::unordered_map<String, CreateModuleFunc> registry;
+        return registry;
+    }
+
     NativeModule::NativeModule(Engine* engine) : Module(engine) {}
 
     NativeModule::~NativeModule() {}
 
     v8::Local<v8::Object> NativeModule::GenerateObject()
     {
+        SCRIPTER_TRACE_SCOPE("NativeModule::GenerateObject");
+
         v8::Isolate* isolate = m_Engine->GetIsolate();
         v8::EscapableHandleScope handleScope(isolate);
 
+        // NOTE(patrik): The functions are only wrapped if tracing or the call
+        // stats are on when the object is generated so the calls are free
+        // otherwise
+        bool traced = Tracer::IsEnabled();
+        bool recordStats = m_Engine->IsNativeCallStatsEnabled();
+
         v8::Local<v8::ObjectTemplate> result = v8::ObjectTemplate::New(isolate);
         for (auto it = m_Functions.begin(); it != m_Functions.end(); it++)
         {
-            result->Set(isolate, it->first.c_str(),
-                        v8::FunctionTemplate::New(isolate, it->second));
+            if (!traced && !recordStats)
+            {
+                result->Set(isolate, it->first.c_str(),
+                            v8::FunctionTemplate::New(isolate, it->second));
+                continue;
+            }
+
+            // NOTE(patrik): The function is shared by every object the module
+            // has generated so the name is never taken away again, TraceScope
+            // checks if tracing is on when the function is called
+            NativeFunction& function = m_NativeFunctions[it->first];
+            function.callback = it->second;
+            if (traced && !function.traceName)
+            {
+                function.traceName =
+                    Tracer::InternName(GetPackageName() + "." + it->first);
+            }
+
+            if (recordStats && !function.shards)
+            {
+                function.shards.reset(new CallShard[CALL_SHARD_COUNT]);
+                for (uint32 i = 0; i < CALL_SHARD_COUNT; i++)
+                {
+                    function.shards[i].calls.store(0);
+                    function.shards[i].totalNanoseconds.store(0);
+                }
+            }
+
+            v8::Local<v8::External> data =
+                v8::External::New(isolate, &function);
+            result->Set(
+                isolate, it->first.c_str(),
+                v8::FunctionTemplate::New(isolate, InstrumentedCall, data));
         }
 
         return handleScope.Escape(result->NewInstance());
     }
 
+    size_t NativeModule::GetMemoryUsage()
+    {
+        size_t result = sizeof(NativeModule);
+        for (auto it = m_Functions.begin(); it != m_Functions.end(); it++)
+        {
+            result += sizeof(*it) + it->first.capacity();
+        }
+
+        for (auto it = m_NativeFunctions.begin(); it != m_NativeFunctions.end();
+             it++)
+        {
+            result += sizeof(*it) + it->first.capacity();
+            if (it->second.shards)
+                result += sizeof(CallShard) * CALL_SHARD_COUNT;
+        }
+
+        return result;
+    }
+
+    bool NativeModule::GetCallStats(const String& functionName,
+                                    NativeCallStats* result)
+    {
+        auto it = m_NativeFunctions.find(functionName);
+        if (it == m_NativeFunctions.end() || !it->second.shards)
+            return false;
+
+        MergeCallStats(it->first, it->second, result);
+        return true;
+    }
+
+    std::vector<NativeCallStats> NativeModule::GetCallStats()
+    {
+        std::vector<NativeCallStats> result;
+        for (auto it = m_NativeFunctions.begin(); it != m_NativeFunctions.end();
+             it++)
+        {
+            if (!it->second.shards)
+                continue;
+
+            NativeCallStats stats;
+            MergeCallStats(it->first, it->second, &stats);
+            result.push_back(stats);
+        }
+
+        return result;
+    }
+
+    void NativeModule::MergeCallStats(const String& functionName,
+                                      const NativeFunction& function,
+                                      NativeCallStats* result)
+    {
+        result->module = GetPackageName();
+        result->function = functionName;
+        result->calls = 0;
+        result->totalNanoseconds = 0;
+        result->latency = {};
+
+        for (uint32 i = 0; i < CALL_SHARD_COUNT; i++)
+        {
+            const CallShard& shard = function.shards[i];
+            result->calls += shard.calls.load(std::memory_order_relaxed);
+            result->totalNanoseconds +=
+                shard.totalNanoseconds.load(std::memory_order_relaxed);
+
+            HistogramSnapshot latency = shard.latency.GetSnapshot();
+            for (uint32 j = 0; j < HistogramSnapshot::BUCKET_COUNT; j++)
+                result->latency.buckets[j] += latency.buckets[j];
+
+            result->latency.count += latency.count;
+            result->latency.sum += latency.sum;
+            if (latency.max > result->latency.max)
+                result->latency.max = latency.max;
+        }
+    }
+
+    void NativeModule::InstrumentedCall(
+        const v8::FunctionCallbackInfo<v8::Value>& args)
+    {
+        static std::atomic<uint32> s_NextShard(0);
+        static thread_local uint32 t_Shard =
+            s_NextShard.fetch_add(1, std::memory_order_relaxed) %
+            CALL_SHARD_COUNT;
+
+        v8::Local<v8::External> data =
+            v8::Local<v8::External>::Cast(args.Data());
+        NativeFunction* function = (NativeFunction*)data->Value();
+
+        TraceScope traceScope(function->traceName);
+
+        if (!function->shards)
+        {
+            function->callback(args);
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        function->callback(args);
+        uint64 elapsed =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+
+        CallShard& shard = function->shards[t_Shard];
+        shard.calls.fetch_add(1, std::memory_order_relaxed);
+        shard.totalNanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+        shard.latency.Record(elapsed);
+    }
+
+    bool NativeModule::Register(const String& name, CreateModuleFunc func)
+    {
+        GetRegistry()[name] = func;
+        return true;
+    }
+
+    CreateModuleFunc NativeModule::FindRegistered(const String& name)
+    {
+        auto it = GetRegistry().find(name);
+        if (it == GetRegistry().end())
+            return nullptr;
+
+        return it->second;
+    }
+
 } // namespace scripter
\ No newline at end of file
@@ -24,6 +24,12 @@
 #include "scripter/NativeModuleImporter.h"
 
 #include "scripter/Logger.h"
+#include "scripter/ModuleRegistry.h"
+
+#include "scripter/utils/ThreadPool.h"
+
+#include <fstream>
+#include <sstream>
 
 #include <dlfcn.h>
 
@@ -32,8 +38,8 @@ namespace scripter {
     NativeModuleImporter* NativeModuleImporter::s_Instance;
 
     NativeModuleImporter::NativeModuleImporter()
+        : m_SearchPath({"./bin/Debug", "."})
     {
-        m_SearchPaths = {"./bin/Debug", ".", ""};
     }
 
     NativeModuleImporter::~NativeModuleImporter()
@@ -51,63 +57,154 @@ namespace scripter {
     Module* NativeModuleImporter::ImportModule(Engine* engine,
                                                const String& moduleName)
     {
-        void* handle = nullptr;
-        bool exists = false;
-
         // TODO(patrik): Add a search path relative to the script path like in
         // JavascriptModuleImporter
 
-        if (m_Handles.find(moduleName) != m_Handles.end())
+        String key = "native:" + moduleName;
+
+        ModuleRegistry* registry = engine->GetModuleRegistry();
+        Module* module = registry->Acquire(key);
+        if (module)
+            return module;
+
+        CreateModuleFunc func = NativeModule::FindRegistered(moduleName);
+        if (!func)
+            func = FindModule(moduleName);
+
+        if (!func)
+            return nullptr;
+
+        module = func(engine);
+        if (!module)
+            return nullptr;
+
+        return registry->Add(key, module);
+    }
+
+    void NativeModuleImporter::PreloadManifest(const String& manifestPath)
+    {
+        std::ifstream manifest(manifestPath);
+        if (!manifest)
         {
-            handle = m_Handles[moduleName];
-            exists = true;
+            SCRIPTER_LOG_ERROR("Could not open native module manifest '{0}'",
+                               manifestPath);
+            return;
         }
-        else
+
+        std::vector<std::pair<String, String>> modules;
+
+        String line;
+        while (std::getline(manifest, line))
+        {
+            std::istringstream stream(line);
+
+            String moduleName;
+            String libraryPath;
+            if (!(stream >> moduleName) || moduleName[0] == '#')
+                continue;
+
+            stream >> libraryPath;
+            modules.push_back(std::make_pair(moduleName, libraryPath));
+        }
+
         {
-            for (const String& path : m_SearchPaths)
+            // NOTE(patrik): The loader serializes parts of dlopen but reading
+            // and relocating the libraries still runs in parallel
+            ThreadPool threadPool(ThreadPool::GetDefaultThreadCount());
+            for (const auto& module : modules)
             {
-                String modulePath = path;
-
-                if (modulePath != "" &&
-                    modulePath[modulePath.length() - 1] != '/')
-                {
-                    modulePath.append(1, '/');
-                }
-
-                modulePath.append("lib");
-                modulePath.append(moduleName);
-                modulePath.append(".so");
-
-                // TODO(patrik): Add a check here if the modulePath exists
-
-                handle = dlopen(modulePath.c_str(), RTLD_NOW);
-                if (handle)
-                {
-                    SCRIPTER_LOG_INFO("Loaded native module: {0}",
-                                      moduleName.c_str());
-                    exists = false;
-                    break;
-                }
+                threadPool.Submit([this, module]() {
+                    if (module.second.empty())
+                        FindModule(module.first);
+                    else
+                        LoadLibrary(module.first, module.second);
+                });
             }
+
+            threadPool.WaitIdle();
         }
 
-        if (handle)
+        SCRIPTER_LOG_INFO("Preloaded {0} native modules from '{1}'",
+                          modules.size(), manifestPath);
+    }
+
+    void NativeModuleImporter::ClearMissingModules()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_MissingModules.clear();
+    }
+
+    void NativeModuleImporter::AddSearchPath(const String& directory)
+    {
+        m_SearchPath.Add(directory);
+        ClearMissingModules();
+    }
+
+    CreateModuleFunc NativeModuleImporter::FindModule(const String& moduleName)
+    {
         {
-            CreateModuleFunc func =
-                (CreateModuleFunc)dlsym(handle, "CreateModule");
+            std::lock_guard<std::mutex> lock(m_Mutex);
 
-            if (func)
-            {
-                if (!exists)
-                    m_Handles[moduleName] = handle;
+            auto it = m_CreateFunctions.find(moduleName);
+            if (it != m_CreateFunctions.end())
+                return it->second;
 
-                return func(engine);
-            }
+            if (m_MissingModules.find(moduleName) != m_MissingModules.end())
+                return nullptr;
         }
 
+        String libraryName = "lib" + moduleName + ".so";
+        String modulePath = m_SearchPath.Find(libraryName);
+
+        // NOTE(patrik): Only the name is given to dlopen if the library isn't
+        // in the search path so it uses the system search paths
+        CreateModuleFunc func = LoadLibrary(
+            moduleName, modulePath.empty() ? libraryName : modulePath);
+        if (func)
+            return func;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_MissingModules.insert(moduleName);
+
         return nullptr;
     }
 
+    CreateModuleFunc
+    NativeModuleImporter::LoadLibrary(const String& moduleName,
+                                      const String& libraryPath)
+    {
+        void* handle = dlopen(libraryPath.c_str(), RTLD_NOW);
+        if (!handle)
+            return nullptr;
+
+        CreateModuleFunc func = (CreateModuleFunc)dlsym(handle, "CreateModule");
+        if (!func)
+        {
+            SCRIPTER_LOG_ERROR("Native module '{0}' has no CreateModule",
+                               libraryPath);
+            dlclose(handle);
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        // NOTE(patrik): Another thread could have loaded the same module
+        auto it = m_CreateFunctions.find(moduleName);
+        if (it != m_CreateFunctions.end())
+        {
+            dlclose(handle);
+            return it->second;
+        }
+
+        SCRIPTER_LOG_INFO("Loaded native module: {0}", moduleName.c_str());
+
+        m_Handles[moduleName] = handle;
+        m_CreateFunctions[moduleName] = func;
+        m_MissingModules.erase(moduleName);
+
+        return func;
+    }
+
     NativeModuleImporter* NativeModuleImporter::Get() { return s_Instance; }
 
     void NativeModuleImporter::Initialize()
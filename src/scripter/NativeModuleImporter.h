@@ -25,8 +25,13 @@
 
 #include "scripter/Common.h"
 #include "scripter/Module.h"
+#include "scripter/NativeModule.h"
 
+#include "scripter/utils/SearchPath.h"
+
+#include <mutex>
 #include <string>
+#include <unordered_set>
 
 namespace scripter {
 
@@ -46,10 +51,13 @@ namespace scripter {
 
     private:
         static NativeModuleImporter* s_Instance;
-        typedef Module* (*CreateModuleFunc)(Engine*);
 
         std::unordered_map<String, void*> m_Handles;
-        std::vector<String> m_SearchPaths;
+        std::unordered_map<String, CreateModuleFunc> m_CreateFunctions;
+        std::unordered_set<String> m_MissingModules;
+        SearchPath m_SearchPath;
+
+        std::mutex m_Mutex;
 
     private:
         NativeModuleImporter();
@@ -58,18 +66,45 @@ namespace scripter {
         ~NativeModuleImporter();
 
         /**
-         * Finds and imports a native module a ".so" or a ".dll" file.
+         * Finds and imports a native module, modules linked into the binary
+         * are checked first and then the ".so" or ".dll" files.
          * @param engine
          * @param moduleName the name of the module to find
          */
         Module* ImportModule(Engine* engine, const String& moduleName);
 
+        /**
+         * Loads all the native modules listed in the manifest on worker
+         * threads. Every line in the manifest is a module name optionally
+         * followed by the path to the library, lines starting with # are
+         * comments
+         * @param manifestPath the path to the manifest file
+         */
+        void PreloadManifest(const String& manifestPath);
+
+        /**
+         * Forgets the modules that couldn't be found so the next import
+         * searches for them again
+         */
+        void ClearMissingModules();
+
+        /**
+         * Adds a directory that is searched for the module libraries, the
+         * system library paths are always searched last
+         */
+        void AddSearchPath(const String& directory);
+
     public:
         /**
          * Returns the instance of this class
          */
         static NativeModuleImporter* Get();
 
+    private:
+        CreateModuleFunc FindModule(const String& moduleName);
+        CreateModuleFunc LoadLibrary(const String& moduleName,
+                                     const String& libraryPath);
+
     private:
         static void Initialize();
         static void Deinitialize();
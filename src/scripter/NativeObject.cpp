@@ -0,0 +1,103 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/NativeObject.h"
+
+namespace scripter {
+
+    /**
+     * Holds the weak handle of an instance and deletes the object with it
+     */
+    struct WeakNativeObject
+    {
+        void* object;
+        NativeObject::DeleteFunc deleteFunc;
+        v8::Global<v8::Object> handle;
+    };
+
+    static void DeleteNativeObject(const v8::WeakCallbackInfo<void>& data)
+    {
+        WeakNativeObject* weak = (WeakNativeObject*)data.GetParameter();
+
+        weak->handle.Reset();
+        weak->deleteFunc(weak->object);
+        delete weak;
+    }
+
+    v8::Local<v8::FunctionTemplate>
+    NativeObject::CreateClass(Engine* engine, const char* name,
+                              v8::FunctionCallback constructor,
+                              std::initializer_list<Method> methods)
+    {
+        v8::Isolate* isolate = engine->GetIsolate();
+        v8::EscapableHandleScope handleScope(isolate);
+
+        v8::Local<v8::FunctionTemplate> result =
+            v8::FunctionTemplate::New(isolate, constructor);
+        result->SetClassName(engine->CreateString(name));
+        result->InstanceTemplate()->SetInternalFieldCount(1);
+
+        // NOTE(patrik): The signature makes V8 throw before a method runs on
+        // a receiver that isn't an instance, so Unwrap can trust the field
+        v8::Local<v8::Signature> signature =
+            v8::Signature::New(isolate, result);
+
+        v8::Local<v8::ObjectTemplate> prototype = result->PrototypeTemplate();
+        for (const Method& method : methods)
+        {
+            prototype->Set(isolate, method.name,
+                           v8::FunctionTemplate::New(isolate, method.callback,
+                                                     v8::Local<v8::Value>(),
+                                                     signature));
+        }
+
+        return handleScope.Escape(result);
+    }
+
+    bool NativeObject::CheckConstructCall(
+        Engine* engine, const v8::FunctionCallbackInfo<v8::Value>& args,
+        const char* functionName)
+    {
+        if (args.IsConstructCall())
+            return true;
+
+        engine->ThrowException("%s: Needs to be called with new",
+                               functionName);
+        return false;
+    }
+
+    void NativeObject::WrapPointer(Engine* engine,
+                                   v8::Local<v8::Object> instance,
+                                   void* object, DeleteFunc deleteFunc)
+    {
+        instance->SetAlignedPointerInInternalField(0, object);
+
+        // NOTE(patrik): Weak callbacks aren't run when the isolate is
+        // disposed so the objects alive then are leaked
+        WeakNativeObject* weak = new WeakNativeObject{object, deleteFunc, {}};
+        weak->handle.Reset(engine->GetIsolate(), instance);
+        weak->handle.SetWeak((void*)weak, DeleteNativeObject,
+                             v8::WeakCallbackType::kParameter);
+    }
+
+} // namespace scripter
@@ -0,0 +1,295 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/Platform.h"
+
+#include "scripter/Tracing.h"
+
+#include <chrono>
+
+namespace scripter {
+
+    ForegroundTaskRunner::ForegroundTaskRunner() : m_Terminated(false) {}
+
+    void ForegroundTaskRunner::PostTask(std::unique_ptr<v8::Task> task)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Terminated)
+            return;
+
+        m_Tasks.push_back(std::move(task));
+    }
+
+    void
+    ForegroundTaskRunner::PostNonNestableTask(std::unique_ptr<v8::Task> task)
+    {
+        // NOTE(patrik): The tasks are only run from the top of the event loop
+        // so no task is ever nested
+        PostTask(std::move(task));
+    }
+
+    void ForegroundTaskRunner::PostDelayedTask(std::unique_ptr<v8::Task> task,
+                                               double delayInSeconds)
+    {
+        double deadline = std::chrono::duration<double>(
+                              std::chrono::steady_clock::now()
+                                  .time_since_epoch())
+                              .count() +
+                          delayInSeconds;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Terminated)
+            return;
+
+        m_DelayedTasks.emplace(deadline, std::move(task));
+    }
+
+    void ForegroundTaskRunner::PostIdleTask(std::unique_ptr<v8::IdleTask> task)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Terminated)
+            return;
+
+        m_IdleTasks.push_back(std::move(task));
+    }
+
+    std::deque<std::unique_ptr<v8::Task>>
+    ForegroundTaskRunner::TakeTasks(double now)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        while (!m_DelayedTasks.empty() && m_DelayedTasks.begin()->first <= now)
+        {
+            m_Tasks.push_back(std::move(m_DelayedTasks.begin()->second));
+            m_DelayedTasks.erase(m_DelayedTasks.begin());
+        }
+
+        std::deque<std::unique_ptr<v8::Task>> result;
+        result.swap(m_Tasks);
+        return result;
+    }
+
+    std::unique_ptr<v8::IdleTask> ForegroundTaskRunner::PopIdleTask()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (m_IdleTasks.empty())
+            return nullptr;
+
+        std::unique_ptr<v8::IdleTask> task = std::move(m_IdleTasks.front());
+        m_IdleTasks.pop_front();
+        return task;
+    }
+
+    bool ForegroundTaskRunner::HasIdleTasks()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return !m_IdleTasks.empty();
+    }
+
+    void ForegroundTaskRunner::Terminate()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_Terminated = true;
+        m_Tasks.clear();
+        m_DelayedTasks.clear();
+        m_IdleTasks.clear();
+    }
+
+    Platform::Platform(int32 workerCount, bool pinWorkers,
+                       std::unique_ptr<v8::TracingController> tracingController)
+        : m_TracingController(std::move(tracingController))
+    {
+        m_Scheduler = new TaskScheduler(workerCount, pinWorkers);
+    }
+
+    Platform::~Platform()
+    {
+        // NOTE(patrik): The workers are stopped before the runners are
+        // dropped, a worker might still be posting to a runner
+        delete m_Scheduler;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto& it : m_ForegroundTaskRunners)
+            it.second->Terminate();
+        m_ForegroundTaskRunners.clear();
+    }
+
+    bool Platform::RunForegroundTasks(v8::Isolate* isolate)
+    {
+        std::shared_ptr<ForegroundTaskRunner> runner =
+            GetRunner(isolate, false);
+        if (!runner)
+            return false;
+
+        SCRIPTER_TRACE_SCOPE("Platform::RunForegroundTasks");
+
+        // NOTE(patrik): The tasks posted while running are left for the next
+        // call so a task that keeps posting itself can't starve the caller
+        std::deque<std::unique_ptr<v8::Task>> tasks =
+            runner->TakeTasks(MonotonicallyIncreasingTime());
+
+        for (std::unique_ptr<v8::Task>& task : tasks)
+            task->Run();
+
+        return !tasks.empty();
+    }
+
+    bool Platform::RunIdleTasks(v8::Isolate* isolate, double idleTimeInSeconds)
+    {
+        std::shared_ptr<ForegroundTaskRunner> runner =
+            GetRunner(isolate, false);
+        if (!runner)
+            return false;
+
+        SCRIPTER_TRACE_SCOPE("Platform::RunIdleTasks");
+
+        double deadline = MonotonicallyIncreasingTime() + idleTimeInSeconds;
+        while (MonotonicallyIncreasingTime() < deadline)
+        {
+            std::unique_ptr<v8::IdleTask> task = runner->PopIdleTask();
+            if (!task)
+                return false;
+
+            task->Run(deadline);
+        }
+
+        return runner->HasIdleTasks();
+    }
+
+    void Platform::UnregisterIsolate(v8::Isolate* isolate)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        auto it = m_ForegroundTaskRunners.find(isolate);
+        if (it == m_ForegroundTaskRunners.end())
+            return;
+
+        // NOTE(patrik): V8 might still hold the runner, terminating it drops
+        // the tasks now and ignores the tasks posted later
+        it->second->Terminate();
+        m_ForegroundTaskRunners.erase(it);
+    }
+
+    void Platform::PostBackgroundTask(std::function<void()> task)
+    {
+        m_Scheduler->Submit(std::move(task), TaskPriority::High);
+    }
+
+    int Platform::NumberOfWorkerThreads()
+    {
+        return m_Scheduler->GetThreadCount();
+    }
+
+    std::shared_ptr<v8::TaskRunner>
+    Platform::GetForegroundTaskRunner(v8::Isolate* isolate)
+    {
+        return GetRunner(isolate, true);
+    }
+
+    void Platform::CallOnWorkerThread(std::unique_ptr<v8::Task> task)
+    {
+        // NOTE(patrik): std::function needs a copyable callable so the task
+        // is moved into a shared pointer
+        std::shared_ptr<v8::Task> shared(std::move(task));
+        m_Scheduler->Submit([shared]() { shared->Run(); }, TaskPriority::Low);
+    }
+
+    void
+    Platform::CallBlockingTaskOnWorkerThread(std::unique_ptr<v8::Task> task)
+    {
+        // NOTE(patrik): The main thread is waiting for these tasks so they
+        // are run before the other background tasks
+        std::shared_ptr<v8::Task> shared(std::move(task));
+        m_Scheduler->Submit([shared]() { shared->Run(); }, TaskPriority::High);
+    }
+
+    void Platform::CallDelayedOnWorkerThread(std::unique_ptr<v8::Task> task,
+                                             double delayInSeconds)
+    {
+        std::shared_ptr<v8::Task> shared(std::move(task));
+        m_Scheduler->SubmitDelayed([shared]() { shared->Run(); },
+                                   delayInSeconds, TaskPriority::Low);
+    }
+
+    void Platform::CallOnForegroundThread(v8::Isolate* isolate, v8::Task* task)
+    {
+        GetRunner(isolate, true)->PostTask(std::unique_ptr<v8::Task>(task));
+    }
+
+    void Platform::CallDelayedOnForegroundThread(v8::Isolate* isolate,
+                                                 v8::Task* task,
+                                                 double delayInSeconds)
+    {
+        GetRunner(isolate, true)
+            ->PostDelayedTask(std::unique_ptr<v8::Task>(task), delayInSeconds);
+    }
+
+    void Platform::CallIdleOnForegroundThread(v8::Isolate* isolate,
+                                              v8::IdleTask* task)
+    {
+        GetRunner(isolate, true)
+            ->PostIdleTask(std::unique_ptr<v8::IdleTask>(task));
+    }
+
+    bool Platform::IdleTasksEnabled(v8::Isolate* isolate) { return true; }
+
+    double Platform::MonotonicallyIncreasingTime()
+    {
+        return std::chrono::duration<double>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    double Platform::CurrentClockTimeMillis()
+    {
+        return std::chrono::duration<double, std::milli>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    v8::TracingController* Platform::GetTracingController()
+    {
+        return m_TracingController.get();
+    }
+
+    std::shared_ptr<ForegroundTaskRunner>
+    Platform::GetRunner(v8::Isolate* isolate, bool create)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        auto it = m_ForegroundTaskRunners.find(isolate);
+        if (it != m_ForegroundTaskRunners.end())
+            return it->second;
+
+        if (!create)
+            return nullptr;
+
+        std::shared_ptr<ForegroundTaskRunner> runner =
+            std::make_shared<ForegroundTaskRunner>();
+        m_ForegroundTaskRunners[isolate] = runner;
+        return runner;
+    }
+
+} // namespace scripter
@@ -0,0 +1,172 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+
+#include "scripter/utils/TaskScheduler.h"
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <v8-platform.h>
+#include <v8.h>
+
+namespace scripter {
+
+    /**
+     * ForegroundTaskRunner
+     *
+     * Queues the tasks V8 wants to run on the thread that owns an isolate,
+     * the tasks are only run when the engine pumps its event loop
+     */
+    class ForegroundTaskRunner : public v8::TaskRunner
+    {
+    private:
+        std::mutex m_Mutex;
+        std::deque<std::unique_ptr<v8::Task>> m_Tasks;
+        std::multimap<double, std::unique_ptr<v8::Task>> m_DelayedTasks;
+        std::deque<std::unique_ptr<v8::IdleTask>> m_IdleTasks;
+        bool m_Terminated;
+
+    public:
+        ForegroundTaskRunner();
+
+        virtual void PostTask(std::unique_ptr<v8::Task> task) override;
+        virtual void
+        PostNonNestableTask(std::unique_ptr<v8::Task> task) override;
+        virtual void PostDelayedTask(std::unique_ptr<v8::Task> task,
+                                     double delayInSeconds) override;
+        virtual void PostIdleTask(std::unique_ptr<v8::IdleTask> task) override;
+
+        virtual bool IdleTasksEnabled() override { return true; }
+        virtual bool NonNestableTasksEnabled() const override { return true; }
+
+        /**
+         * Takes all the tasks that are ready to run, delayed tasks are ready
+         * when their delay has passed
+         */
+        std::deque<std::unique_ptr<v8::Task>> TakeTasks(double now);
+        std::unique_ptr<v8::IdleTask> PopIdleTask();
+
+        bool HasIdleTasks();
+
+        /**
+         * Drops all the queued tasks and ignores the tasks posted after this
+         */
+        void Terminate();
+    };
+
+    /**
+     * Platform
+     *
+     * Scripter's implementation of the V8 platform, the background tasks of
+     * V8 and Scripter's own async work share one work stealing scheduler but
+     * Scripter's work and the tasks V8 blocks on are run before the rest of
+     * V8's background tasks
+     */
+    class Platform : public v8::Platform
+    {
+    private:
+        TaskScheduler* m_Scheduler;
+        std::unique_ptr<v8::TracingController> m_TracingController;
+
+        std::mutex m_Mutex;
+        std::unordered_map<v8::Isolate*, std::shared_ptr<ForegroundTaskRunner>>
+            m_ForegroundTaskRunners;
+
+    public:
+        /**
+         * Constructor
+         * @param workerCount the number of worker threads, 0 uses the number
+         * of cores
+         * @param pinWorkers pins every worker thread to its own core
+         * @param tracingController the controller V8 records trace events to
+         */
+        Platform(int32 workerCount, bool pinWorkers,
+                 std::unique_ptr<v8::TracingController> tracingController);
+        virtual ~Platform();
+
+        /**
+         * Runs the foreground tasks of an isolate that are ready, returns
+         * true if any task was run
+         */
+        bool RunForegroundTasks(v8::Isolate* isolate);
+
+        /**
+         * Runs the idle tasks of an isolate until the idle time is used up,
+         * returns true if there are idle tasks left
+         */
+        bool RunIdleTasks(v8::Isolate* isolate, double idleTimeInSeconds);
+
+        /**
+         * Drops the foreground tasks of an isolate, called after the isolate
+         * is disposed so a runner V8 asks for during the teardown isn't left
+         * behind for the next isolate at the same address
+         */
+        void UnregisterIsolate(v8::Isolate* isolate);
+
+        /**
+         * Runs a task from Scripter on a worker thread
+         */
+        void PostBackgroundTask(std::function<void()> task);
+
+        virtual int NumberOfWorkerThreads() override;
+
+        virtual std::shared_ptr<v8::TaskRunner>
+        GetForegroundTaskRunner(v8::Isolate* isolate) override;
+
+        virtual void
+        CallOnWorkerThread(std::unique_ptr<v8::Task> task) override;
+        virtual void
+        CallBlockingTaskOnWorkerThread(std::unique_ptr<v8::Task> task) override;
+        virtual void
+        CallDelayedOnWorkerThread(std::unique_ptr<v8::Task> task,
+                                  double delayInSeconds) override;
+
+        virtual void CallOnForegroundThread(v8::Isolate* isolate,
+                                            v8::Task* task) override;
+        virtual void CallDelayedOnForegroundThread(v8::Isolate* isolate,
+                                                   v8::Task* task,
+                                                   double delayInSeconds)
+            override;
+        virtual void CallIdleOnForegroundThread(v8::Isolate* isolate,
+                                                v8::IdleTask* task) override;
+        virtual bool IdleTasksEnabled(v8::Isolate* isolate) override;
+
+        virtual double MonotonicallyIncreasingTime() override;
+        virtual double CurrentClockTimeMillis() override;
+
+        virtual v8::TracingController* GetTracingController() override;
+
+    private:
+        std::shared_ptr<ForegroundTaskRunner>
+        GetRunner(v8::Isolate* isolate, bool create);
+    };
+
+} // namespace scripter
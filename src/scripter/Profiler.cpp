@@ -0,0 +1,342 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/Profiler.h"
+
+#include "scripter/Engine.h"
+#include "scripter/Logger.h"
+
+#include "scripter/utils/Json.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace scripter {
+
+    static const char* s_SamplingReportName = "scripter-sampling-report";
+
+    static void AppendProfileNode(String& out, const v8::CpuProfileNode* node)
+    {
+        // NOTE(patrik): V8 uses 1 based line and column numbers and 0 for no
+        // info, DevTools expects 0 based numbers and -1 for no info
+        out += "{\"id\":" + std::to_string(node->GetNodeId());
+        out += ",\"callFrame\":{\"functionName\":";
+        Json::AppendString(out, node->GetFunctionNameStr());
+        out += ",\"scriptId\":\"" + std::to_string(node->GetScriptId()) + "\"";
+        out += ",\"url\":";
+        Json::AppendString(out, node->GetScriptResourceNameStr());
+        out += ",\"lineNumber\":" + std::to_string(node->GetLineNumber() - 1);
+        out += ",\"columnNumber\":" +
+               std::to_string(node->GetColumnNumber() - 1);
+        out += "},\"hitCount\":" + std::to_string(node->GetHitCount());
+
+        int32 childrenCount = node->GetChildrenCount();
+        if (childrenCount > 0)
+        {
+            out += ",\"children\":[";
+            for (int32 i = 0; i < childrenCount; i++)
+            {
+                if (i > 0)
+                    out += ',';
+                out += std::to_string(node->GetChild(i)->GetNodeId());
+            }
+            out += ']';
+        }
+
+        out += '}';
+    }
+
+    Profiler::Profiler(Engine* engine)
+        : m_Engine(engine), m_SamplingReport(false), m_ReportIntervalMs(0),
+          m_ReportTopCount(0)
+    {
+        m_CpuProfiler = v8::CpuProfiler::New(engine->GetIsolate());
+    }
+
+    Profiler::~Profiler()
+    {
+        v8::HandleScope handleScope(m_Engine->GetIsolate());
+
+        // NOTE(patrik): Stop the profiles still running so the sampler
+        // thread is shut down before the profiler is disposed
+        for (const String& name : m_ActiveProfiles)
+        {
+            v8::CpuProfile* profile =
+                m_CpuProfiler->StopProfiling(m_Engine->CreateString(name));
+            if (profile)
+                profile->Delete();
+        }
+
+        m_ActiveProfiles.clear();
+        m_CpuProfiler->Dispose();
+    }
+
+    bool Profiler::Start(const String& name, int32 samplingIntervalUs)
+    {
+        if (m_ActiveProfiles.find(name) != m_ActiveProfiles.end())
+        {
+            SCRIPTER_LOG_WARNING("Profile '{0}' is already running", name);
+            return false;
+        }
+
+        if (m_ActiveProfiles.empty())
+            m_CpuProfiler->SetSamplingInterval(samplingIntervalUs);
+
+        v8::HandleScope handleScope(m_Engine->GetIsolate());
+        m_CpuProfiler->StartProfiling(m_Engine->CreateString(name), true);
+        m_ActiveProfiles.insert(name);
+
+        return true;
+    }
+
+    bool Profiler::Stop(const String& name, const String& outputPath)
+    {
+        if (m_ActiveProfiles.erase(name) == 0)
+        {
+            SCRIPTER_LOG_WARNING("Profile '{0}' is not running", name);
+            return false;
+        }
+
+        v8::HandleScope handleScope(m_Engine->GetIsolate());
+        v8::CpuProfile* profile =
+            m_CpuProfiler->StopProfiling(m_Engine->CreateString(name));
+        if (!profile)
+            return false;
+
+        bool result = WriteCpuProfile(profile, outputPath);
+        profile->Delete();
+
+        return result;
+    }
+
+    void Profiler::StartSamplingReport(int32 samplingIntervalUs,
+                                       int32 reportIntervalMs, int32 topCount)
+    {
+        if (m_SamplingReport)
+            StopSamplingReport();
+
+        m_ReportIntervalMs = reportIntervalMs;
+        m_ReportTopCount = topCount;
+
+        if (Start(s_SamplingReportName, samplingIntervalUs))
+        {
+            m_SamplingReport = true;
+            m_ReportStart = std::chrono::steady_clock::now();
+        }
+    }
+
+    void Profiler::StopSamplingReport()
+    {
+        if (!m_SamplingReport)
+            return;
+
+        m_SamplingReport = false;
+        m_ActiveProfiles.erase(s_SamplingReportName);
+
+        v8::HandleScope handleScope(m_Engine->GetIsolate());
+        v8::CpuProfile* profile = m_CpuProfiler->StopProfiling(
+            m_Engine->CreateString(s_SamplingReportName));
+        if (profile)
+            profile->Delete();
+    }
+
+    void Profiler::UpdateSamplingReport()
+    {
+        if (!m_SamplingReport)
+            return;
+
+        auto now = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            now - m_ReportStart);
+        if (elapsed.count() < m_ReportIntervalMs)
+            return;
+
+        v8::HandleScope handleScope(m_Engine->GetIsolate());
+        v8::Local<v8::String> title =
+            m_Engine->CreateString(s_SamplingReportName);
+
+        v8::CpuProfile* profile = m_CpuProfiler->StopProfiling(title);
+        if (profile)
+        {
+            LogSamplingReport(profile);
+            profile->Delete();
+        }
+
+        // NOTE(patrik): The sampling interval is kept from the first start
+        m_CpuProfiler->StartProfiling(title, false);
+        m_ReportStart = now;
+    }
+
+    void Profiler::LogSamplingReport(const v8::CpuProfile* profile)
+    {
+        struct FunctionHits
+        {
+            String name;
+            String url;
+            int32 line;
+            uint32 hits;
+        };
+
+        std::unordered_map<String, FunctionHits> functions;
+        uint64 totalHits = 0;
+
+        std::vector<const v8::CpuProfileNode*> stack;
+        stack.push_back(profile->GetTopDownRoot());
+
+        while (!stack.empty())
+        {
+            const v8::CpuProfileNode* node = stack.back();
+            stack.pop_back();
+
+            for (int32 i = 0; i < node->GetChildrenCount(); i++)
+                stack.push_back(node->GetChild(i));
+
+            uint32 hits = node->GetHitCount();
+            if (hits == 0)
+                continue;
+
+            totalHits += hits;
+
+            String name = node->GetFunctionNameStr();
+            if (name.empty())
+                name = "(anonymous)";
+
+            String url = node->GetScriptResourceNameStr();
+            int32 line = node->GetLineNumber();
+
+            String key = name + "@" + url + ":" + std::to_string(line);
+            auto it = functions.find(key);
+            if (it == functions.end())
+                functions[key] = {name, url, line, hits};
+            else
+                it->second.hits += hits;
+        }
+
+        if (totalHits == 0)
+            return;
+
+        std::vector<FunctionHits> sorted;
+        sorted.reserve(functions.size());
+        for (auto& function : functions)
+            sorted.push_back(function.second);
+
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const FunctionHits& a, const FunctionHits& b) {
+                      return a.hits > b.hits;
+                  });
+
+        size_t count = std::min(sorted.size(), (size_t)m_ReportTopCount);
+
+        SCRIPTER_LOG_INFO("------------ SAMPLING REPORT ({0} samples) "
+                          "------------",
+                          totalHits);
+        for (size_t i = 0; i < count; i++)
+        {
+            const FunctionHits& function = sorted[i];
+            double percent = (double)function.hits * 100.0 / totalHits;
+
+            if (function.url.empty())
+            {
+                SCRIPTER_LOG_INFO("{0:>6.2f}% {1}", percent, function.name);
+            }
+            else
+            {
+                SCRIPTER_LOG_INFO("{0:>6.2f}% {1} ({2}:{3})", percent,
+                                  function.name, function.url, function.line);
+            }
+        }
+    }
+
+    bool Profiler::WriteCpuProfile(const v8::CpuProfile* profile,
+                                   const String& outputPath)
+    {
+        String out;
+        out += "{\"nodes\":[";
+
+        std::vector<const v8::CpuProfileNode*> stack;
+        stack.push_back(profile->GetTopDownRoot());
+
+        bool first = true;
+        while (!stack.empty())
+        {
+            const v8::CpuProfileNode* node = stack.back();
+            stack.pop_back();
+
+            if (!first)
+                out += ',';
+            first = false;
+
+            AppendProfileNode(out, node);
+
+            for (int32 i = node->GetChildrenCount() - 1; i >= 0; i--)
+                stack.push_back(node->GetChild(i));
+        }
+
+        out += "],\"startTime\":" + std::to_string(profile->GetStartTime());
+        out += ",\"endTime\":" + std::to_string(profile->GetEndTime());
+
+        int32 samplesCount = profile->GetSamplesCount();
+
+        out += ",\"samples\":[";
+        for (int32 i = 0; i < samplesCount; i++)
+        {
+            if (i > 0)
+                out += ',';
+            out += std::to_string(profile->GetSample(i)->GetNodeId());
+        }
+
+        out += "],\"timeDeltas\":[";
+        int64 lastTimestamp = profile->GetStartTime();
+        for (int32 i = 0; i < samplesCount; i++)
+        {
+            int64 timestamp = profile->GetSampleTimestamp(i);
+            if (i > 0)
+                out += ',';
+            out += std::to_string(timestamp - lastTimestamp);
+            lastTimestamp = timestamp;
+        }
+        out += "]}";
+
+        FILE* file = fopen(outputPath.c_str(), "wb");
+        if (!file)
+        {
+            SCRIPTER_LOG_ERROR("Could not open '{0}' for writing", outputPath);
+            return false;
+        }
+
+        size_t written = fwrite(out.data(), 1, out.size(), file);
+        fclose(file);
+
+        if (written != out.size())
+        {
+            SCRIPTER_LOG_ERROR("Could not write the profile '{0}'", outputPath);
+            return false;
+        }
+
+        SCRIPTER_LOG_INFO("Wrote cpu profile '{0}' with {1} samples",
+                          outputPath, samplesCount);
+        return true;
+    }
+
+} // namespace scripter
@@ -0,0 +1,95 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+
+#include <chrono>
+#include <unordered_set>
+
+#include <v8-profiler.h>
+#include <v8.h>
+
+namespace scripter {
+
+    class Engine;
+
+    /**
+     * Profiler
+     *
+     * Wrapper around V8's cpu profiler, used by the engine to record profiles
+     * that can be opened in Chrome DevTools and for the always on sampling
+     * report
+     */
+    class Profiler
+    {
+    private:
+        Engine* m_Engine;
+        v8::CpuProfiler* m_CpuProfiler;
+        std::unordered_set<String> m_ActiveProfiles;
+
+        bool m_SamplingReport;
+        int32 m_ReportIntervalMs;
+        int32 m_ReportTopCount;
+        std::chrono::steady_clock::time_point m_ReportStart;
+
+    public:
+        Profiler(Engine* engine);
+        ~Profiler();
+
+        /**
+         * Starts recording a profile, the sampling interval is only changed
+         * if no other profile is running
+         */
+        bool Start(const String& name, int32 samplingIntervalUs);
+
+        /**
+         * Stops a profile and writes it as a .cpuprofile file
+         */
+        bool Stop(const String& name, const String& outputPath);
+
+        void StartSamplingReport(int32 samplingIntervalUs,
+                                 int32 reportIntervalMs, int32 topCount);
+        void StopSamplingReport();
+
+        /**
+         * Logs the hottest functions if the report interval has passed and
+         * starts a new sampling period
+         */
+        void UpdateSamplingReport();
+
+        bool IsProfiling() const { return !m_ActiveProfiles.empty(); }
+
+    public:
+        /**
+         * Writes a profile in the Chrome DevTools .cpuprofile format
+         */
+        static bool WriteCpuProfile(const v8::CpuProfile* profile,
+                                    const String& outputPath);
+
+    private:
+        void LogSamplingReport(const v8::CpuProfile* profile);
+    };
+
+} // namespace scripter
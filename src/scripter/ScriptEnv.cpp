@@ -25,12 +25,27 @@
 
 #include "scripter/NativeModuleImporter.h"
 #include "scripter/JavascriptModuleImporter.h"
+#include "scripter/ModuleGraph.h"
+#include "scripter/ModuleRegistry.h"
+#include "scripter/ModulePrefetcher.h"
+#include "scripter/ScriptError.h"
+#include "scripter/SourceStream.h"
 
 #include "scripter/Logger.h"
+#include "scripter/Tracing.h"
 
-#include "scripter/utils/File.h"
+#include "scripter/utils/FileCache.h"
 #include "scripter/utils/Path.h"
 
+#include <string.h>
+
+#include <algorithm>
+#include <future>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace scripter {
 
     JSFUNC(importModule)
@@ -60,10 +75,15 @@ namespace scripter {
         String scriptPath = engine->ConvertValueToString(
             stackTrace->GetFrame(isolate, 0)->GetScriptName());
 
-        module = JavascriptModuleImporter::Get()->ImportModule(
-            engine, moduleName, scriptPath);
+        {
+            SCRIPTER_TRACE_SCOPE("importModule.javascript");
+            module = JavascriptModuleImporter::Get()->ImportModule(
+                engine, moduleName, scriptPath);
+        }
+
         if (!module)
         {
+            SCRIPTER_TRACE_SCOPE("importModule.native");
             module =
                 NativeModuleImporter::Get()->ImportModule(engine, moduleName);
 
@@ -75,12 +95,16 @@ namespace scripter {
             }
         }
 
+        v8::Local<v8::External> data =
+            v8::Local<v8::External>::Cast(args.Data());
+        ScriptEnv* script = (ScriptEnv*)data->Value();
+
+        // NOTE(patrik): The importers hand out a reference to the module that
+        // the script environment gives back when it's reset or deleted
+        script->AddImportedModule(module);
+
         if (loadToGlobal)
         {
-            v8::Local<v8::External> data =
-                v8::Local<v8::External>::Cast(args.Data());
-            ScriptEnv* script = (ScriptEnv*)data->Value();
-
             script->ImportModule(module);
         }
         else
@@ -89,9 +113,27 @@ namespace scripter {
         }
     }
 
+    static void LazyModuleGetter(v8::Local<v8::Name> name,
+                                 const v8::PropertyCallbackInfo<v8::Value>& info)
+    {
+        v8::Local<v8::External> data =
+            v8::Local<v8::External>::Cast(info.Data());
+        Module* module = (Module*)data->Value();
+
+        // NOTE(patrik): V8 replaces the property with the returned value so
+        // the object is only generated once per context
+        info.GetReturnValue().Set(module->GenerateObject());
+    }
+
+    // NOTE(patrik): Index 0 is used by the debugger
+    static const int32 s_EmbedderDataIndex = 1;
+
+    static const size_t s_StreamChunkSize = 64 * 1024;
+
     ScriptEnv::ScriptEnv(Engine* engine) : m_Engine(engine)
     {
         SCRIPTER_ASSERT(engine);
+        SCRIPTER_TRACE_SCOPE("ScriptEnv::CreateContext");
 
         v8::Isolate* isolate = engine->GetIsolate();
         v8::HandleScope scope(isolate);
@@ -105,14 +147,72 @@ namespace scripter {
             isolate, "importModule",
             v8::FunctionTemplate::New(isolate, JSFunc_importModule, data));
 
+        m_GlobalTemplate =
+            v8::Persistent<v8::ObjectTemplate,
+                           v8::CopyablePersistentTraits<v8::ObjectTemplate>>(
+                isolate, globals);
+
+        m_ModuleGraph = new ModuleGraph(engine);
+        m_Bundle = nullptr;
+
         v8::Local<v8::Context> context =
             v8::Context::New(isolate, NULL, globals);
-        m_Context = v8::Persistent<v8::Context,
-                                   v8::CopyablePersistentTraits<v8::Context>>(
-            isolate, context);
+        SetupContext(context);
+    }
+
+    ScriptEnv::~ScriptEnv()
+    {
+        ReleaseImportedModules();
+
+        delete m_ModuleGraph;
+        delete m_Bundle;
+
+        m_Context.Reset();
+        m_GlobalTemplate.Reset();
+    }
+
+    void ScriptEnv::Reset()
+    {
+        SCRIPTER_TRACE_SCOPE("ScriptEnv::Reset");
+
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+        v8::HandleScope handleScope(isolate);
+
+        v8::Local<v8::Context> oldContext = m_Context.Get(isolate);
+        v8::Local<v8::Object> globalProxy = oldContext->Global();
+        oldContext->DetachGlobal();
+
+        // NOTE(patrik): The modules are bound to the old context
+        m_ModuleGraph->Clear();
+        ReleaseImportedModules();
+        m_ScriptPaths.clear();
+
+        v8::Local<v8::Context> context = v8::Context::New(
+            isolate, NULL, m_GlobalTemplate.Get(isolate), globalProxy);
+        SetupContext(context);
+    }
+
+    void ScriptEnv::SetupContext(v8::Local<v8::Context> context)
+    {
+        context->SetAlignedPointerInEmbedderData(s_EmbedderDataIndex, this);
+        m_Context.Reset(m_Engine->GetIsolate(), context);
+    }
+
+    void ScriptEnv::AddImportedModule(Module* module)
+    {
+        m_ImportedModules.push_back(module);
     }
 
-    ScriptEnv::~ScriptEnv() { m_Context.Reset(); }
+    void ScriptEnv::ReleaseImportedModules()
+    {
+        ModuleRegistry* registry = m_Engine->GetModuleRegistry();
+        for (Module* module : m_ImportedModules)
+        {
+            registry->Release(module);
+        }
+
+        m_ImportedModules.clear();
+    }
 
     void ScriptEnv::Enable() { m_Context.Get(m_Engine->GetIsolate())->Enter(); }
 
@@ -144,45 +244,118 @@ namespace scripter {
         v8::Local<v8::Object> globals =
             v8::Local<v8::Object>::Cast(context->Global()->GetPrototype());
 
-        globals->Set(m_Engine->CreateString(module->GetPackageName()),
-                     module->GenerateObject());
+        // NOTE(patrik): Most scripts only use a few of the imported modules
+        // so the module object is generated the first time it's accessed
+        v8::Local<v8::String> name =
+            m_Engine->CreateString(module->GetPackageName());
+        v8::Local<v8::External> data =
+            v8::External::New(m_Engine->GetIsolate(), module);
+
+        globals->SetLazyDataProperty(context, name, LazyModuleGetter, data)
+            .FromJust();
     }
 
     v8::MaybeLocal<v8::Value> ScriptEnv::CompileAndRun(const String& filePath)
     {
+        return CompileAndRunScript(filePath, nullptr);
+    }
+
+    v8::MaybeLocal<v8::Value>
+    ScriptEnv::CompileAndRunScript(const String& filePath, bool* compiled)
+    {
+        SCRIPTER_TRACE_SCOPE("ScriptEnv::CompileAndRun");
+
         v8::Isolate* isolate = m_Engine->GetIsolate();
 
         v8::EscapableHandleScope handleScope(isolate);
         v8::TryCatch tryCatch(isolate);
 
-        String fullFilePath = Path::GetFullPath(filePath);
-        String fileContent = File::ReadFile(fullFilePath);
+        String fullFilePath = ResolveScriptPath(filePath);
+        AddScriptPath(fullFilePath);
 
-        v8::ScriptOrigin origin(
-            m_Engine->CreateString(fullFilePath),
-            v8::Local<v8::Integer>(),         // resource_line_offset
-            v8::Local<v8::Integer>(),         // resource_column_offset
-            v8::False(isolate),               // resource_is_shared_cross_origin
-            v8::Local<v8::Integer>(),         // script_id
-            v8::Local<v8::Value>(),           // source_map_url
-            v8::False(isolate),               // resource_is_opaque
-            v8::Local<v8::Boolean>(),         // is_wasm
-            v8::Local<v8::Boolean>(),         // is_module
-            v8::Local<v8::PrimitiveArray>()); // host_defined_options
+        const Bundle::Entry* bundled =
+            m_Bundle ? m_Bundle->Find(fullFilePath) : nullptr;
 
-        v8::ScriptCompiler::Source source(m_Engine->CreateString(fileContent),
-                                          origin);
+        ModulePrefetcher* prefetcher = m_Engine->GetModulePrefetcher();
+        std::unique_ptr<ModulePrefetcher::Entry> prefetched =
+            prefetcher && !bundled ? prefetcher->Take(fullFilePath) : nullptr;
+
+        v8::MaybeLocal<v8::String> maybeSource;
+        if (bundled)
+        {
+            maybeSource = m_Engine->CreateString(bundled->source,
+                                                 bundled->sourceLength);
+        }
+        else if (prefetched)
+        {
+            maybeSource = m_Engine->CreateString(prefetched->source);
+        }
+        else
+        {
+            std::shared_ptr<const MappedFile> file =
+                FileCache::Read(fullFilePath);
+            if (file)
+            {
+                maybeSource =
+                    m_Engine->CreateString(file->GetData(), file->GetSize());
+            }
+        }
+
+        v8::Local<v8::String> sourceString;
+        if (!maybeSource.ToLocal(&sourceString))
+        {
+            SCRIPTER_LOG_ERROR("Could not read script '{0}'", fullFilePath);
+            return v8::MaybeLocal<v8::Value>();
+        }
+
+        v8::ScriptOrigin origin = CreateScriptOrigin(fullFilePath);
+
+        v8::MaybeLocal<v8::Script> maybeScript;
+        if (bundled && bundled->codeCacheLength > 0)
+        {
+            SCRIPTER_TRACE_SCOPE("ScriptEnv::Compile");
+
+            v8::ScriptCompiler::CachedData* cachedData =
+                new v8::ScriptCompiler::CachedData(
+                    bundled->codeCache, (int)bundled->codeCacheLength,
+                    v8::ScriptCompiler::CachedData::BufferNotOwned);
+
+            v8::ScriptCompiler::Source source(sourceString, origin,
+                                              cachedData);
+            maybeScript = v8::ScriptCompiler::Compile(
+                GetContext(), &source, v8::ScriptCompiler::kConsumeCodeCache);
+        }
+        else if (prefetched && prefetched->streamedSource)
+        {
+            SCRIPTER_TRACE_SCOPE("ScriptEnv::Compile");
+
+            // NOTE(patrik): The script was already parsed on a worker thread
+            maybeScript = v8::ScriptCompiler::Compile(
+                GetContext(), prefetched->streamedSource.get(), sourceString,
+                origin);
+        }
+        else
+        {
+            SCRIPTER_TRACE_SCOPE("ScriptEnv::Compile");
+
+            v8::ScriptCompiler::Source source(sourceString, origin);
+            maybeScript = v8::ScriptCompiler::Compile(GetContext(), &source);
+        }
 
         v8::MaybeLocal<v8::Value> result;
         v8::Local<v8::Script> script;
-        if (!v8::ScriptCompiler::Compile(GetContext(), &source)
-                 .ToLocal(&script))
+        if (!maybeScript.ToLocal(&script))
         {
             if (m_Engine->CheckTryCatch(&tryCatch))
                 return v8::MaybeLocal<v8::Value>();
         }
         else
         {
+            SCRIPTER_TRACE_SCOPE("ScriptEnv::Run");
+
+            if (compiled)
+                *compiled = true;
+
             result = script->Run(m_Context.Get(isolate));
             if (m_Engine->CheckTryCatch(&tryCatch))
                 return v8::MaybeLocal<v8::Value>();
@@ -191,6 +364,242 @@ namespace scripter {
         return handleScope.EscapeMaybe(result);
     }
 
+    v8::MaybeLocal<v8::Value>
+    ScriptEnv::CompileAndRunStreamed(const String& filePath)
+    {
+        SCRIPTER_TRACE_SCOPE("ScriptEnv::CompileAndRunStreamed");
+
+        // NOTE(patrik): A bundled script is already in memory and has its
+        // code cache so there's nothing to stream
+        String fullFilePath = ResolveScriptPath(filePath);
+        if (m_Bundle && m_Bundle->Find(fullFilePath))
+            return CompileAndRun(filePath);
+
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+
+        v8::EscapableHandleScope handleScope(isolate);
+        v8::TryCatch tryCatch(isolate);
+
+        int32 fd = open(fullFilePath.c_str(), O_RDONLY);
+        if (fd == -1)
+        {
+            SCRIPTER_LOG_ERROR("Could not open file '{0}'", filePath);
+            return v8::MaybeLocal<v8::Value>();
+        }
+
+        AddScriptPath(fullFilePath);
+
+        // NOTE(patrik): The streamed source takes the ownership of the stream
+        QueuedSourceStream* stream = new QueuedSourceStream();
+        v8::ScriptCompiler::StreamedSource streamedSource(
+            stream, v8::ScriptCompiler::StreamedSource::UTF8);
+
+        std::unique_ptr<v8::ScriptCompiler::ScriptStreamingTask> task(
+            v8::ScriptCompiler::StartStreamingScript(isolate, &streamedSource));
+
+        // NOTE(patrik): The task is parsed on the platform's workers, this
+        // thread waits for it before compiling so it runs with the high
+        // priority
+        std::promise<void> parsed;
+        if (task)
+        {
+            v8::ScriptCompiler::ScriptStreamingTask* streamingTask = task.get();
+            Engine::PostBackgroundTask([streamingTask, &parsed]() {
+                streamingTask->Run();
+                parsed.set_value();
+            });
+        }
+
+        // NOTE(patrik): V8 still needs the whole source when compiling the
+        // streamed script so the chunks are kept here too
+        String fileContent;
+        std::vector<uint8> buffer(s_StreamChunkSize);
+
+        ssize_t length = 0;
+        while (true)
+        {
+            length = read(fd, buffer.data(), buffer.size());
+            if (length == -1 && errno == EINTR)
+                continue;
+
+            if (length <= 0)
+                break;
+
+            fileContent.append((const char*)buffer.data(), length);
+
+            if (task)
+                stream->Push(buffer.data(), length);
+        }
+
+        int32 readError = length == -1 ? errno : 0;
+
+        close(fd);
+        stream->Finish();
+
+        // NOTE(patrik): The parser is done with the stream once it has seen
+        // the end, a truncated script is never run
+        if (readError != 0)
+        {
+            if (task)
+                parsed.get_future().wait();
+
+            SCRIPTER_LOG_ERROR("Error reading '{0}': {1}", filePath,
+                               strerror(readError));
+            return v8::MaybeLocal<v8::Value>();
+        }
+
+        v8::ScriptOrigin origin = CreateScriptOrigin(fullFilePath);
+
+        v8::MaybeLocal<v8::Script> compiled;
+        if (task)
+        {
+            SCRIPTER_TRACE_SCOPE("ScriptEnv::Compile");
+
+            parsed.get_future().wait();
+
+            compiled = v8::ScriptCompiler::Compile(
+                GetContext(), &streamedSource,
+                m_Engine->CreateString(fileContent), origin);
+        }
+        else
+        {
+            SCRIPTER_TRACE_SCOPE("ScriptEnv::Compile");
+
+            v8::ScriptCompiler::Source source(
+                m_Engine->CreateString(fileContent), origin);
+            compiled = v8::ScriptCompiler::Compile(GetContext(), &source);
+        }
+
+        v8::MaybeLocal<v8::Value> result;
+        v8::Local<v8::Script> script;
+        if (!compiled.ToLocal(&script))
+        {
+            if (m_Engine->CheckTryCatch(&tryCatch))
+                return v8::MaybeLocal<v8::Value>();
+        }
+        else
+        {
+            SCRIPTER_TRACE_SCOPE("ScriptEnv::Run");
+
+            result = script->Run(m_Context.Get(isolate));
+            if (m_Engine->CheckTryCatch(&tryCatch))
+                return v8::MaybeLocal<v8::Value>();
+        }
+
+        return handleScope.EscapeMaybe(result);
+    }
+
+    v8::MaybeLocal<v8::Value>
+    ScriptEnv::CompileAndRunModule(const String& filePath)
+    {
+        SCRIPTER_TRACE_SCOPE("ScriptEnv::CompileAndRunModule");
+
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+
+        v8::EscapableHandleScope handleScope(isolate);
+        v8::TryCatch tryCatch(isolate);
+
+        String fullFilePath = ResolveScriptPath(filePath);
+
+        v8::MaybeLocal<v8::Value> result =
+            m_ModuleGraph->Import(GetContext(), fullFilePath);
+        if (m_Engine->CheckTryCatch(&tryCatch))
+            return v8::MaybeLocal<v8::Value>();
+
+        return handleScope.EscapeMaybe(result);
+    }
+
+    static bool IsSyntaxError(v8::Isolate* isolate,
+                              v8::Local<v8::Value> exception)
+    {
+        if (!exception->IsNativeError())
+            return false;
+
+        v8::String::Utf8Value name(
+            isolate, exception.As<v8::Object>()->GetConstructorName());
+        return *name && strcmp(*name, "SyntaxError") == 0;
+    }
+
+    bool ScriptEnv::Reload(const std::vector<String>& changedPaths)
+    {
+        SCRIPTER_TRACE_SCOPE("ScriptEnv::Reload");
+
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+        v8::HandleScope handleScope(isolate);
+
+        v8::Local<v8::Context> context = GetContext();
+        v8::Context::Scope contextScope(context);
+
+        bool result = true;
+        {
+            v8::TryCatch tryCatch(isolate);
+            if (!m_ModuleGraph->Reload(context, changedPaths))
+            {
+                m_Engine->CheckTryCatch(&tryCatch);
+                result = false;
+            }
+        }
+
+        // NOTE(patrik): The scripts are run in the same context again so the
+        // vars and functions they declare replace the old ones on the global
+        // object. The top level let, const and class bindings live in the
+        // context and V8 can't remove them, so a script that has them fails
+        // the redeclaration check with a SyntaxError before any of it runs.
+        // The failures are told apart by the stage they happened in, not by
+        // the message which V8 can change
+        std::vector<String> scriptPaths = m_ScriptPaths;
+        for (const String& scriptPath : scriptPaths)
+        {
+            if (std::find(changedPaths.begin(), changedPaths.end(),
+                          scriptPath) == changedPaths.end())
+            {
+                continue;
+            }
+
+            bool compiled = false;
+            if (!CompileAndRunScript(scriptPath, &compiled).IsEmpty())
+                continue;
+
+            result = false;
+
+            ScriptError* error = m_Engine->GetLastError();
+            if (!compiled)
+            {
+                SCRIPTER_LOG_ERROR("'{0}' could not be compiled, the old "
+                                   "version is still in use",
+                                   scriptPath);
+            }
+            else if (error && IsSyntaxError(isolate, error->GetException()))
+            {
+                SCRIPTER_LOG_ERROR(
+                    "'{0}' has top level let, const or class declarations "
+                    "and can't be reloaded in place, reset the environment "
+                    "and run it again",
+                    scriptPath);
+            }
+        }
+
+        return result;
+    }
+
+    std::vector<String> ScriptEnv::GetSourcePaths() const
+    {
+        std::vector<String> result = m_ModuleGraph->GetModulePaths();
+        result.insert(result.end(), m_ScriptPaths.begin(),
+                      m_ScriptPaths.end());
+
+        return result;
+    }
+
+    void ScriptEnv::AddScriptPath(const String& filePath)
+    {
+        if (std::find(m_ScriptPaths.begin(), m_ScriptPaths.end(), filePath) ==
+            m_ScriptPaths.end())
+        {
+            m_ScriptPaths.push_back(filePath);
+        }
+    }
+
     v8::Local<v8::Context> ScriptEnv::GetContext()
     {
         v8::EscapableHandleScope handleScope(m_Engine->GetIsolate());
@@ -224,4 +633,57 @@ namespace scripter {
         return handleScope.EscapeMaybe(v8::MaybeLocal<v8::Function>(result));
     }
 
+    bool ScriptEnv::LoadBundle(const String& bundlePath)
+    {
+        Bundle* bundle = Bundle::Open(bundlePath);
+        if (!bundle)
+            return false;
+
+        delete m_Bundle;
+        m_Bundle = bundle;
+
+        m_ModuleGraph->SetBundle(m_Bundle);
+        return true;
+    }
+
+    String ScriptEnv::ResolveScriptPath(const String& filePath)
+    {
+        if (m_Bundle)
+        {
+            String absolutePath = Path::GetAbsolutePath(filePath);
+            if (m_Bundle->Find(absolutePath))
+                return absolutePath;
+        }
+
+        // NOTE(patrik): A missing file keeps its path so the error names it
+        String fullPath = Path::GetFullPath(filePath);
+        if (fullPath.empty())
+            return Path::GetAbsolutePath(filePath);
+
+        return fullPath;
+    }
+
+    v8::ScriptOrigin ScriptEnv::CreateScriptOrigin(const String& filePath)
+    {
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+
+        return v8::ScriptOrigin(
+            m_Engine->CreateString(filePath),
+            v8::Local<v8::Integer>(),         // resource_line_offset
+            v8::Local<v8::Integer>(),         // resource_column_offset
+            v8::False(isolate),               // resource_is_shared_cross_origin
+            v8::Local<v8::Integer>(),         // script_id
+            v8::Local<v8::Value>(),           // source_map_url
+            v8::False(isolate),               // resource_is_opaque
+            v8::Local<v8::Boolean>(),         // is_wasm
+            v8::Local<v8::Boolean>(),         // is_module
+            v8::Local<v8::PrimitiveArray>()); // host_defined_options
+    }
+
+    ScriptEnv* ScriptEnv::FromContext(v8::Local<v8::Context> context)
+    {
+        return (ScriptEnv*)context->GetAlignedPointerFromEmbedderData(
+            s_EmbedderDataIndex);
+    }
+
 } // namespace scripter
\ No newline at end of file
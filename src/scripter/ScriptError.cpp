@@ -0,0 +1,216 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/ScriptError.h"
+
+#include "scripter/Engine.h"
+#include "scripter/Logger.h"
+
+namespace scripter {
+
+    ScriptError::ScriptError(Engine* engine)
+        : m_Engine(engine), m_Converted(false), m_LineNumber(0), m_Column(0),
+          m_FramesConverted(false)
+    {
+    }
+
+    ScriptError::ScriptError(Engine* engine, v8::TryCatch* tryCatch)
+        : ScriptError(engine)
+    {
+        Set(tryCatch);
+    }
+
+    ScriptError::~ScriptError() { Clear(); }
+
+    void ScriptError::Set(v8::TryCatch* tryCatch)
+    {
+        SCRIPTER_ASSERT(tryCatch);
+
+        Clear();
+
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+        m_Context.Reset(isolate, isolate->GetCurrentContext());
+        m_Exception.Reset(isolate, tryCatch->Exception());
+
+        v8::Local<v8::Message> message = tryCatch->Message();
+        if (!message.IsEmpty())
+            m_Message.Reset(isolate, message);
+    }
+
+    void ScriptError::Clear()
+    {
+        m_Context.Reset();
+        m_Exception.Reset();
+        m_Message.Reset();
+
+        // NOTE(patrik): The strings keep their memory for the next error
+        m_Converted = false;
+        m_Text.clear();
+        m_ScriptName.clear();
+        m_SourceLine.clear();
+        m_LineNumber = 0;
+        m_Column = 0;
+
+        m_FramesConverted = false;
+        m_Frames.clear();
+    }
+
+    v8::Local<v8::Value> ScriptError::GetException()
+    {
+        return m_Exception.Get(m_Engine->GetIsolate());
+    }
+
+    const String& ScriptError::GetText()
+    {
+        Convert();
+        return m_Text;
+    }
+
+    const String& ScriptError::GetScriptName()
+    {
+        Convert();
+        return m_ScriptName;
+    }
+
+    const String& ScriptError::GetSourceLine()
+    {
+        Convert();
+        return m_SourceLine;
+    }
+
+    int32 ScriptError::GetLineNumber()
+    {
+        Convert();
+        return m_LineNumber;
+    }
+
+    int32 ScriptError::GetColumn()
+    {
+        Convert();
+        return m_Column;
+    }
+
+    const std::vector<ScriptErrorFrame>& ScriptError::GetFrames()
+    {
+        if (m_FramesConverted)
+            return m_Frames;
+
+        m_FramesConverted = true;
+        if (m_Message.IsEmpty())
+            return m_Frames;
+
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+        v8::HandleScope handleScope(isolate);
+        v8::Context::Scope contextScope(m_Context.Get(isolate));
+
+        v8::Local<v8::StackTrace> stackTrace =
+            m_Message.Get(isolate)->GetStackTrace();
+        if (stackTrace.IsEmpty())
+            return m_Frames;
+
+        m_Frames.reserve(stackTrace->GetFrameCount());
+        for (int32 i = 0; i < stackTrace->GetFrameCount(); i++)
+        {
+            v8::Local<v8::StackFrame> frame = stackTrace->GetFrame(isolate, i);
+
+            ScriptErrorFrame result;
+            result.function =
+                m_Engine->ConvertValueToString(frame->GetFunctionName());
+            result.scriptName =
+                m_Engine->ConvertValueToString(frame->GetScriptName());
+            result.lineNumber = frame->GetLineNumber();
+            result.column = frame->GetColumn();
+            m_Frames.push_back(result);
+        }
+
+        return m_Frames;
+    }
+
+    String ScriptError::Format()
+    {
+        Convert();
+
+        String result;
+        result += "------------ JAVASCRIPT EXCEPTION ------------\n";
+
+        const std::vector<ScriptErrorFrame>& frames = GetFrames();
+        if (frames.size() > 1 && !frames[0].function.empty())
+            result += "Function - " + frames[0].function + "\n";
+
+        result += "File - " + m_ScriptName + ":" +
+                  std::to_string(m_LineNumber) + ":" +
+                  std::to_string(m_Column) + "\n";
+        result += "Code - " + m_SourceLine + "\n";
+        result += "Message - " + m_Text + "\n";
+
+        result += "-- Stacktrace --\n";
+        for (const ScriptErrorFrame& frame : frames)
+        {
+            String location = frame.scriptName + ":" +
+                              std::to_string(frame.lineNumber) + ":" +
+                              std::to_string(frame.column);
+
+            if (frame.function.empty())
+                result += "\tat " + location + "\n";
+            else
+                result += "\tat " + frame.function + " (" + location + ")\n";
+        }
+
+        result += "----------------------------------------------";
+        return result;
+    }
+
+    void ScriptError::Log() { SCRIPTER_LOG_ERROR("{0}", Format()); }
+
+    void ScriptError::Convert()
+    {
+        if (m_Converted)
+            return;
+
+        m_Converted = true;
+
+        // NOTE(patrik): The error can be looked at after the context has been
+        // exited so the context it was thrown in is entered again
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+        v8::HandleScope handleScope(isolate);
+        v8::Local<v8::Context> context = m_Context.Get(isolate);
+        v8::Context::Scope contextScope(context);
+
+        m_Text = m_Engine->ConvertValueToString(m_Exception.Get(isolate));
+
+        if (m_Message.IsEmpty())
+            return;
+
+        v8::Local<v8::Message> message = m_Message.Get(isolate);
+
+        m_ScriptName =
+            m_Engine->ConvertValueToString(message->GetScriptResourceName());
+        m_LineNumber = message->GetLineNumber(context).FromMaybe(0);
+        m_Column = message->GetStartColumn(context).FromMaybe(0);
+
+        v8::Local<v8::String> sourceLine;
+        if (message->GetSourceLine(context).ToLocal(&sourceLine))
+            m_SourceLine = m_Engine->ConvertValueToString(sourceLine);
+    }
+
+} // namespace scripter
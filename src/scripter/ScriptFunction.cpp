@@ -0,0 +1,67 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/ScriptFunction.h"
+
+namespace scripter {
+
+    ScriptFunction::ScriptFunction(ScriptEnv* env,
+                                   v8::Local<v8::Function> function)
+        : m_Env(env)
+    {
+        SCRIPTER_ASSERT(env);
+
+        m_Engine = env->GetEngine();
+        m_Function = v8::Persistent<v8::Function,
+                                    v8::CopyablePersistentTraits<v8::Function>>(
+            m_Engine->GetIsolate(), function);
+    }
+
+    ScriptFunction::~ScriptFunction() { m_Function.Reset(); }
+
+    v8::MaybeLocal<v8::Value>
+    ScriptFunction::Invoke(int32 argc, v8::Local<v8::Value> argv[])
+    {
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+
+        v8::EscapableHandleScope handleScope(isolate);
+        v8::Local<v8::Context> context = m_Env->GetContext();
+        v8::Context::Scope contextScope(context);
+        v8::TryCatch tryCatch(isolate);
+
+        v8::MaybeLocal<v8::Value> result = m_Function.Get(isolate)->Call(
+            context, v8::Undefined(isolate), argc, argv);
+        if (m_Engine->CheckTryCatch(&tryCatch))
+            return v8::MaybeLocal<v8::Value>();
+
+        return handleScope.EscapeMaybe(result);
+    }
+
+    v8::Local<v8::Function> ScriptFunction::GetFunction()
+    {
+        v8::EscapableHandleScope handleScope(m_Engine->GetIsolate());
+
+        return handleScope.Escape(m_Function.Get(m_Engine->GetIsolate()));
+    }
+
+} // namespace scripter
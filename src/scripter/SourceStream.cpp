@@ -0,0 +1,110 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/SourceStream.h"
+
+#include <string.h>
+
+namespace scripter {
+
+    // NOTE(patrik): V8 takes the ownership of every chunk so the source is
+    // copied in chunks instead of handed over in one piece
+    static const size_t s_ChunkSize = 64 * 1024;
+
+    StringSourceStream::StringSourceStream(const String& source)
+        : m_Source(source), m_Offset(0)
+    {
+    }
+
+    StringSourceStream::~StringSourceStream() {}
+
+    size_t StringSourceStream::GetMoreData(const uint8_t** src)
+    {
+        size_t length = m_Source.length() - m_Offset;
+        if (length == 0)
+            return 0;
+
+        if (length > s_ChunkSize)
+            length = s_ChunkSize;
+
+        uint8* chunk = new uint8[length];
+        memcpy(chunk, m_Source.data() + m_Offset, length);
+        m_Offset += length;
+
+        *src = chunk;
+        return length;
+    }
+
+    QueuedSourceStream::QueuedSourceStream() : m_Finished(false) {}
+
+    QueuedSourceStream::~QueuedSourceStream()
+    {
+        for (auto& chunk : m_Chunks)
+        {
+            delete[] chunk.first;
+        }
+    }
+
+    void QueuedSourceStream::Push(const uint8* data, size_t length)
+    {
+        if (length == 0)
+            return;
+
+        uint8* chunk = new uint8[length];
+        memcpy(chunk, data, length);
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Chunks.push_back(std::make_pair(chunk, length));
+        }
+
+        m_Condition.notify_one();
+    }
+
+    void QueuedSourceStream::Finish()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Finished = true;
+        }
+
+        m_Condition.notify_one();
+    }
+
+    size_t QueuedSourceStream::GetMoreData(const uint8_t** src)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Condition.wait(lock,
+                         [this]() { return m_Finished || !m_Chunks.empty(); });
+
+        if (m_Chunks.empty())
+            return 0;
+
+        std::pair<uint8*, size_t> chunk = m_Chunks.front();
+        m_Chunks.pop_front();
+
+        *src = chunk.first;
+        return chunk.second;
+    }
+
+} // namespace scripter
@@ -0,0 +1,88 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+#include <v8.h>
+
+namespace scripter {
+
+    /**
+     * StringSourceStream
+     *
+     * Streams a script that is already in memory to V8 so it can be parsed on
+     * a background thread, the string needs to outlive the stream
+     */
+    class StringSourceStream : public v8::ScriptCompiler::ExternalSourceStream
+    {
+    private:
+        const String& m_Source;
+        size_t m_Offset;
+
+    public:
+        StringSourceStream(const String& source);
+        ~StringSourceStream();
+
+        virtual size_t GetMoreData(const uint8_t** src) override;
+    };
+
+    /**
+     * QueuedSourceStream
+     *
+     * A stream where the chunks are pushed from one thread while V8 parses
+     * them on another, GetMoreData blocks until there's a chunk or the stream
+     * is finished
+     */
+    class QueuedSourceStream : public v8::ScriptCompiler::ExternalSourceStream
+    {
+    private:
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        std::deque<std::pair<uint8*, size_t>> m_Chunks;
+        bool m_Finished;
+
+    public:
+        QueuedSourceStream();
+        ~QueuedSourceStream();
+
+        /**
+         * Copies the data and queues it for V8
+         */
+        void Push(const uint8* data, size_t length);
+
+        /**
+         * Marks the end of the data
+         */
+        void Finish();
+
+        virtual size_t GetMoreData(const uint8_t** src) override;
+    };
+
+} // namespace scripter
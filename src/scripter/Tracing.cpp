@@ -0,0 +1,417 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/Tracing.h"
+
+#include "scripter/Logger.h"
+
+#include "scripter/utils/Json.h"
+
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <libplatform/v8-tracing.h>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace scripter {
+
+    using v8::platform::tracing::TraceBuffer;
+    using v8::platform::tracing::TraceConfig;
+    using v8::platform::tracing::TraceObject;
+    using v8::platform::tracing::TraceWriter;
+    using v8::platform::tracing::TracingController;
+
+    // NOTE(patrik): These match the argument types in V8's trace-event.h,
+    // the header is not public
+    enum TraceValueType
+    {
+        TRACE_VALUE_BOOL = 1,
+        TRACE_VALUE_UINT = 2,
+        TRACE_VALUE_INT = 3,
+        TRACE_VALUE_DOUBLE = 4,
+        TRACE_VALUE_POINTER = 5,
+        TRACE_VALUE_STRING = 6,
+        TRACE_VALUE_COPY_STRING = 7,
+        TRACE_VALUE_CONVERTABLE = 8,
+    };
+
+    static const uint32 s_ThreadBufferCapacity = 32 * 1024;
+
+    struct TraceEvent
+    {
+        const char* name;
+        int64 start;
+        int64 duration;
+    };
+
+    /**
+     * The events of one thread, only the owning thread writes to it. The
+     * sequence is odd while an event is being added so Start and Stop can
+     * wait for the thread before touching the buffer
+     */
+    struct ThreadBuffer
+    {
+        int32 tid;
+        std::unique_ptr<TraceEvent[]> events;
+        std::atomic<uint64> next;
+        std::atomic<uint32> sequence;
+    };
+
+    static std::mutex s_Mutex;
+    static std::vector<ThreadBuffer*> s_Buffers;
+    static std::unordered_set<String> s_Names;
+    static thread_local ThreadBuffer* t_Buffer = nullptr;
+
+    static String s_OutputPath;
+    static String s_V8Categories;
+    static TracingController* s_Controller = nullptr;
+    static bool s_V8Tracing = false;
+    static std::vector<String> s_V8Events;
+
+    std::atomic<bool> Tracer::s_Enabled(false);
+
+    /**
+     * Formats the events V8 flushes from its trace buffer, the events are
+     * written to the trace file when the tracer stops
+     */
+    class TraceEventWriter : public TraceWriter
+    {
+    public:
+        virtual void AppendTraceEvent(TraceObject* event) override
+        {
+            String out;
+            out += "{\"pid\":" + std::to_string(event->pid());
+            out += ",\"tid\":" + std::to_string(event->tid());
+            out += ",\"ts\":" + std::to_string(event->ts());
+            out += ",\"tts\":" + std::to_string(event->tts());
+            out += ",\"ph\":\"";
+            out += event->phase();
+            out += "\",\"cat\":";
+            Json::AppendString(out, TracingController::GetCategoryGroupName(
+                                        event->category_enabled_flag()));
+            out += ",\"name\":";
+            Json::AppendString(out, event->name());
+            out += ",\"dur\":" + std::to_string(event->duration());
+            out += ",\"tdur\":" + std::to_string(event->cpu_duration());
+
+            if (event->id() != 0)
+            {
+                char buffer[32];
+                snprintf(buffer, sizeof(buffer), "\"0x%llx\"",
+                         (unsigned long long)event->id());
+                out += ",\"id\":";
+                out += buffer;
+            }
+
+            if (event->scope())
+            {
+                out += ",\"scope\":";
+                Json::AppendString(out, event->scope());
+            }
+
+            out += ",\"args\":{";
+            for (int32 i = 0; i < event->num_args(); i++)
+            {
+                if (i > 0)
+                    out += ',';
+
+                Json::AppendString(out, event->arg_names()[i]);
+                out += ':';
+                AppendArgValue(out, event, i);
+            }
+            out += "}}";
+
+            s_V8Events.push_back(out);
+        }
+
+        virtual void Flush() override {}
+
+    private:
+        static void AppendArgValue(String& out, TraceObject* event,
+                                   int32 index)
+        {
+            TraceObject::ArgValue value = event->arg_values()[index];
+
+            switch (event->arg_types()[index])
+            {
+                case TRACE_VALUE_BOOL:
+                    out += value.as_bool ? "true" : "false";
+                    break;
+                case TRACE_VALUE_UINT:
+                    out += std::to_string(value.as_uint);
+                    break;
+                case TRACE_VALUE_INT:
+                    out += std::to_string(value.as_int);
+                    break;
+                case TRACE_VALUE_DOUBLE:
+                    out += std::to_string(value.as_double);
+                    break;
+                case TRACE_VALUE_POINTER:
+                {
+                    char buffer[32];
+                    snprintf(buffer, sizeof(buffer), "\"%p\"",
+                             value.as_pointer);
+                    out += buffer;
+                    break;
+                }
+                case TRACE_VALUE_STRING:
+                case TRACE_VALUE_COPY_STRING:
+                    Json::AppendString(out, value.as_string
+                                                ? value.as_string
+                                                : "NULL");
+                    break;
+                case TRACE_VALUE_CONVERTABLE:
+                {
+                    auto& convertable = event->arg_convertables()[index];
+                    convertable->AppendAsTraceFormat(&out);
+                    break;
+                }
+                default: out += "null"; break;
+            }
+        }
+    };
+
+    /**
+     * Waits until the owning thread is done adding an event, call this after
+     * tracing has been disabled so the thread can't start a new one
+     */
+    static void WaitForWriter(ThreadBuffer* buffer)
+    {
+        while (buffer->sequence.load(std::memory_order_seq_cst) & 1)
+            std::this_thread::yield();
+    }
+
+    static void StartV8Tracing()
+    {
+        s_Controller->Initialize(TraceBuffer::CreateTraceBufferRingBuffer(
+            TraceBuffer::kRingBufferChunks, new TraceEventWriter()));
+
+        TraceConfig* config = new TraceConfig();
+        config->SetTraceRecordMode(v8::platform::tracing::RECORD_CONTINUOUSLY);
+
+        size_t start = 0;
+        while (start <= s_V8Categories.size())
+        {
+            size_t end = s_V8Categories.find(',', start);
+            if (end == String::npos)
+                end = s_V8Categories.size();
+
+            String category = s_V8Categories.substr(start, end - start);
+            if (!category.empty())
+                config->AddIncludedCategory(category.c_str());
+
+            start = end + 1;
+        }
+
+        // NOTE(patrik): The controller takes the ownership of the config
+        s_Controller->StartTracing(config);
+        s_V8Tracing = true;
+    }
+
+    void Tracer::Start(const String& outputPath, const String& v8Categories)
+    {
+        if (IsEnabled())
+        {
+            SCRIPTER_LOG_WARNING("Tracing is already running");
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            for (ThreadBuffer* buffer : s_Buffers)
+            {
+                WaitForWriter(buffer);
+                buffer->next.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        s_OutputPath = outputPath;
+        s_V8Categories = v8Categories;
+        s_V8Events.clear();
+
+        if (s_Controller)
+            StartV8Tracing();
+
+        s_Enabled.store(true, std::memory_order_seq_cst);
+    }
+
+    bool Tracer::Stop()
+    {
+        if (!IsEnabled())
+            return false;
+
+        // NOTE(patrik): The threads check if tracing is enabled after they
+        // have marked their buffer, so once the flag is cleared a thread is
+        // either already adding an event and is waited for or sees that
+        // tracing is disabled
+        s_Enabled.store(false, std::memory_order_seq_cst);
+
+        if (s_V8Tracing)
+        {
+            // NOTE(patrik): This flushes V8's trace buffer into the writer
+            s_Controller->StopTracing();
+            s_V8Tracing = false;
+        }
+
+        FILE* file = fopen(s_OutputPath.c_str(), "wb");
+        if (!file)
+        {
+            SCRIPTER_LOG_ERROR("Could not open '{0}' for writing",
+                               s_OutputPath);
+            return false;
+        }
+
+        String out = "{\"traceEvents\":[";
+        bool first = true;
+
+        for (const String& event : s_V8Events)
+        {
+            if (!first)
+                out += ',';
+            first = false;
+            out += event;
+        }
+        s_V8Events.clear();
+
+        int32 pid = getpid();
+        size_t eventCount = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            for (ThreadBuffer* buffer : s_Buffers)
+            {
+                WaitForWriter(buffer);
+
+                uint64 next = buffer->next.load(std::memory_order_relaxed);
+                uint64 begin =
+                    next > s_ThreadBufferCapacity
+                        ? next - s_ThreadBufferCapacity
+                        : 0;
+
+                for (uint64 i = begin; i < next; i++)
+                {
+                    const TraceEvent& event =
+                        buffer->events[i % s_ThreadBufferCapacity];
+
+                    if (!first)
+                        out += ',';
+                    first = false;
+
+                    out += "{\"pid\":" + std::to_string(pid);
+                    out += ",\"tid\":" + std::to_string(buffer->tid);
+                    out += ",\"ts\":" + std::to_string(event.start);
+                    out += ",\"dur\":" + std::to_string(event.duration);
+                    out += ",\"ph\":\"X\",\"cat\":\"scripter\",\"name\":";
+                    Json::AppendString(out, event.name);
+                    out += '}';
+
+                    eventCount++;
+                }
+
+                buffer->next.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        out += "],\"displayTimeUnit\":\"ms\"}";
+
+        size_t written = fwrite(out.data(), 1, out.size(), file);
+        fclose(file);
+
+        if (written != out.size())
+        {
+            SCRIPTER_LOG_ERROR("Could not write the trace '{0}'", s_OutputPath);
+            return false;
+        }
+
+        SCRIPTER_LOG_INFO("Wrote trace '{0}' with {1} scripter events",
+                          s_OutputPath, eventCount);
+        return true;
+    }
+
+    void Tracer::AddEvent(const char* name, int64 start, int64 duration)
+    {
+        if (!IsEnabled())
+            return;
+
+        if (!t_Buffer)
+        {
+            ThreadBuffer* buffer = new ThreadBuffer();
+            buffer->tid = (int32)syscall(SYS_gettid);
+            buffer->events.reset(new TraceEvent[s_ThreadBufferCapacity]);
+            buffer->next.store(0, std::memory_order_relaxed);
+            buffer->sequence.store(0, std::memory_order_relaxed);
+
+            // NOTE(patrik): The buffers are never freed so the events of
+            // threads that have exited are still written
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            s_Buffers.push_back(buffer);
+            t_Buffer = buffer;
+        }
+
+        // NOTE(patrik): Tracing can be stopped at any point, it's checked
+        // again after the buffer is marked
+        uint32 sequence = t_Buffer->sequence.load(std::memory_order_relaxed);
+        t_Buffer->sequence.store(sequence + 1, std::memory_order_seq_cst);
+
+        if (s_Enabled.load(std::memory_order_seq_cst))
+        {
+            uint64 index = t_Buffer->next.load(std::memory_order_relaxed);
+            t_Buffer->events[index % s_ThreadBufferCapacity] = {name, start,
+                                                                duration};
+            t_Buffer->next.store(index + 1, std::memory_order_relaxed);
+        }
+
+        t_Buffer->sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    const char* Tracer::InternName(const String& name)
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        return s_Names.insert(name).first->c_str();
+    }
+
+    std::unique_ptr<v8::TracingController> Tracer::CreateTracingController()
+    {
+        std::unique_ptr<TracingController> controller =
+            std::make_unique<TracingController>();
+        s_Controller = controller.get();
+
+        if (IsEnabled())
+            StartV8Tracing();
+
+        return controller;
+    }
+
+    void Tracer::ReleaseTracingController()
+    {
+        if (IsEnabled())
+            Stop();
+
+        s_Controller = nullptr;
+    }
+
+} // namespace scripter
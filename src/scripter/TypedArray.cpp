@@ -0,0 +1,133 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/TypedArray.h"
+
+namespace scripter {
+
+    /**
+     * Keeps the owner of an adopted buffer until the buffer is collected
+     */
+    struct ExternalBuffer
+    {
+        void* owner;
+        TypedArray::FreeBufferFunc freeFunc;
+        size_t byteLength;
+        v8::Global<v8::ArrayBuffer> handle;
+    };
+
+    static void FreeExternalBuffer(const v8::WeakCallbackInfo<void>& data)
+    {
+        ExternalBuffer* buffer = (ExternalBuffer*)data.GetParameter();
+
+        buffer->handle.Reset();
+        buffer->freeFunc(buffer->owner);
+
+        data.GetIsolate()->AdjustAmountOfExternalAllocatedMemory(
+            -(int64)buffer->byteLength);
+        delete buffer;
+    }
+
+    bool TypedArray::GetBytes(v8::Local<v8::Value> value,
+                              ArraySpan<uint8>* result)
+    {
+        if (!value->IsArrayBufferView())
+            return false;
+
+        v8::Local<v8::ArrayBufferView> view = value.As<v8::ArrayBufferView>();
+        uint8* data = (uint8*)view->Buffer()->GetContents().Data();
+
+        result->data = data ? data + view->ByteOffset() : nullptr;
+        result->size = view->ByteLength();
+        return true;
+    }
+
+    bool TypedArray::GetBytesOrUtf8(Engine* engine, v8::Local<v8::Value> value,
+                                    String& buffer, ArraySpan<uint8>* result)
+    {
+        if (GetBytes(value, result))
+            return true;
+
+        if (!value->IsString())
+            return false;
+
+        v8::Isolate* isolate = engine->GetIsolate();
+        v8::Local<v8::String> string = value.As<v8::String>();
+
+        int32 length = string->Utf8Length(isolate);
+        buffer.resize(length);
+        string->WriteUtf8(isolate, &buffer[0], length, nullptr,
+                          v8::String::NO_NULL_TERMINATION |
+                              v8::String::REPLACE_INVALID_UTF8);
+
+        result->data = (uint8*)buffer.data();
+        result->size = buffer.size();
+        return true;
+    }
+
+    void TypedArray::Detach(v8::Local<v8::ArrayBufferView> array)
+    {
+        v8::Local<v8::ArrayBuffer> buffer = array->Buffer();
+        if (buffer->IsDetachable())
+            buffer->Detach();
+    }
+
+    v8::Local<v8::ArrayBuffer> TypedArray::CreateBuffer(Engine* engine,
+                                                        void* data,
+                                                        size_t byteLength,
+                                                        void* owner,
+                                                        FreeBufferFunc freeFunc)
+    {
+        v8::Isolate* isolate = engine->GetIsolate();
+
+        // NOTE(patrik): An empty vector might not have any memory at all
+        if (byteLength == 0)
+        {
+            if (freeFunc)
+                freeFunc(owner);
+
+            return v8::ArrayBuffer::New(isolate, 0);
+        }
+
+        v8::Local<v8::ArrayBuffer> buffer =
+            v8::ArrayBuffer::New(isolate, data, byteLength,
+                                 v8::ArrayBufferCreationMode::kExternalized);
+
+        if (!freeFunc)
+            return buffer;
+
+        // NOTE(patrik): V8 doesn't know about the memory of an externalized
+        // buffer so it's reported to make the GC collect the buffers in time.
+        // Weak callbacks aren't run when the isolate is disposed so the
+        // buffers alive then are leaked
+        ExternalBuffer* external =
+            new ExternalBuffer{owner, freeFunc, byteLength, {}};
+        external->handle.Reset(isolate, buffer);
+        external->handle.SetWeak((void*)external, FreeExternalBuffer,
+                                 v8::WeakCallbackType::kParameter);
+
+        isolate->AdjustAmountOfExternalAllocatedMemory((int64)byteLength);
+        return buffer;
+    }
+
+} // namespace scripter
@@ -140,4 +140,6 @@ namespace scripter { namespace modules {
 
     String Console::GetPackageName() { return "console"; }
 
+    SCRIPTER_REGISTER_NATIVE_MODULE("console", Console);
+
 }} // namespace scripter::modules
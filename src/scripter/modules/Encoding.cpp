@@ -0,0 +1,446 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/modules/Encoding.h"
+
+#include "scripter/TypedArray.h"
+
+#include "scripter/utils/Utf8.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#include <vector>
+
+namespace scripter { namespace modules {
+
+    enum class TextEncoding
+    {
+        Unknown,
+        Utf8,
+        Latin1,
+        Utf16Le
+    };
+
+    static TextEncoding
+    GetEncoding(const v8::FunctionCallbackInfo<v8::Value>& args, int32 index)
+    {
+        if (args.Length() <= index || args[index]->IsUndefined())
+            return TextEncoding::Utf8;
+
+        v8::String::Utf8Value name(args.GetIsolate(), args[index]);
+        if (!*name)
+            return TextEncoding::Unknown;
+
+        String label(*name, name.length());
+        for (char& c : label)
+            c = (char)tolower((uint8)c);
+
+        if (label == "utf-8" || label == "utf8")
+            return TextEncoding::Utf8;
+
+        if (label == "latin1" || label == "iso-8859-1")
+            return TextEncoding::Latin1;
+
+        if (label == "utf-16le" || label == "utf16le" || label == "utf-16")
+            return TextEncoding::Utf16Le;
+
+        return TextEncoding::Unknown;
+    }
+
+    static v8::Local<v8::Uint8Array> NewBytes(v8::Isolate* isolate,
+                                              size_t length, uint8** data)
+    {
+        v8::Local<v8::ArrayBuffer> buffer =
+            v8::ArrayBuffer::New(isolate, length);
+        *data = (uint8*)buffer->GetContents().Data();
+
+        return v8::Uint8Array::New(buffer, 0, length);
+    }
+
+    static v8::Local<v8::Uint8Array> EncodeUtf8(v8::Isolate* isolate,
+                                                v8::Local<v8::String> string)
+    {
+        int32 length = string->Utf8Length(isolate);
+
+        uint8* data;
+        v8::Local<v8::Uint8Array> result = NewBytes(isolate, length, &data);
+
+        // NOTE(patrik): A one byte string with as many bytes as characters is
+        // ASCII so its characters are the bytes
+        if (string->IsOneByte() && length == string->Length())
+        {
+            string->WriteOneByte(isolate, data, 0, length,
+                                 v8::String::NO_NULL_TERMINATION);
+        }
+        else
+        {
+            string->WriteUtf8(isolate, (char*)data, length, nullptr,
+                              v8::String::NO_NULL_TERMINATION |
+                                  v8::String::REPLACE_INVALID_UTF8);
+        }
+
+        return result;
+    }
+
+    static v8::Local<v8::Uint8Array> EncodeLatin1(v8::Isolate* isolate,
+                                                  v8::Local<v8::String> string)
+    {
+        int32 length = string->Length();
+
+        uint8* data;
+        v8::Local<v8::Uint8Array> result = NewBytes(isolate, length, &data);
+
+        if (string->ContainsOnlyOneByte())
+        {
+            string->WriteOneByte(isolate, data, 0, length,
+                                 v8::String::NO_NULL_TERMINATION);
+            return result;
+        }
+
+        // NOTE(patrik): The characters Latin-1 can't hold are written as '?'
+        std::vector<uint16> characters(length);
+        string->Write(isolate, characters.data(), 0, length,
+                      v8::String::NO_NULL_TERMINATION);
+
+        for (int32 i = 0; i < length; i++)
+            data[i] = characters[i] <= 0xFF ? (uint8)characters[i] : '?';
+
+        return result;
+    }
+
+    static v8::Local<v8::Uint8Array> EncodeUtf16(v8::Isolate* isolate,
+                                                 v8::Local<v8::String> string)
+    {
+        int32 length = string->Length();
+
+        uint8* data;
+        v8::Local<v8::Uint8Array> result =
+            NewBytes(isolate, length * sizeof(uint16), &data);
+
+        // NOTE(patrik): The buffer is aligned and x86 is little endian
+        string->Write(isolate, (uint16*)data, 0, length,
+                      v8::String::NO_NULL_TERMINATION);
+
+        return result;
+    }
+
+    static JSFUNC(encode)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(1);
+        JS_CHECK_ARG(JS_TYPE_STRING, 0);
+
+        v8::Local<v8::String> string = args[0].As<v8::String>();
+
+        switch (GetEncoding(args, 1))
+        {
+            case TextEncoding::Utf8:
+                args.GetReturnValue().Set(EncodeUtf8(isolate, string));
+                break;
+            case TextEncoding::Latin1:
+                args.GetReturnValue().Set(EncodeLatin1(isolate, string));
+                break;
+            case TextEncoding::Utf16Le:
+                args.GetReturnValue().Set(EncodeUtf16(isolate, string));
+                break;
+            case TextEncoding::Unknown:
+                engine->ThrowException("%s: Unknown encoding", __FUNCTION__);
+                break;
+        }
+    }
+
+    static JSFUNC(encodeInto)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(2);
+        JS_CHECK_ARG(JS_TYPE_STRING, 0);
+        JS_CHECK_ARG(JS_TYPE_UINT8_ARRAY, 1);
+
+        v8::Local<v8::String> string = args[0].As<v8::String>();
+
+        ArraySpan<uint8> bytes;
+        TypedArray::GetSpan(args[1], &bytes);
+
+        // NOTE(patrik): V8 stops before a character that doesn't fit so the
+        // output is never cut in the middle of a sequence
+        int32 read = 0;
+        int32 written = 0;
+        if (bytes.size > 0)
+        {
+            int32 capacity = bytes.size > (size_t)INT32_MAX ? INT32_MAX
+                                                            : (int32)bytes.size;
+            written = string->WriteUtf8(isolate, (char*)bytes.data, capacity,
+                                        &read,
+                                        v8::String::NO_NULL_TERMINATION |
+                                            v8::String::REPLACE_INVALID_UTF8);
+        }
+
+        v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+        v8::Local<v8::Object> result = v8::Object::New(isolate);
+        result->Set(context, engine->CreateString("read"),
+                    v8::Integer::New(isolate, read))
+            .FromJust();
+        result->Set(context, engine->CreateString("written"),
+                    v8::Integer::New(isolate, written))
+            .FromJust();
+
+        args.GetReturnValue().Set(result);
+    }
+
+    /**
+     * The decoders return an empty handle if the text is too long for a
+     * string, the error is set if the text is invalid
+     */
+    static v8::MaybeLocal<v8::String> DecodeUtf8(v8::Isolate* isolate,
+                                                 const uint8* data,
+                                                 size_t length, bool fatal,
+                                                 const char** error)
+    {
+
+        if (length >= 3 && data[0] == 0xEF && data[1] == 0xBB &&
+            data[2] == 0xBF)
+        {
+            data += 3;
+            length -= 3;
+        }
+
+        if (length > (size_t)v8::String::kMaxLength)
+            return v8::MaybeLocal<v8::String>();
+
+        // NOTE(patrik): ASCII is a one byte string as it is, V8 doesn't need
+        // to decode anything
+        if (Utf8::IsAscii(data, length))
+        {
+            return v8::String::NewFromOneByte(
+                isolate, data, v8::NewStringType::kNormal, (int32)length);
+        }
+
+        // NOTE(patrik): V8 replaces the invalid sequences with U+FFFD so the
+        // text only needs to be validated when it's fatal
+        if (fatal && !Utf8::IsValid(data, length))
+        {
+            *error = "The data is not valid UTF-8";
+            return v8::MaybeLocal<v8::String>();
+        }
+
+        return v8::String::NewFromUtf8(isolate, (const char*)data,
+                                       v8::NewStringType::kNormal,
+                                       (int32)length);
+    }
+
+    /**
+     * Returns true if every surrogate in the UTF-16LE data is paired, the
+     * length needs to be even
+     */
+    static bool HasPairedSurrogates(const uint8* data, size_t length)
+    {
+        for (size_t i = 0; i < length; i += 2)
+        {
+            uint16 unit = (uint16)(data[i] | (data[i + 1] << 8));
+            if (unit < 0xD800 || unit > 0xDFFF)
+                continue;
+
+            if (unit > 0xDBFF || i + 2 >= length)
+                return false;
+
+            uint16 next = (uint16)(data[i + 2] | (data[i + 3] << 8));
+            if (next < 0xDC00 || next > 0xDFFF)
+                return false;
+
+            i += 2;
+        }
+
+        return true;
+    }
+
+    static v8::MaybeLocal<v8::String> DecodeUtf16(v8::Isolate* isolate,
+                                                  const uint8* data,
+                                                  size_t length, bool fatal,
+                                                  const char** error)
+    {
+        if (length % 2 != 0 && fatal)
+        {
+            *error = "The data is not valid UTF-16";
+            return v8::MaybeLocal<v8::String>();
+        }
+
+        if (length >= 2 && data[0] == 0xFF && data[1] == 0xFE)
+        {
+            data += 2;
+            length -= 2;
+        }
+
+        // NOTE(patrik): V8 strings can hold unpaired surrogates so they're
+        // only looked for when the caller wants errors
+        if (fatal && !HasPairedSurrogates(data, length))
+        {
+            *error = "The data is not valid UTF-16";
+            return v8::MaybeLocal<v8::String>();
+        }
+
+        size_t count = length / 2;
+        bool odd = length % 2 != 0;
+        if (count + odd > (size_t)v8::String::kMaxLength)
+            return v8::MaybeLocal<v8::String>();
+
+        // NOTE(patrik): A view at an odd offset is copied so the characters
+        // are aligned, so is a trailing odd byte that becomes U+FFFD
+        std::vector<uint16> copy;
+        const uint16* characters = (const uint16*)data;
+        if (((uintptr_t)data % alignof(uint16)) != 0 || odd)
+        {
+            copy.resize(count + odd);
+            memcpy(copy.data(), data, count * sizeof(uint16));
+
+            if (odd)
+                copy[count] = 0xFFFD;
+
+            characters = copy.data();
+            count = copy.size();
+        }
+
+        return v8::String::NewFromTwoByte(
+            isolate, characters, v8::NewStringType::kNormal, (int32)count);
+    }
+
+    static JSFUNC(decode)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(1);
+
+        ArraySpan<uint8> bytes;
+        if (!TypedArray::GetBytes(args[0], &bytes))
+        {
+            engine->ThrowException(
+                "%s: Needs argument 0 to be an ArrayBufferView",
+                __FUNCTION__);
+            return;
+        }
+
+        bool fatal = args.Length() > 2 && args[2]->BooleanValue(isolate);
+
+        v8::MaybeLocal<v8::String> result;
+        const char* error = nullptr;
+        switch (GetEncoding(args, 1))
+        {
+            case TextEncoding::Utf8:
+                result = DecodeUtf8(isolate, bytes.data, bytes.size, fatal,
+                                    &error);
+                break;
+            case TextEncoding::Latin1:
+                if (bytes.size > (size_t)v8::String::kMaxLength)
+                    break;
+
+                result = v8::String::NewFromOneByte(
+                    isolate, bytes.data, v8::NewStringType::kNormal,
+                    (int32)bytes.size);
+                break;
+            case TextEncoding::Utf16Le:
+                result = DecodeUtf16(isolate, bytes.data, bytes.size, fatal,
+                                     &error);
+                break;
+            case TextEncoding::Unknown:
+                engine->ThrowException("%s: Unknown encoding", __FUNCTION__);
+                return;
+        }
+
+        if (error)
+        {
+            isolate->ThrowException(
+                v8::Exception::TypeError(engine->CreateString(error)));
+            return;
+        }
+
+        v8::Local<v8::String> string;
+        if (!result.ToLocal(&string))
+        {
+            engine->ThrowException("%s: The text is too long for a string",
+                                   __FUNCTION__);
+            return;
+        }
+
+        args.GetReturnValue().Set(string);
+    }
+
+    static JSFUNC(isUtf8)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(1);
+
+        ArraySpan<uint8> bytes;
+        if (!TypedArray::GetBytes(args[0], &bytes))
+        {
+            engine->ThrowException(
+                "%s: Needs argument 0 to be an ArrayBufferView",
+                __FUNCTION__);
+            return;
+        }
+
+        args.GetReturnValue().Set(Utf8::IsValid(bytes.data, bytes.size));
+    }
+
+    static JSFUNC(isAscii)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(1);
+
+        ArraySpan<uint8> bytes;
+        if (!TypedArray::GetBytes(args[0], &bytes))
+        {
+            engine->ThrowException(
+                "%s: Needs argument 0 to be an ArrayBufferView",
+                __FUNCTION__);
+            return;
+        }
+
+        args.GetReturnValue().Set(Utf8::IsAscii(bytes.data, bytes.size));
+    }
+
+    Encoding::Encoding(Engine* engine) : NativeModule(engine)
+    {
+        m_Functions["encode"] = JSFunc_encode;
+        m_Functions["encodeInto"] = JSFunc_encodeInto;
+        m_Functions["decode"] = JSFunc_decode;
+        m_Functions["isUtf8"] = JSFunc_isUtf8;
+        m_Functions["isAscii"] = JSFunc_isAscii;
+    }
+
+    Encoding::~Encoding() {}
+
+    String Encoding::GetPackageName() { return "encoding"; }
+
+    SCRIPTER_REGISTER_NATIVE_MODULE("encoding", Encoding);
+
+}} // namespace scripter::modules
@@ -0,0 +1,447 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/modules/Hash.h"
+
+#include "scripter/NativeObject.h"
+#include "scripter/TypedArray.h"
+
+#include "scripter/utils/Hash.h"
+#include "scripter/utils/ScratchBuffer.h"
+
+namespace scripter { namespace modules {
+
+    enum class HashType
+    {
+        Unknown,
+        Crc32c,
+        XxHash64,
+        Sha256
+    };
+
+    enum class DigestFormat
+    {
+        Unknown,
+        Hex,
+        Bytes,
+        Number,
+        BigInt
+    };
+
+    /**
+     * The running hashes of a Hasher object, only the one of its type is
+     * updated
+     */
+    struct HasherState
+    {
+        HashType type;
+        uint64 seed;
+
+        Crc32c crc32c;
+        XxHash64 xxHash64;
+        Sha256 sha256;
+
+        HasherState(HashType type, uint64 seed)
+            : type(type), seed(seed), crc32c((uint32)seed), xxHash64(seed)
+        {
+        }
+
+        void Reset()
+        {
+            crc32c = Crc32c((uint32)seed);
+            xxHash64 = XxHash64(seed);
+            sha256 = Sha256();
+        }
+
+        void Update(const uint8* data, size_t length)
+        {
+            switch (type)
+            {
+                case HashType::Crc32c: crc32c.Update(data, length); break;
+                case HashType::XxHash64: xxHash64.Update(data, length); break;
+                case HashType::Sha256: sha256.Update(data, length); break;
+                case HashType::Unknown: break;
+            }
+        }
+    };
+
+    static bool GetData(Engine* engine,
+                        const v8::FunctionCallbackInfo<v8::Value>& args,
+                        String& buffer, ArraySpan<uint8>* result,
+                        const char* functionName)
+    {
+        if (TypedArray::GetBytesOrUtf8(engine, args[0], buffer, result))
+            return true;
+
+        engine->ThrowException(
+            "%s: Needs argument 0 to be a String or an ArrayBufferView",
+            functionName);
+        return false;
+    }
+
+    /**
+     * Reads a seed from a number or a BigInt, undefined is a zero seed
+     */
+    static bool GetSeed(Engine* engine,
+                        const v8::FunctionCallbackInfo<v8::Value>& args,
+                        int32 index, uint64* seed, const char* functionName)
+    {
+        *seed = 0;
+        if (args.Length() <= index || args[index]->IsUndefined())
+            return true;
+
+        v8::Local<v8::Value> value = args[index];
+        if (value->IsBigInt())
+        {
+            *seed = value.As<v8::BigInt>()->Uint64Value();
+            return true;
+        }
+
+        if (value->IsNumber())
+        {
+            double number = value.As<v8::Number>()->Value();
+            if (number >= 0 && number < 18446744073709551616.0 &&
+                number == (double)(uint64)number)
+            {
+                *seed = (uint64)number;
+                return true;
+            }
+        }
+
+        engine->ThrowException(
+            "%s: Needs argument %d to be a positive integer or a BigInt",
+            functionName, index);
+        return false;
+    }
+
+    static DigestFormat
+    GetFormat(const v8::FunctionCallbackInfo<v8::Value>& args, int32 index,
+              DigestFormat defaultFormat)
+    {
+        if (args.Length() <= index || args[index]->IsUndefined())
+            return defaultFormat;
+
+        v8::String::Utf8Value name(args.GetIsolate(), args[index]);
+        if (!*name)
+            return DigestFormat::Unknown;
+
+        String format(*name, name.length());
+        if (format == "hex")
+            return DigestFormat::Hex;
+
+        if (format == "bytes")
+            return DigestFormat::Bytes;
+
+        if (format == "number")
+            return DigestFormat::Number;
+
+        if (format == "bigint")
+            return DigestFormat::BigInt;
+
+        return DigestFormat::Unknown;
+    }
+
+    /**
+     * Returns a big endian digest in the format, numbers only fit digests of
+     * 4 bytes and BigInts digests of up to 8 bytes
+     */
+    static void SetDigest(Engine* engine,
+                          const v8::FunctionCallbackInfo<v8::Value>& args,
+                          const uint8* digest, size_t size,
+                          DigestFormat format, const char* functionName)
+    {
+        v8::Isolate* isolate = engine->GetIsolate();
+
+        uint64 value = 0;
+        for (size_t i = 0; i < size && i < 8; i++)
+            value = (value << 8) | digest[i];
+
+        switch (format)
+        {
+            case DigestFormat::Hex:
+            {
+                static const char s_Digits[] = "0123456789abcdef";
+
+                char hex[Sha256::DIGEST_SIZE * 2];
+                for (size_t i = 0; i < size; i++)
+                {
+                    hex[i * 2] = s_Digits[digest[i] >> 4];
+                    hex[i * 2 + 1] = s_Digits[digest[i] & 0xF];
+                }
+
+                v8::Local<v8::String> result;
+                if (engine->CreateString(hex, size * 2).ToLocal(&result))
+                    args.GetReturnValue().Set(result);
+                return;
+            }
+
+            case DigestFormat::Bytes:
+                args.GetReturnValue().Set(
+                    TypedArray::Copy(engine, digest, size));
+                return;
+
+            case DigestFormat::Number:
+                if (size == 4)
+                {
+                    args.GetReturnValue().Set((uint32)value);
+                    return;
+                }
+                break;
+
+            case DigestFormat::BigInt:
+                if (size <= 8)
+                {
+                    args.GetReturnValue().Set(
+                        v8::BigInt::NewFromUnsigned(isolate, value));
+                    return;
+                }
+                break;
+
+            case DigestFormat::Unknown: break;
+        }
+
+        engine->ThrowException("%s: Unsupported digest format", functionName);
+    }
+
+    static size_t WriteUint64(uint64 value, uint8* out, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+            out[i] = (uint8)(value >> ((size - 1 - i) * 8));
+
+        return size;
+    }
+
+    static JSFUNC(crc32c)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(1);
+
+        ScratchBuffer buffer;
+        ArraySpan<uint8> data;
+        uint64 seed;
+        if (!GetData(engine, args, buffer.Get(), &data, __FUNCTION__) ||
+            !GetSeed(engine, args, 1, &seed, __FUNCTION__))
+        {
+            return;
+        }
+
+        if (seed > 0xFFFFFFFF)
+        {
+            engine->ThrowException("%s: The seed needs to fit in 32 bits",
+                                   __FUNCTION__);
+            return;
+        }
+
+        uint32 crc = Crc32c::Compute(data.data, data.size, (uint32)seed);
+        args.GetReturnValue().Set(crc);
+    }
+
+    static JSFUNC(xxhash64)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(1);
+
+        ScratchBuffer buffer;
+        ArraySpan<uint8> data;
+        uint64 seed;
+        if (!GetData(engine, args, buffer.Get(), &data, __FUNCTION__) ||
+            !GetSeed(engine, args, 1, &seed, __FUNCTION__))
+        {
+            return;
+        }
+
+        uint64 hash = XxHash64::Compute(data.data, data.size, seed);
+
+        uint8 digest[8];
+        WriteUint64(hash, digest, sizeof(digest));
+        SetDigest(engine, args, digest, sizeof(digest),
+                  GetFormat(args, 2, DigestFormat::Hex), __FUNCTION__);
+    }
+
+    static JSFUNC(sha256)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(1);
+
+        ScratchBuffer buffer;
+        ArraySpan<uint8> data;
+        if (!GetData(engine, args, buffer.Get(), &data, __FUNCTION__))
+            return;
+
+        uint8 digest[Sha256::DIGEST_SIZE];
+        Sha256::Compute(data.data, data.size, digest);
+        SetDigest(engine, args, digest, sizeof(digest),
+                  GetFormat(args, 1, DigestFormat::Hex), __FUNCTION__);
+    }
+
+    static JSFUNC(Hasher)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        if (!NativeObject::CheckConstructCall(engine, args, __FUNCTION__))
+            return;
+
+        JS_CHECK_ARGS_LENGTH(1);
+        JS_CHECK_ARG(JS_TYPE_STRING, 0);
+
+        v8::String::Utf8Value name(isolate, args[0]);
+        String algorithm(*name, name.length());
+
+        HashType type = HashType::Unknown;
+        if (algorithm == "crc32c")
+            type = HashType::Crc32c;
+        else if (algorithm == "xxhash64")
+            type = HashType::XxHash64;
+        else if (algorithm == "sha256")
+            type = HashType::Sha256;
+
+        if (type == HashType::Unknown)
+        {
+            engine->ThrowException("%s: Unknown algorithm '%s'", __FUNCTION__,
+                                   algorithm.c_str());
+            return;
+        }
+
+        uint64 seed;
+        if (!GetSeed(engine, args, 1, &seed, __FUNCTION__))
+            return;
+
+        if (type == HashType::Crc32c && seed > 0xFFFFFFFF)
+        {
+            engine->ThrowException("%s: The seed needs to fit in 32 bits",
+                                   __FUNCTION__);
+            return;
+        }
+
+        NativeObject::Wrap(engine, args.This(), new HasherState(type, seed));
+    }
+
+    static JSFUNC(hasherUpdate)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(1);
+
+        ScratchBuffer buffer;
+        ArraySpan<uint8> data;
+        if (!GetData(engine, args, buffer.Get(), &data, __FUNCTION__))
+            return;
+
+        NativeObject::Unwrap<HasherState>(args)->Update(data.data, data.size);
+        args.GetReturnValue().Set(args.This());
+    }
+
+    static JSFUNC(hasherDigest)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        // NOTE(patrik): CRC32C defaults to a number like hash.crc32c
+        HasherState* hasher = NativeObject::Unwrap<HasherState>(args);
+        DigestFormat format =
+            GetFormat(args, 0,
+                      hasher->type == HashType::Crc32c ? DigestFormat::Number
+                                                       : DigestFormat::Hex);
+
+        uint8 digest[Sha256::DIGEST_SIZE];
+        size_t size = 0;
+        switch (hasher->type)
+        {
+            case HashType::Crc32c:
+                size = WriteUint64(hasher->crc32c.GetValue(), digest, 4);
+                break;
+
+            case HashType::XxHash64:
+                size = WriteUint64(hasher->xxHash64.Finish(), digest, 8);
+                break;
+
+            case HashType::Sha256:
+                hasher->sha256.Finish(digest);
+                size = Sha256::DIGEST_SIZE;
+                break;
+
+            case HashType::Unknown: break;
+        }
+
+        SetDigest(engine, args, digest, size, format, __FUNCTION__);
+    }
+
+    static JSFUNC(hasherReset)
+    {
+        JS_FUNC_ISOLATE();
+        v8::HandleScope handleScope(isolate);
+
+        NativeObject::Unwrap<HasherState>(args)->Reset();
+        args.GetReturnValue().Set(args.This());
+    }
+
+    Hash::Hash(Engine* engine) : NativeModule(engine)
+    {
+        m_Functions["crc32c"] = JSFunc_crc32c;
+        m_Functions["xxhash64"] = JSFunc_xxhash64;
+        m_Functions["sha256"] = JSFunc_sha256;
+    }
+
+    Hash::~Hash() { m_HasherTemplate.Reset(); }
+
+    String Hash::GetPackageName() { return "hash"; }
+
+    v8::Local<v8::Object> Hash::GenerateObject()
+    {
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+        v8::EscapableHandleScope handleScope(isolate);
+
+        v8::Local<v8::Object> result = NativeModule::GenerateObject();
+
+        if (m_HasherTemplate.IsEmpty())
+        {
+            m_HasherTemplate.Reset(
+                isolate, NativeObject::CreateClass(
+                             m_Engine, "Hasher", JSFunc_Hasher,
+                             {{"update", JSFunc_hasherUpdate},
+                              {"digest", JSFunc_hasherDigest},
+                              {"reset", JSFunc_hasherReset}}));
+        }
+
+        v8::Local<v8::Context> context = isolate->GetCurrentContext();
+        result
+            ->Set(context, m_Engine->CreateString("Hasher"),
+                  m_HasherTemplate.Get(isolate)
+                      ->GetFunction(context)
+                      .ToLocalChecked())
+            .FromJust();
+
+        return handleScope.Escape(result);
+    }
+
+    SCRIPTER_REGISTER_NATIVE_MODULE("hash", Hash);
+
+}} // namespace scripter::modules
@@ -0,0 +1,1200 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/modules/Json.h"
+
+#include "scripter/Logger.h"
+#include "scripter/NativeObject.h"
+#include "scripter/TypedArray.h"
+
+#include "scripter/utils/Json.h"
+#include "scripter/utils/ScratchBuffer.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <charconv>
+#include <vector>
+
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace scripter { namespace modules {
+
+    static const size_t s_MaxDepth = 512;
+
+    static bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+    /**
+     * Parses JSON straight into V8 values, the elements of arrays are
+     * collected on a stack and the array is created in one go when it ends
+     */
+    class JsonParser
+    {
+    private:
+        v8::Isolate* m_Isolate;
+        v8::Local<v8::Context> m_Context;
+
+        const char* m_Begin;
+        const char* m_Cursor;
+        const char* m_End;
+        size_t m_Depth;
+        const char* m_Error;
+
+        String m_Scratch;
+        std::vector<v8::Local<v8::Value>> m_Values;
+
+    public:
+        JsonParser(v8::Isolate* isolate) : m_Isolate(isolate)
+        {
+            m_Context = isolate->GetCurrentContext();
+            Reset(std::string_view());
+        }
+
+        void Reset(std::string_view json)
+        {
+            m_Begin = json.data();
+            m_Cursor = m_Begin;
+            m_End = m_Begin + json.size();
+            m_Depth = 0;
+            m_Error = nullptr;
+
+            m_Values.clear();
+        }
+
+        bool ParseDocument(v8::Local<v8::Value>* result)
+        {
+            SkipWhitespace();
+            if (!ParseValue(result))
+                return false;
+
+            SkipWhitespace();
+            if (m_Cursor != m_End)
+                return Fail("Unexpected token after the JSON value");
+
+            return true;
+        }
+
+        /**
+         * Throws the error as a SyntaxError
+         */
+        v8::Local<v8::Value> CreateError(Engine* engine,
+                                         const String& prefix = String())
+        {
+            String message = prefix + m_Error + " at position " +
+                             std::to_string(m_Cursor - m_Begin);
+            return v8::Exception::SyntaxError(engine->CreateString(message));
+        }
+
+        void ThrowError(Engine* engine, const String& prefix = String())
+        {
+            m_Isolate->ThrowException(CreateError(engine, prefix));
+        }
+
+    private:
+        bool Fail(const char* message)
+        {
+            m_Error = message;
+            return false;
+        }
+
+        void SkipWhitespace()
+        {
+            while (m_Cursor < m_End &&
+                   (*m_Cursor == ' ' || *m_Cursor == '\n' ||
+                    *m_Cursor == '\r' || *m_Cursor == '\t'))
+            {
+                m_Cursor++;
+            }
+        }
+
+        bool ParseValue(v8::Local<v8::Value>* result)
+        {
+            if (m_Cursor >= m_End)
+                return Fail("Unexpected end of JSON input");
+
+            switch (*m_Cursor)
+            {
+                case '{': return ParseObject(result);
+                case '[': return ParseArray(result);
+                case '"':
+                {
+                    v8::Local<v8::String> string;
+                    if (!ParseString(&string, false))
+                        return false;
+
+                    *result = string;
+                    return true;
+                }
+                case 't':
+                    return ParseLiteral("true", v8::True(m_Isolate), result);
+                case 'f':
+                    return ParseLiteral("false", v8::False(m_Isolate), result);
+                case 'n':
+                    return ParseLiteral("null", v8::Null(m_Isolate), result);
+                default: return ParseNumber(result);
+            }
+        }
+
+        bool ParseLiteral(const char* literal, v8::Local<v8::Value> value,
+                          v8::Local<v8::Value>* result)
+        {
+            size_t length = strlen(literal);
+            if ((size_t)(m_End - m_Cursor) < length ||
+                memcmp(m_Cursor, literal, length) != 0)
+            {
+                return Fail("Unexpected token");
+            }
+
+            m_Cursor += length;
+            *result = value;
+            return true;
+        }
+
+        bool ParseArray(v8::Local<v8::Value>* result)
+        {
+            if (++m_Depth > s_MaxDepth)
+                return Fail("JSON is nested too deeply");
+
+            m_Cursor++;
+            size_t start = m_Values.size();
+
+            SkipWhitespace();
+            if (m_Cursor < m_End && *m_Cursor == ']')
+            {
+                m_Cursor++;
+            }
+            else
+            {
+                while (true)
+                {
+                    SkipWhitespace();
+
+                    v8::Local<v8::Value> value;
+                    if (!ParseValue(&value))
+                        return false;
+
+                    m_Values.push_back(value);
+
+                    SkipWhitespace();
+                    if (m_Cursor >= m_End)
+                        return Fail("Unexpected end of JSON input");
+
+                    if (*m_Cursor == ']')
+                    {
+                        m_Cursor++;
+                        break;
+                    }
+
+                    if (*m_Cursor != ',')
+                        return Fail("Expected ',' or ']' after an element");
+
+                    m_Cursor++;
+                }
+            }
+
+            size_t count = m_Values.size() - start;
+            *result = count > 0 ? v8::Array::New(m_Isolate, &m_Values[start],
+                                                 count)
+                                : v8::Array::New(m_Isolate, 0);
+
+            m_Values.resize(start);
+            m_Depth--;
+            return true;
+        }
+
+        bool ParseObject(v8::Local<v8::Value>* result)
+        {
+            if (++m_Depth > s_MaxDepth)
+                return Fail("JSON is nested too deeply");
+
+            m_Cursor++;
+
+            // NOTE(patrik): The properties are added one by one, creating the
+            // object from all the names at once would make it a dictionary
+            // and the objects would not share a shape
+            v8::Local<v8::Object> object = v8::Object::New(m_Isolate);
+
+            SkipWhitespace();
+            if (m_Cursor < m_End && *m_Cursor == '}')
+            {
+                m_Cursor++;
+            }
+            else
+            {
+                while (true)
+                {
+                    SkipWhitespace();
+                    if (m_Cursor >= m_End || *m_Cursor != '"')
+                        return Fail("Expected a property name");
+
+                    // NOTE(patrik): The keys are internalized so the same key
+                    // is the same string in every object
+                    v8::Local<v8::String> name;
+                    if (!ParseString(&name, true))
+                        return false;
+
+                    SkipWhitespace();
+                    if (m_Cursor >= m_End || *m_Cursor != ':')
+                        return Fail("Expected ':' after a property name");
+
+                    m_Cursor++;
+                    SkipWhitespace();
+
+                    v8::Local<v8::Value> value;
+                    if (!ParseValue(&value))
+                        return false;
+
+                    if (!object->CreateDataProperty(m_Context, name, value)
+                             .FromMaybe(false))
+                    {
+                        return Fail("Could not add a property");
+                    }
+
+                    SkipWhitespace();
+                    if (m_Cursor >= m_End)
+                        return Fail("Unexpected end of JSON input");
+
+                    if (*m_Cursor == '}')
+                    {
+                        m_Cursor++;
+                        break;
+                    }
+
+                    if (*m_Cursor != ',')
+                        return Fail("Expected ',' or '}' after a property");
+
+                    m_Cursor++;
+                }
+            }
+
+            *result = object;
+            m_Depth--;
+            return true;
+        }
+
+        /**
+         * Returns the first quote, backslash or control character from the
+         * position, ascii is cleared if a non ASCII byte is passed
+         */
+        const char* ScanString(const char* position, bool* ascii)
+        {
+#ifdef __SSE2__
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i control = _mm_set1_epi8(0x1F);
+
+            while (m_End - position >= 16)
+            {
+                __m128i chunk = _mm_loadu_si128((const __m128i*)position);
+
+                // NOTE(patrik): A byte is a control character if the unsigned
+                // max of it and 0x1F is still 0x1F
+                __m128i special = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                 _mm_cmpeq_epi8(chunk, backslash)),
+                    _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+
+                uint32 specialMask = (uint32)_mm_movemask_epi8(special);
+                uint32 highMask = (uint32)_mm_movemask_epi8(chunk);
+
+                if (specialMask)
+                {
+                    uint32 index = __builtin_ctz(specialMask);
+                    if (highMask & ((1u << index) - 1))
+                        *ascii = false;
+
+                    return position + index;
+                }
+
+                if (highMask)
+                    *ascii = false;
+
+                position += 16;
+            }
+#endif
+
+            for (; position < m_End; position++)
+            {
+                uint8 c = (uint8)*position;
+                if (c == '"' || c == '\\' || c < 0x20)
+                    return position;
+
+                if (c >= 0x80)
+                    *ascii = false;
+            }
+
+            return position;
+        }
+
+        bool NewString(const char* data, size_t length, bool ascii,
+                       bool internalize, v8::Local<v8::String>* result)
+        {
+            if (length > (size_t)v8::String::kMaxLength)
+                return Fail("String is too long");
+
+            v8::NewStringType type = internalize
+                                         ? v8::NewStringType::kInternalized
+                                         : v8::NewStringType::kNormal;
+
+            // NOTE(patrik): ASCII is the same in Latin-1 so V8 can copy the
+            // bytes without decoding them
+            v8::MaybeLocal<v8::String> string =
+                ascii ? v8::String::NewFromOneByte(m_Isolate,
+                                                   (const uint8*)data, type,
+                                                   (int)length)
+                      : v8::String::NewFromUtf8(m_Isolate, data, type,
+                                                (int)length);
+
+            if (!string.ToLocal(result))
+                return Fail("Could not create a string");
+
+            return true;
+        }
+
+        bool ParseHex4(const char* position, uint32* result)
+        {
+            if (m_End - position < 4)
+                return false;
+
+            uint32 value = 0;
+            for (int32 i = 0; i < 4; i++)
+            {
+                char c = position[i];
+                value <<= 4;
+
+                if (c >= '0' && c <= '9')
+                    value |= c - '0';
+                else if (c >= 'a' && c <= 'f')
+                    value |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F')
+                    value |= c - 'A' + 10;
+                else
+                    return false;
+            }
+
+            *result = value;
+            return true;
+        }
+
+        /**
+         * Moves the decoded scratch and a lone surrogate to the end of the
+         * prefix, V8 can't create a lone surrogate from UTF-8
+         */
+        bool AppendSurrogate(v8::Local<v8::String>* prefix, bool ascii,
+                             uint16 surrogate)
+        {
+            v8::Local<v8::String> part;
+            if (!NewString(m_Scratch.data(), m_Scratch.size(), ascii, false,
+                           &part))
+            {
+                return false;
+            }
+
+            v8::Local<v8::String> unit;
+            if (!v8::String::NewFromTwoByte(m_Isolate, &surrogate,
+                                            v8::NewStringType::kNormal, 1)
+                     .ToLocal(&unit))
+            {
+                return Fail("Could not create a string");
+            }
+
+            if (!prefix->IsEmpty())
+                part = v8::String::Concat(m_Isolate, *prefix, part);
+
+            *prefix = v8::String::Concat(m_Isolate, part, unit);
+            m_Scratch.clear();
+            return true;
+        }
+
+        void AppendCodePoint(uint32 codePoint)
+        {
+            if (codePoint < 0x80)
+            {
+                m_Scratch += (char)codePoint;
+            }
+            else if (codePoint < 0x800)
+            {
+                m_Scratch += (char)(0xC0 | (codePoint >> 6));
+                m_Scratch += (char)(0x80 | (codePoint & 0x3F));
+            }
+            else if (codePoint < 0x10000)
+            {
+                m_Scratch += (char)(0xE0 | (codePoint >> 12));
+                m_Scratch += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+                m_Scratch += (char)(0x80 | (codePoint & 0x3F));
+            }
+            else
+            {
+                m_Scratch += (char)(0xF0 | (codePoint >> 18));
+                m_Scratch += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+                m_Scratch += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+                m_Scratch += (char)(0x80 | (codePoint & 0x3F));
+            }
+        }
+
+        bool ParseString(v8::Local<v8::String>* result, bool internalize)
+        {
+            m_Cursor++;
+
+            const char* start = m_Cursor;
+            bool ascii = true;
+
+            const char* position = ScanString(start, &ascii);
+            if (position < m_End && *position == '"')
+            {
+                m_Cursor = position + 1;
+                return NewString(start, position - start, ascii, internalize,
+                                 result);
+            }
+
+            // NOTE(patrik): The string has escapes so it's decoded into the
+            // scratch buffer first, the parts before lone surrogates are
+            // collected in the prefix
+            m_Scratch.assign(start, position - start);
+            v8::Local<v8::String> prefix;
+
+            while (true)
+            {
+                if (position >= m_End)
+                {
+                    m_Cursor = position;
+                    return Fail("Unterminated string");
+                }
+
+                char c = *position;
+                if (c == '"')
+                    break;
+
+                if ((uint8)c < 0x20)
+                {
+                    m_Cursor = position;
+                    return Fail("Bad control character in string");
+                }
+
+                if (c != '\\')
+                {
+                    const char* run = ScanString(position, &ascii);
+                    m_Scratch.append(position, run - position);
+                    position = run;
+                    continue;
+                }
+
+                position++;
+                if (position >= m_End)
+                {
+                    m_Cursor = position;
+                    return Fail("Unterminated string");
+                }
+
+                char escape = *position++;
+                switch (escape)
+                {
+                    case '"': m_Scratch += '"'; break;
+                    case '\\': m_Scratch += '\\'; break;
+                    case '/': m_Scratch += '/'; break;
+                    case 'b': m_Scratch += '\b'; break;
+                    case 'f': m_Scratch += '\f'; break;
+                    case 'n': m_Scratch += '\n'; break;
+                    case 'r': m_Scratch += '\r'; break;
+                    case 't': m_Scratch += '\t'; break;
+                    case 'u':
+                    {
+                        uint32 codePoint;
+                        if (!ParseHex4(position, &codePoint))
+                        {
+                            m_Cursor = position;
+                            return Fail("Bad unicode escape");
+                        }
+                        position += 4;
+
+                        uint32 low;
+                        if (codePoint >= 0xD800 && codePoint <= 0xDBFF &&
+                            m_End - position >= 6 && position[0] == '\\' &&
+                            position[1] == 'u' &&
+                            ParseHex4(position + 2, &low) && low >= 0xDC00 &&
+                            low <= 0xDFFF)
+                        {
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) +
+                                        (low - 0xDC00);
+                            position += 6;
+                        }
+
+                        if (codePoint >= 0xD800 && codePoint <= 0xDFFF)
+                        {
+                            if (!AppendSurrogate(&prefix, ascii,
+                                                 (uint16)codePoint))
+                            {
+                                m_Cursor = position;
+                                return false;
+                            }
+                            break;
+                        }
+
+                        if (codePoint >= 0x80)
+                            ascii = false;
+
+                        AppendCodePoint(codePoint);
+                        break;
+                    }
+                    default:
+                        m_Cursor = position - 1;
+                        return Fail("Bad escaped character");
+                }
+            }
+
+            m_Cursor = position + 1;
+            if (prefix.IsEmpty())
+                return NewString(m_Scratch.data(), m_Scratch.size(), ascii,
+                                 internalize, result);
+
+            v8::Local<v8::String> rest;
+            if (!NewString(m_Scratch.data(), m_Scratch.size(), ascii, false,
+                           &rest))
+            {
+                return false;
+            }
+
+            *result = v8::String::Concat(m_Isolate, prefix, rest);
+            return true;
+        }
+
+        bool ParseNumber(v8::Local<v8::Value>* result)
+        {
+            const char* start = m_Cursor;
+            const char* position = m_Cursor;
+
+            bool negative = position < m_End && *position == '-';
+            if (negative)
+                position++;
+
+            if (position >= m_End || !IsDigit(*position))
+                return Fail("Unexpected token");
+
+            if (*position == '0')
+                position++;
+            else
+                while (position < m_End && IsDigit(*position))
+                    position++;
+
+            bool integer = true;
+            if (position < m_End && *position == '.')
+            {
+                integer = false;
+                position++;
+
+                if (position >= m_End || !IsDigit(*position))
+                {
+                    m_Cursor = position;
+                    return Fail("No number after the decimal point");
+                }
+
+                while (position < m_End && IsDigit(*position))
+                    position++;
+            }
+
+            if (position < m_End && (*position == 'e' || *position == 'E'))
+            {
+                integer = false;
+                position++;
+
+                if (position < m_End && (*position == '+' || *position == '-'))
+                    position++;
+
+                if (position >= m_End || !IsDigit(*position))
+                {
+                    m_Cursor = position;
+                    return Fail("No number after the exponent");
+                }
+
+                while (position < m_End && IsDigit(*position))
+                    position++;
+            }
+
+            m_Cursor = position;
+
+            // NOTE(patrik): Short integers are exact in a double and are the
+            // most common numbers so they skip the full conversion
+            if (integer && position - start <= 15)
+            {
+                int64 value = 0;
+                for (const char* c = start + (negative ? 1 : 0); c < position;
+                     c++)
+                {
+                    value = value * 10 + (*c - '0');
+                }
+
+                *result = v8::Number::New(m_Isolate, negative ? -(double)value
+                                                              : (double)value);
+                return true;
+            }
+
+            double value = 0.0;
+            std::from_chars_result parsed =
+                std::from_chars(start, position, value);
+            if (parsed.ec == std::errc::result_out_of_range)
+            {
+                // NOTE(patrik): strtod gives infinity or zero like JSON.parse
+                m_Scratch.assign(start, position - start);
+                value = strtod(m_Scratch.c_str(), nullptr);
+            }
+
+            *result = v8::Number::New(m_Isolate, value);
+            return true;
+        }
+    };
+
+    /**
+     * Writes V8 values as JSON the same way as JSON.stringify without the
+     * replacer and the indentation
+     */
+    class JsonWriter
+    {
+    private:
+        Engine* m_Engine;
+        v8::Isolate* m_Isolate;
+        v8::Local<v8::Context> m_Context;
+        v8::Local<v8::String> m_ToJsonName;
+
+        String& m_Out;
+        String m_Scratch;
+        std::vector<uint16> m_Utf16;
+        std::vector<v8::Local<v8::Object>> m_Stack;
+
+    public:
+        JsonWriter(Engine* engine, String& out)
+            : m_Engine(engine), m_Isolate(engine->GetIsolate()), m_Out(out)
+        {
+            m_Context = m_Isolate->GetCurrentContext();
+            m_ToJsonName = engine->CreateString("toJSON");
+        }
+
+        /**
+         * Writes a value, written is set to false if the value has no JSON
+         * form. Returns false if an exception was thrown
+         */
+        bool Write(v8::Local<v8::Value> value, v8::Local<v8::Value> key,
+                   bool* written)
+        {
+            *written = true;
+
+            if (value->IsObject())
+            {
+                v8::Local<v8::Value> toJson;
+                if (!value.As<v8::Object>()
+                         ->Get(m_Context, m_ToJsonName)
+                         .ToLocal(&toJson))
+                {
+                    return false;
+                }
+
+                if (toJson->IsFunction())
+                {
+                    v8::Local<v8::Value> keyString;
+                    if (!key->ToString(m_Context).ToLocal(&keyString) ||
+                        !toJson.As<v8::Function>()
+                             ->Call(m_Context, value, 1, &keyString)
+                             .ToLocal(&value))
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            if (value->IsNumberObject())
+                value = v8::Number::New(
+                    m_Isolate, value.As<v8::NumberObject>()->ValueOf());
+            else if (value->IsStringObject())
+                value = value.As<v8::StringObject>()->ValueOf();
+            else if (value->IsBooleanObject())
+                value = v8::Boolean::New(
+                    m_Isolate, value.As<v8::BooleanObject>()->ValueOf());
+
+            if (value->IsNull())
+                m_Out += "null";
+            else if (value->IsTrue())
+                m_Out += "true";
+            else if (value->IsFalse())
+                m_Out += "false";
+            else if (value->IsNumber())
+                WriteNumber(value.As<v8::Number>()->Value());
+            else if (value->IsString())
+                WriteString(value.As<v8::String>());
+            else if (value->IsBigInt())
+                return Throw("Do not know how to serialize a BigInt");
+            else if (value->IsUndefined() || value->IsFunction() ||
+                     value->IsSymbol())
+                *written = false;
+            else if (value->IsArray())
+                return WriteArray(value.As<v8::Array>());
+            else
+                return WriteObject(value.As<v8::Object>());
+
+            return true;
+        }
+
+    private:
+        bool Throw(const char* message)
+        {
+            m_Isolate->ThrowException(
+                v8::Exception::TypeError(m_Engine->CreateString(message)));
+            return false;
+        }
+
+        bool Enter(v8::Local<v8::Object> object)
+        {
+            if (m_Stack.size() >= s_MaxDepth)
+                return Throw("Object is nested too deeply");
+
+            for (v8::Local<v8::Object>& parent : m_Stack)
+            {
+                if (parent->StrictEquals(object))
+                    return Throw("Converting circular structure to JSON");
+            }
+
+            m_Stack.push_back(object);
+            return true;
+        }
+
+        void WriteNumber(double value)
+        {
+            if (!isfinite(value))
+            {
+                m_Out += "null";
+                return;
+            }
+
+            // NOTE(patrik): Integers are written like javascript does, other
+            // numbers use the shortest form that reads back the same value
+            // which can differ from javascript in when it uses an exponent
+            char buffer[32];
+            std::to_chars_result converted;
+            if (value == trunc(value) && fabs(value) < 9007199254740992.0)
+            {
+                converted = std::to_chars(buffer, buffer + sizeof(buffer),
+                                          (int64)value);
+            }
+            else
+            {
+                converted =
+                    std::to_chars(buffer, buffer + sizeof(buffer), value);
+            }
+
+            m_Out.append(buffer, converted.ptr - buffer);
+        }
+
+        void WriteString(v8::Local<v8::String> string)
+        {
+            // NOTE(patrik): Two byte strings can have lone surrogates that
+            // have no UTF-8 form, they're read as UTF-16 so the surrogates
+            // can be escaped
+            if (!string->IsOneByte())
+            {
+                int32 length = string->Length();
+                m_Utf16.resize(length);
+                string->Write(m_Isolate, m_Utf16.data(), 0, length,
+                              v8::String::NO_NULL_TERMINATION);
+
+                scripter::Json::AppendString(m_Out, m_Utf16.data(), length);
+                return;
+            }
+
+            int32 length = string->Utf8Length(m_Isolate);
+            m_Scratch.resize(length);
+            string->WriteUtf8(m_Isolate, &m_Scratch[0], length, nullptr,
+                              v8::String::NO_NULL_TERMINATION |
+                                  v8::String::REPLACE_INVALID_UTF8);
+
+            scripter::Json::AppendString(m_Out, m_Scratch.data(), length);
+        }
+
+        bool WriteArray(v8::Local<v8::Array> array)
+        {
+            if (!Enter(array))
+                return false;
+
+            m_Out += '[';
+
+            uint32 length = array->Length();
+            for (uint32 i = 0; i < length; i++)
+            {
+                if (i > 0)
+                    m_Out += ',';
+
+                v8::Local<v8::Value> element;
+                if (!array->Get(m_Context, i).ToLocal(&element))
+                    return false;
+
+                bool written;
+                if (!Write(element, v8::Integer::NewFromUnsigned(m_Isolate, i),
+                           &written))
+                {
+                    return false;
+                }
+
+                if (!written)
+                    m_Out += "null";
+            }
+
+            m_Out += ']';
+            m_Stack.pop_back();
+            return true;
+        }
+
+        bool WriteObject(v8::Local<v8::Object> object)
+        {
+            if (!Enter(object))
+                return false;
+
+            v8::Local<v8::Array> names;
+            if (!object
+                     ->GetOwnPropertyNames(
+                         m_Context,
+                         (v8::PropertyFilter)(v8::ONLY_ENUMERABLE |
+                                              v8::SKIP_SYMBOLS),
+                         v8::KeyConversionMode::kConvertToString)
+                     .ToLocal(&names))
+            {
+                return false;
+            }
+
+            m_Out += '{';
+
+            bool first = true;
+            uint32 length = names->Length();
+            for (uint32 i = 0; i < length; i++)
+            {
+                v8::Local<v8::Value> name;
+                v8::Local<v8::Value> value;
+                if (!names->Get(m_Context, i).ToLocal(&name) ||
+                    !object->Get(m_Context, name).ToLocal(&value))
+                {
+                    return false;
+                }
+
+                // NOTE(patrik): The key is removed again if the value has no
+                // JSON form
+                size_t mark = m_Out.size();
+                if (!first)
+                    m_Out += ',';
+
+                WriteString(name.As<v8::String>());
+                m_Out += ':';
+
+                bool written;
+                if (!Write(value, name, &written))
+                    return false;
+
+                if (written)
+                    first = false;
+                else
+                    m_Out.resize(mark);
+            }
+
+            m_Out += '}';
+            m_Stack.pop_back();
+            return true;
+        }
+    };
+
+    /**
+     * The lines of a Parser object that haven't been parsed yet
+     */
+    struct NdjsonStream
+    {
+        String pending;
+    };
+
+    static v8::Local<v8::Array>
+    CreateArray(v8::Isolate* isolate,
+                std::vector<v8::Local<v8::Value>>& values)
+    {
+        if (values.empty())
+            return v8::Array::New(isolate, 0);
+
+        return v8::Array::New(isolate, values.data(), values.size());
+    }
+
+    /**
+     * Parses the complete lines in the stream, the last line is only parsed
+     * if flush is true. A bad line throws a SyntaxError with the values of
+     * the lines before it in its values property
+     */
+    static void ParseLines(Engine* engine, NdjsonStream* stream, bool flush,
+                           const v8::FunctionCallbackInfo<v8::Value>& args)
+    {
+        v8::Isolate* isolate = engine->GetIsolate();
+
+        JsonParser parser(isolate);
+        std::vector<v8::Local<v8::Value>> values;
+
+        const String& pending = stream->pending;
+        size_t lineStart = 0;
+        while (lineStart < pending.size())
+        {
+            size_t lineEnd = pending.find('\n', lineStart);
+            if (lineEnd == String::npos)
+            {
+                if (!flush)
+                    break;
+
+                lineEnd = pending.size();
+            }
+
+            std::string_view line(pending.data() + lineStart,
+                                  lineEnd - lineStart);
+            lineStart = lineEnd + 1;
+
+            if (line.find_first_not_of(" \t\r") == std::string_view::npos)
+                continue;
+
+            v8::Local<v8::Value> value;
+            parser.Reset(line);
+            if (!parser.ParseDocument(&value))
+            {
+                // NOTE(patrik): The bad line is dropped so the stream can go
+                // on after the exception is caught, the lines parsed before
+                // it are handed over in the values of the error
+                stream->pending.erase(0, std::min(lineStart, pending.size()));
+
+                v8::Local<v8::Value> error =
+                    parser.CreateError(engine, "Invalid line: ");
+                error.As<v8::Object>()
+                    ->Set(isolate->GetCurrentContext(),
+                          engine->CreateString("values"),
+                          CreateArray(isolate, values))
+                    .FromJust();
+
+                isolate->ThrowException(error);
+                return;
+            }
+
+            values.push_back(value);
+        }
+
+        stream->pending.erase(0, std::min(lineStart, pending.size()));
+
+        args.GetReturnValue().Set(CreateArray(isolate, values));
+    }
+
+    static JSFUNC(parse)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(1);
+
+        ScratchBuffer buffer;
+        ArraySpan<uint8> bytes;
+        if (!TypedArray::GetBytesOrUtf8(engine, args[0], buffer.Get(), &bytes))
+        {
+            engine->ThrowException(
+                "%s: Needs argument 0 to be a String or an ArrayBufferView",
+                __FUNCTION__);
+            return;
+        }
+
+        std::string_view json((const char*)bytes.data, bytes.size);
+
+        v8::Local<v8::Value> result;
+        if (Json::Parse(engine, json).ToLocal(&result))
+            args.GetReturnValue().Set(result);
+    }
+
+    static JSFUNC(stringify)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(1);
+
+        // NOTE(patrik): A toJSON can call stringify again so every call
+        // builds in its own buffer
+        ScratchBuffer scratch;
+        String& buffer = scratch.Get();
+        if (!Json::Stringify(engine, args[0], buffer))
+            return;
+
+        if (args.Length() > 1 && !args[1]->IsUndefined())
+        {
+            JS_CHECK_ARG(JS_TYPE_INT32, 1);
+
+            // NOTE(patrik): Writes to a file descriptor ex. one from the
+            // system module without creating a javascript string
+            int32 fd =
+                args[1]->Int32Value(isolate->GetCurrentContext()).FromJust();
+
+            size_t written = 0;
+            while (written < buffer.size())
+            {
+                ssize_t result = write(fd, buffer.data() + written,
+                                       buffer.size() - written);
+                if (result == -1)
+                {
+                    if (errno == EINTR)
+                        continue;
+
+                    engine->ThrowException("File Error: %s", strerror(errno));
+                    return;
+                }
+
+                written += result;
+            }
+
+            args.GetReturnValue().Set((double)written);
+            return;
+        }
+
+        if (buffer.empty())
+            return;
+
+        v8::Local<v8::String> result;
+        if (!engine->CreateString(buffer.data(), buffer.size())
+                 .ToLocal(&result))
+        {
+            engine->ThrowException("%s: The JSON is too long for a string",
+                                   __FUNCTION__);
+            return;
+        }
+
+        args.GetReturnValue().Set(result);
+    }
+
+    static JSFUNC(Parser)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        if (!NativeObject::CheckConstructCall(engine, args, __FUNCTION__))
+            return;
+
+        NativeObject::Wrap(engine, args.This(), new NdjsonStream());
+    }
+
+    static JSFUNC(parserPush)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(1);
+
+        ScratchBuffer buffer;
+        ArraySpan<uint8> chunk;
+        if (!TypedArray::GetBytesOrUtf8(engine, args[0], buffer.Get(), &chunk))
+        {
+            engine->ThrowException(
+                "%s: Needs argument 0 to be a String or an ArrayBufferView",
+                __FUNCTION__);
+            return;
+        }
+
+        NdjsonStream* stream = NativeObject::Unwrap<NdjsonStream>(args);
+        stream->pending.append((const char*)chunk.data, chunk.size);
+
+        ParseLines(engine, stream, false, args);
+    }
+
+    static JSFUNC(parserFlush)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        ParseLines(engine, NativeObject::Unwrap<NdjsonStream>(args), true,
+                   args);
+    }
+
+    Json::Json(Engine* engine) : NativeModule(engine)
+    {
+        m_Functions["parse"] = JSFunc_parse;
+        m_Functions["stringify"] = JSFunc_stringify;
+    }
+
+    Json::~Json() { m_ParserTemplate.Reset(); }
+
+    String Json::GetPackageName() { return "json"; }
+
+    v8::Local<v8::Object> Json::GenerateObject()
+    {
+        v8::Isolate* isolate = m_Engine->GetIsolate();
+        v8::EscapableHandleScope handleScope(isolate);
+
+        v8::Local<v8::Object> result = NativeModule::GenerateObject();
+
+        if (m_ParserTemplate.IsEmpty())
+        {
+            m_ParserTemplate.Reset(
+                isolate, NativeObject::CreateClass(
+                             m_Engine, "Parser", JSFunc_Parser,
+                             {{"push", JSFunc_parserPush},
+                              {"flush", JSFunc_parserFlush}}));
+        }
+
+        v8::Local<v8::Context> context = isolate->GetCurrentContext();
+        result
+            ->Set(context, m_Engine->CreateString("Parser"),
+                  m_ParserTemplate.Get(isolate)
+                      ->GetFunction(context)
+                      .ToLocalChecked())
+            .FromJust();
+
+        return handleScope.Escape(result);
+    }
+
+    v8::MaybeLocal<v8::Value> Json::Parse(Engine* engine,
+                                          std::string_view json)
+    {
+        v8::Isolate* isolate = engine->GetIsolate();
+        v8::EscapableHandleScope handleScope(isolate);
+
+        JsonParser parser(isolate);
+        parser.Reset(json);
+
+        v8::Local<v8::Value> result;
+        if (!parser.ParseDocument(&result))
+        {
+            parser.ThrowError(engine);
+            return v8::MaybeLocal<v8::Value>();
+        }
+
+        return handleScope.Escape(result);
+    }
+
+    bool Json::Stringify(Engine* engine, v8::Local<v8::Value> value,
+                         String& out)
+    {
+        v8::HandleScope handleScope(engine->GetIsolate());
+
+        JsonWriter writer(engine, out);
+
+        bool written;
+        return writer.Write(value, engine->CreateString(""), &written);
+    }
+
+    SCRIPTER_REGISTER_NATIVE_MODULE("json", Json);
+
+}} // namespace scripter::modules
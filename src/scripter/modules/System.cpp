@@ -119,4 +119,6 @@ namespace scripter { namespace modules {
 
     String System::GetPackageName() { return "system"; }
 
+    SCRIPTER_REGISTER_NATIVE_MODULE("system", System);
+
 }} // namespace scripter::modules
\ No newline at end of file
@@ -0,0 +1,392 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/modules/VecMath.h"
+
+#include "scripter/TypedArray.h"
+
+#include "scripter/utils/VectorKernels.h"
+
+#include <math.h>
+
+#include <type_traits>
+
+namespace scripter { namespace modules {
+
+    static const size_t s_MaxBinCount = 1 << 24;
+
+    /**
+     * Calls the function with the span of a Float32Array, Float64Array or
+     * Int32Array, returns false if the value is none of them
+     */
+    template <typename TFunc>
+    static bool VisitArray(v8::Local<v8::Value> value, TFunc&& func)
+    {
+        ArraySpan<float> floats;
+        ArraySpan<double> doubles;
+        ArraySpan<int32> ints;
+
+        if (TypedArray::GetSpan(value, &floats))
+            func(floats);
+        else if (TypedArray::GetSpan(value, &doubles))
+            func(doubles);
+        else if (TypedArray::GetSpan(value, &ints))
+            func(ints);
+        else
+            return false;
+
+        return true;
+    }
+
+    /**
+     * Converts the scalar to the element type, returns false if the element
+     * type can't hold it exactly and the kernel would give a different
+     * result than the same loop in javascript
+     */
+    template <typename T>
+    static bool ToElement(v8::Local<v8::Context> context,
+                          v8::Local<v8::Value> value, T* result)
+    {
+        *result = (T)value->NumberValue(context).FromMaybe(0.0);
+        return true;
+    }
+
+    template <>
+    bool ToElement<int32>(v8::Local<v8::Context> context,
+                          v8::Local<v8::Value> value, int32* result)
+    {
+        double number = value->NumberValue(context).FromMaybe(0.0);
+        if (number != trunc(number) || number < -2147483648.0 ||
+            number > 2147483647.0)
+        {
+            return false;
+        }
+
+        *result = (int32)number;
+        return true;
+    }
+
+#define VECMATH_THROW_NOT_ARRAY(index)                                         \
+    engine->ThrowException(                                                    \
+        "%s: Needs argument %d to be a Float32Array, Float64Array or "         \
+        "Int32Array",                                                          \
+        __FUNCTION__, index)
+
+#define VECMATH_THROW_NOT_INT32(index)                                         \
+    engine->ThrowException(                                                    \
+        "%s: Needs argument %d to be an int32 for an Int32Array",              \
+        __FUNCTION__, index)
+
+    static JSFUNC(sum)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(1);
+
+        double result = 0.0;
+        if (!VisitArray(args[0], [&](auto values) {
+                typedef std::remove_reference_t<decltype(values[0])> T;
+                result = VectorKernels::GetTable<T>().sum(values.data,
+                                                          values.size);
+            }))
+        {
+            VECMATH_THROW_NOT_ARRAY(0);
+            return;
+        }
+
+        args.GetReturnValue().Set(result);
+    }
+
+    static JSFUNC(dot)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(2);
+
+        double result = 0.0;
+        bool matches = true;
+        if (!VisitArray(args[0], [&](auto a) {
+                typedef std::remove_reference_t<decltype(a[0])> T;
+
+                ArraySpan<T> b;
+                if (!TypedArray::GetSpan(args[1], &b) || b.size != a.size)
+                {
+                    matches = false;
+                    return;
+                }
+
+                result = VectorKernels::GetTable<T>().dot(a.data, b.data,
+                                                          a.size);
+            }))
+        {
+            VECMATH_THROW_NOT_ARRAY(0);
+            return;
+        }
+
+        if (!matches)
+        {
+            engine->ThrowException(
+                "%s: Needs both arrays to have the same type and length",
+                __FUNCTION__);
+            return;
+        }
+
+        args.GetReturnValue().Set(result);
+    }
+
+    static JSFUNC(axpy)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(3);
+        JS_CHECK_ARG(JS_TYPE_NUMBER, 0);
+
+        v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+        bool matches = true;
+        bool exact = true;
+        if (!VisitArray(args[1], [&](auto x) {
+                typedef std::remove_reference_t<decltype(x[0])> T;
+
+                ArraySpan<T> y;
+                if (!TypedArray::GetSpan(args[2], &y) || y.size != x.size)
+                {
+                    matches = false;
+                    return;
+                }
+
+                T alpha;
+                exact = ToElement(context, args[0], &alpha);
+                if (exact)
+                {
+                    VectorKernels::GetTable<T>().axpy(alpha, x.data, y.data,
+                                                      x.size);
+                }
+            }))
+        {
+            VECMATH_THROW_NOT_ARRAY(1);
+            return;
+        }
+
+        if (!exact)
+        {
+            VECMATH_THROW_NOT_INT32(0);
+            return;
+        }
+
+        if (!matches)
+        {
+            engine->ThrowException(
+                "%s: Needs both arrays to have the same type and length",
+                __FUNCTION__);
+            return;
+        }
+
+        args.GetReturnValue().Set(args[2]);
+    }
+
+    static JSFUNC(scale)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(2);
+        JS_CHECK_ARG(JS_TYPE_NUMBER, 1);
+
+        v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+        bool exact = true;
+        if (!VisitArray(args[0], [&](auto values) {
+                typedef std::remove_reference_t<decltype(values[0])> T;
+
+                T factor;
+                exact = ToElement(context, args[1], &factor);
+                if (exact)
+                {
+                    VectorKernels::GetTable<T>().scale(values.data, factor,
+                                                       values.size);
+                }
+            }))
+        {
+            VECMATH_THROW_NOT_ARRAY(0);
+            return;
+        }
+
+        if (!exact)
+        {
+            VECMATH_THROW_NOT_INT32(1);
+            return;
+        }
+
+        args.GetReturnValue().Set(args[0]);
+    }
+
+    static bool GetMinMax(v8::Local<v8::Value> value, double* min,
+                          double* max)
+    {
+        return VisitArray(value, [&](auto values) {
+            typedef std::remove_reference_t<decltype(values[0])> T;
+            VectorKernels::GetTable<T>().minMax(values.data, values.size, min,
+                                                max);
+        });
+    }
+
+    static JSFUNC(min)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(1);
+
+        double min, max;
+        if (!GetMinMax(args[0], &min, &max))
+        {
+            VECMATH_THROW_NOT_ARRAY(0);
+            return;
+        }
+
+        args.GetReturnValue().Set(min);
+    }
+
+    static JSFUNC(max)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(1);
+
+        double min, max;
+        if (!GetMinMax(args[0], &min, &max))
+        {
+            VECMATH_THROW_NOT_ARRAY(0);
+            return;
+        }
+
+        args.GetReturnValue().Set(max);
+    }
+
+    static JSFUNC(prefixSum)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(1);
+
+        if (!VisitArray(args[0], [](auto values) {
+                VectorKernels::PrefixSum(values.data, values.size);
+            }))
+        {
+            VECMATH_THROW_NOT_ARRAY(0);
+            return;
+        }
+
+        args.GetReturnValue().Set(args[0]);
+    }
+
+    static JSFUNC(histogram)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        v8::HandleScope handleScope(isolate);
+
+        JS_CHECK_ARGS_LENGTH(2);
+        JS_CHECK_ARG(JS_TYPE_UINT32, 1);
+
+        v8::Local<v8::Context> context = isolate->GetCurrentContext();
+
+        uint32 binCount = args[1]->Uint32Value(context).FromJust();
+        if (binCount == 0 || binCount > s_MaxBinCount)
+        {
+            engine->ThrowException("%s: Needs between 1 and %u bins",
+                                   __FUNCTION__, (uint32)s_MaxBinCount);
+            return;
+        }
+
+        // NOTE(patrik): The range is the range of the values if it's not
+        // given
+        double min, max;
+        if (!GetMinMax(args[0], &min, &max))
+        {
+            VECMATH_THROW_NOT_ARRAY(0);
+            return;
+        }
+
+        if (args.Length() > 2 && !args[2]->IsUndefined())
+            min = args[2]->NumberValue(context).FromMaybe(NAN);
+
+        if (args.Length() > 3 && !args[3]->IsUndefined())
+            max = args[3]->NumberValue(context).FromMaybe(NAN);
+
+        if (!isfinite(min) || !isfinite(max) || min > max)
+        {
+            engine->ThrowException("%s: Needs a finite range, the range of "
+                                   "values with NaN or Infinity needs to be "
+                                   "given",
+                                   __FUNCTION__);
+            return;
+        }
+
+        v8::Local<v8::ArrayBuffer> buffer =
+            v8::ArrayBuffer::New(isolate, binCount * sizeof(uint32));
+        uint32* bins = (uint32*)buffer->GetContents().Data();
+
+        VisitArray(args[0], [&](auto values) {
+            VectorKernels::Histogram(values.data, values.size, min, max,
+                                     bins, binCount);
+        });
+
+        args.GetReturnValue().Set(v8::Uint32Array::New(buffer, 0, binCount));
+    }
+
+    static JSFUNC(backend)
+    {
+        JS_FUNC_ISOLATE_ENGINE();
+        args.GetReturnValue().Set(
+            engine->CreateString(VectorKernels::Get().name));
+    }
+
+#undef VECMATH_THROW_NOT_ARRAY
+#undef VECMATH_THROW_NOT_INT32
+
+    VecMath::VecMath(Engine* engine) : NativeModule(engine)
+    {
+        m_Functions["sum"] = JSFunc_sum;
+        m_Functions["dot"] = JSFunc_dot;
+        m_Functions["axpy"] = JSFunc_axpy;
+        m_Functions["scale"] = JSFunc_scale;
+        m_Functions["min"] = JSFunc_min;
+        m_Functions["max"] = JSFunc_max;
+        m_Functions["prefixSum"] = JSFunc_prefixSum;
+        m_Functions["histogram"] = JSFunc_histogram;
+        m_Functions["backend"] = JSFunc_backend;
+    }
+
+    VecMath::~VecMath() {}
+
+    String VecMath::GetPackageName() { return "vecmath"; }
+
+    SCRIPTER_REGISTER_NATIVE_MODULE("vecmath", VecMath);
+
+}} // namespace scripter::modules
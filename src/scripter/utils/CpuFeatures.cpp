@@ -0,0 +1,76 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/utils/CpuFeatures.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define SCRIPTER_CPU_X86
+#endif
+
+namespace scripter {
+
+    struct DetectedFeatures
+    {
+        bool sse42 = false;
+        bool avx2 = false;
+        bool sha = false;
+    };
+
+    static DetectedFeatures DetectFeatures()
+    {
+        DetectedFeatures result;
+
+#ifdef SCRIPTER_CPU_X86
+        __builtin_cpu_init();
+
+        result.sse42 = __builtin_cpu_supports("sse4.2");
+
+        // NOTE(patrik): This checks that the OS saves the AVX registers too
+        result.avx2 = __builtin_cpu_supports("avx2");
+
+        uint32 eax, ebx, ecx, edx;
+        if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        {
+            result.sha = (ebx & (1u << 29)) != 0 &&
+                         __builtin_cpu_supports("ssse3") &&
+                         __builtin_cpu_supports("sse4.1");
+        }
+#endif
+
+        return result;
+    }
+
+    static const DetectedFeatures& GetFeatures()
+    {
+        static const DetectedFeatures s_Features = DetectFeatures();
+        return s_Features;
+    }
+
+    bool CpuFeatures::HasSse42() { return GetFeatures().sse42; }
+
+    bool CpuFeatures::HasAvx2() { return GetFeatures().avx2; }
+
+    bool CpuFeatures::HasSha() { return GetFeatures().sha; }
+
+} // namespace scripter
@@ -24,6 +24,9 @@
 #include "scripter/utils/File.h"
 
 #include "scripter/Logger.h"
+#include "scripter/Tracing.h"
+
+#include "scripter/utils/FileCache.h"
 
 #include <fcntl.h>
 #include <unistd.h>
@@ -34,25 +37,13 @@ namespace scripter {
 
     String File::ReadFile(const String& filePath)
     {
-        FILE* file = fopen(filePath.c_str(), "rt");
-        SCRIPTER_ASSERT(file);
+        SCRIPTER_TRACE_SCOPE("File::ReadFile");
 
+        std::shared_ptr<const MappedFile> file = FileCache::Read(filePath);
         if (!file)
-        {
-            SCRIPTER_LOG_ERROR("Could not open file '{0}'", filePath);
             return String();
-        }
-
-        fseek(file, 0, SEEK_END);
-        int32 length = ftell(file);
-        fseek(file, 0, SEEK_SET);
-
-        String result(length, 0);
-
-        fread(&result[0], 1, length, file);
-        fclose(file);
 
-        return result;
+        return String(file->GetData(), file->GetSize());
     }
 
     bool File::Exists(const String& filePath)
@@ -0,0 +1,212 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/utils/FileCache.h"
+
+#include "scripter/Logger.h"
+#include "scripter/Tracing.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace scripter {
+
+    struct FileCacheEntry
+    {
+        dev_t device;
+        ino_t inode;
+        int64 modifiedTime;
+        size_t size;
+        std::shared_ptr<const MappedFile> file;
+    };
+
+    static std::mutex s_Mutex;
+    static std::unordered_map<String, FileCacheEntry> s_Entries;
+    static size_t s_MappedBytes = 0;
+
+    static std::atomic<uint64> s_Hits(0);
+    static std::atomic<uint64> s_Misses(0);
+    static std::atomic<uint64> s_Errors(0);
+
+    static int64 GetModifiedTime(const struct stat& info)
+    {
+        return (int64)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+    }
+
+    static bool IsSameFile(const FileCacheEntry& entry, const struct stat& info)
+    {
+        return entry.device == info.st_dev && entry.inode == info.st_ino &&
+               entry.modifiedTime == GetModifiedTime(info) &&
+               entry.size == (size_t)info.st_size;
+    }
+
+    MappedFile::MappedFile(const char* data, size_t size)
+        : m_Data(data), m_Size(size)
+    {
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (m_Data)
+            munmap((void*)m_Data, m_Size);
+    }
+
+    static std::shared_ptr<const MappedFile> MapFile(const String& filePath,
+                                                     struct stat* info)
+    {
+        int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            SCRIPTER_LOG_ERROR("Could not open file '{0}': {1}", filePath,
+                               strerror(errno));
+            return nullptr;
+        }
+
+        // NOTE(patrik): The file is stat'ed again through the descriptor so
+        // the key matches the file that is actually mapped
+        if (fstat(fd, info) == -1)
+        {
+            SCRIPTER_LOG_ERROR("Could not stat file '{0}': {1}", filePath,
+                               strerror(errno));
+            close(fd);
+            return nullptr;
+        }
+
+        size_t size = (size_t)info->st_size;
+
+        // NOTE(patrik): Empty files can't be mapped. A file truncated in
+        // place while it's mapped makes the cut off pages fault, editors
+        // replace the file so the old mapping stays valid
+        const char* data = nullptr;
+        if (size > 0)
+        {
+            void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address == MAP_FAILED)
+            {
+                SCRIPTER_LOG_ERROR("Could not map file '{0}': {1}", filePath,
+                                   strerror(errno));
+                close(fd);
+                return nullptr;
+            }
+
+            data = (const char*)address;
+        }
+
+        close(fd);
+        return std::make_shared<const MappedFile>(data, size);
+    }
+
+    std::shared_ptr<const MappedFile> FileCache::Read(const String& filePath)
+    {
+        struct stat info;
+        if (stat(filePath.c_str(), &info) == -1)
+        {
+            SCRIPTER_LOG_ERROR("Could not stat file '{0}': {1}", filePath,
+                               strerror(errno));
+            s_Errors.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+
+            auto it = s_Entries.find(filePath);
+            if (it != s_Entries.end() && IsSameFile(it->second, info))
+            {
+                s_Hits.fetch_add(1, std::memory_order_relaxed);
+                return it->second.file;
+            }
+        }
+
+        SCRIPTER_TRACE_SCOPE("FileCache::MapFile");
+        s_Misses.fetch_add(1, std::memory_order_relaxed);
+
+        // NOTE(patrik): The file is mapped without the lock, if two threads
+        // map the same file the last one replaces the entry
+        std::shared_ptr<const MappedFile> file = MapFile(filePath, &info);
+        if (!file)
+        {
+            s_Errors.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(s_Mutex);
+
+        FileCacheEntry& entry = s_Entries[filePath];
+        if (entry.file)
+            s_MappedBytes -= entry.size;
+
+        entry.device = info.st_dev;
+        entry.inode = info.st_ino;
+        entry.modifiedTime = GetModifiedTime(info);
+        entry.size = file->GetSize();
+        entry.file = file;
+
+        s_MappedBytes += entry.size;
+        return file;
+    }
+
+    void FileCache::Invalidate(const String& filePath)
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+
+        auto it = s_Entries.find(filePath);
+        if (it == s_Entries.end())
+            return;
+
+        s_MappedBytes -= it->second.size;
+        s_Entries.erase(it);
+    }
+
+    void FileCache::Clear()
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+
+        s_Entries.clear();
+        s_MappedBytes = 0;
+    }
+
+    FileCacheStats FileCache::GetStats()
+    {
+        FileCacheStats result;
+        result.hits = s_Hits.load(std::memory_order_relaxed);
+        result.misses = s_Misses.load(std::memory_order_relaxed);
+        result.errors = s_Errors.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        result.entries = s_Entries.size();
+        result.mappedBytes = s_MappedBytes;
+
+        return result;
+    }
+
+} // namespace scripter
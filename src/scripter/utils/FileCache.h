@@ -0,0 +1,88 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+#include "scripter/Engine.h"
+
+#include <memory>
+
+namespace scripter {
+
+    /**
+     * A read only view of a mapped file, the file stays mapped as long as
+     * someone holds the view
+     */
+    class MappedFile
+    {
+    private:
+        const char* m_Data;
+        size_t m_Size;
+
+    public:
+        MappedFile(const char* data, size_t size);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* GetData() const { return m_Data; }
+        size_t GetSize() const { return m_Size; }
+    };
+
+    /**
+     * FileCache
+     *
+     * Maps the files read by the scripter and keeps the mappings keyed by the
+     * path, the inode and the modification time. Reading a file that hasn't
+     * changed returns the same view without reading anything, the views are
+     * shared by all the engines and threads
+     */
+    class FileCache
+    {
+    private:
+        FileCache();
+
+    public:
+        /**
+         * Returns a view of the file or nullptr if it can't be read, the
+         * error is logged
+         */
+        static std::shared_ptr<const MappedFile> Read(const String& filePath);
+
+        /**
+         * Drops the cached view of a file, the views already handed out stay
+         * valid
+         */
+        static void Invalidate(const String& filePath);
+
+        /**
+         * Drops all the cached views
+         */
+        static void Clear();
+
+        static FileCacheStats GetStats();
+    };
+
+} // namespace scripter
@@ -0,0 +1,153 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/utils/FileWatcher.h"
+
+#include "scripter/Logger.h"
+
+#include "scripter/utils/Path.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace scripter {
+
+    static const uint32 s_WatchMask =
+        IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE_SELF;
+
+    FileWatcher::FileWatcher()
+    {
+        m_Fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_Fd == -1)
+        {
+            SCRIPTER_LOG_ERROR("Could not initialize inotify: {0}",
+                               strerror(errno));
+        }
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        if (m_Fd != -1)
+            close(m_Fd);
+    }
+
+    bool FileWatcher::Watch(const String& filePath)
+    {
+        if (m_Fd == -1)
+            return false;
+
+        if (IsWatching(filePath))
+            return true;
+
+        String directoryPath = Path::GetDirectoryPath(filePath);
+
+        int wd;
+        auto it = m_WatchDescriptors.find(directoryPath);
+        if (it != m_WatchDescriptors.end())
+        {
+            wd = it->second;
+        }
+        else
+        {
+            // NOTE(patrik): Watching the same directory again returns the
+            // same descriptor so every directory is only added once
+            wd = inotify_add_watch(m_Fd, directoryPath.c_str(), s_WatchMask);
+            if (wd == -1)
+            {
+                SCRIPTER_LOG_WARNING("Could not watch '{0}': {1}",
+                                     directoryPath, strerror(errno));
+                return false;
+            }
+
+            m_WatchDescriptors[directoryPath] = wd;
+            m_Directories[wd].path = directoryPath;
+        }
+
+        m_Directories[wd].files.insert(Path::GetFileName(filePath));
+        m_Files.insert(filePath);
+
+        return true;
+    }
+
+    void FileWatcher::Unwatch(const String& filePath)
+    {
+        if (m_Files.erase(filePath) == 0)
+            return;
+
+        String directoryPath = Path::GetDirectoryPath(filePath);
+
+        auto it = m_WatchDescriptors.find(directoryPath);
+        if (it == m_WatchDescriptors.end())
+            return;
+
+        Directory& directory = m_Directories[it->second];
+        directory.files.erase(Path::GetFileName(filePath));
+
+        if (directory.files.empty())
+        {
+            inotify_rm_watch(m_Fd, it->second);
+            m_Directories.erase(it->second);
+            m_WatchDescriptors.erase(it);
+        }
+    }
+
+    std::vector<String> FileWatcher::Poll()
+    {
+        std::vector<String> result;
+        if (m_Fd == -1)
+            return result;
+
+        std::unordered_set<String> changed;
+
+        alignas(inotify_event) char buffer[4096];
+        while (true)
+        {
+            ssize_t length = read(m_Fd, buffer, sizeof(buffer));
+            if (length <= 0)
+                break;
+
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const inotify_event* event =
+                    (const inotify_event*)(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                auto it = m_Directories.find(event->wd);
+                if (it == m_Directories.end() || event->len == 0)
+                    continue;
+
+                const Directory& directory = it->second;
+                if (directory.files.find(event->name) == directory.files.end())
+                    continue;
+
+                changed.insert(Path::Append(directory.path, event->name));
+            }
+        }
+
+        result.assign(changed.begin(), changed.end());
+        return result;
+    }
+
+} // namespace scripter
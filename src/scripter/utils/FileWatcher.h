@@ -0,0 +1,80 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace scripter {
+
+    /**
+     * FileWatcher
+     *
+     * Watches files for changes with inotify, the directories of the files
+     * are watched so files replaced by editors with a rename are seen too
+     */
+    class FileWatcher
+    {
+    private:
+        struct Directory
+        {
+            String path;
+            std::unordered_set<String> files;
+        };
+
+        int m_Fd;
+        std::unordered_map<int, Directory> m_Directories;
+        std::unordered_map<String, int> m_WatchDescriptors;
+        std::unordered_set<String> m_Files;
+
+    public:
+        FileWatcher();
+        ~FileWatcher();
+
+        /**
+         * Starts watching a file, the path needs to be absolute
+         */
+        bool Watch(const String& filePath);
+
+        /**
+         * Stops watching a file
+         */
+        void Unwatch(const String& filePath);
+
+        bool IsWatching(const String& filePath) const
+        {
+            return m_Files.find(filePath) != m_Files.end();
+        }
+
+        /**
+         * Returns the watched files that changed since the last call, never
+         * blocks
+         */
+        std::vector<String> Poll();
+    };
+
+} // namespace scripter
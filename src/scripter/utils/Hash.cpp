@@ -0,0 +1,455 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/utils/Hash.h"
+
+#include "scripter/utils/CpuFeatures.h"
+
+#include <string.h>
+
+namespace scripter {
+
+    static const uint32 s_Crc32cPolynomial = 0x82F63B78;
+
+    /**
+     * The tables for slicing by 8, table n is the CRC of a byte followed by
+     * n zero bytes
+     */
+    struct Crc32cTables
+    {
+        uint32 tables[8][256];
+
+        Crc32cTables()
+        {
+            for (uint32 i = 0; i < 256; i++)
+            {
+                uint32 crc = i;
+                for (int32 bit = 0; bit < 8; bit++)
+                    crc = (crc >> 1) ^ (s_Crc32cPolynomial & (0 - (crc & 1)));
+
+                tables[0][i] = crc;
+            }
+
+            for (uint32 i = 0; i < 256; i++)
+            {
+                for (int32 n = 1; n < 8; n++)
+                {
+                    uint32 previous = tables[n - 1][i];
+                    tables[n][i] = (previous >> 8) ^ tables[0][previous & 0xFF];
+                }
+            }
+        }
+    };
+
+    static Crc32cUpdateFunc SelectCrc32c()
+    {
+        Crc32cUpdateFunc func = nullptr;
+        if (CpuFeatures::HasSse42())
+            func = GetSse42Crc32c();
+
+        return func ? func : Crc32c::UpdateScalar;
+    }
+
+    static Sha256CompressFunc SelectSha256()
+    {
+        Sha256CompressFunc func = nullptr;
+        if (CpuFeatures::HasSha())
+            func = GetShaNiSha256();
+
+        return func ? func : Sha256::CompressScalar;
+    }
+
+    static uint64 Read64(const uint8* data)
+    {
+        uint64 value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    static uint32 Read32(const uint8* data)
+    {
+        uint32 value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    static uint32 Read32BigEndian(const uint8* data)
+    {
+        return ((uint32)data[0] << 24) | ((uint32)data[1] << 16) |
+               ((uint32)data[2] << 8) | (uint32)data[3];
+    }
+
+    Crc32c::Crc32c(uint32 seed) : m_Crc(~seed) {}
+
+    void Crc32c::Update(const uint8* data, size_t length)
+    {
+        static const Crc32cUpdateFunc s_Update = SelectCrc32c();
+        m_Crc = s_Update(m_Crc, data, length);
+    }
+
+    uint32 Crc32c::Compute(const uint8* data, size_t length, uint32 seed)
+    {
+        Crc32c crc(seed);
+        crc.Update(data, length);
+        return crc.GetValue();
+    }
+
+    uint32 Crc32c::UpdateScalar(uint32 crc, const uint8* data, size_t length)
+    {
+        static const Crc32cTables s_Tables;
+        const uint32(*t)[256] = s_Tables.tables;
+
+        // NOTE(patrik): Reads 8 bytes at a time, assumes a little endian cpu
+        while (length >= 8)
+        {
+            uint64 word = Read64(data) ^ crc;
+            crc = t[7][word & 0xFF] ^ t[6][(word >> 8) & 0xFF] ^
+                  t[5][(word >> 16) & 0xFF] ^ t[4][(word >> 24) & 0xFF] ^
+                  t[3][(word >> 32) & 0xFF] ^ t[2][(word >> 40) & 0xFF] ^
+                  t[1][(word >> 48) & 0xFF] ^ t[0][word >> 56];
+
+            data += 8;
+            length -= 8;
+        }
+
+        while (length > 0)
+        {
+            crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xFF];
+            data++;
+            length--;
+        }
+
+        return crc;
+    }
+
+    static const uint64 s_Prime64_1 = 0x9E3779B185EBCA87ull;
+    static const uint64 s_Prime64_2 = 0xC2B2AE3D27D4EB4Full;
+    static const uint64 s_Prime64_3 = 0x165667B19E3779F9ull;
+    static const uint64 s_Prime64_4 = 0x85EBCA77C2B2AE63ull;
+    static const uint64 s_Prime64_5 = 0x27D4EB2F165667C5ull;
+
+    static uint64 RotateLeft(uint64 value, int32 count)
+    {
+        return (value << count) | (value >> (64 - count));
+    }
+
+    static uint64 XxRound(uint64 accumulator, uint64 input)
+    {
+        accumulator += input * s_Prime64_2;
+        accumulator = RotateLeft(accumulator, 31);
+        return accumulator * s_Prime64_1;
+    }
+
+    static uint64 XxMergeRound(uint64 hash, uint64 accumulator)
+    {
+        hash ^= XxRound(0, accumulator);
+        return hash * s_Prime64_1 + s_Prime64_4;
+    }
+
+    XxHash64::XxHash64(uint64 seed)
+        : m_BufferSize(0), m_TotalLength(0), m_Seed(seed)
+    {
+        m_Accumulators[0] = seed + s_Prime64_1 + s_Prime64_2;
+        m_Accumulators[1] = seed + s_Prime64_2;
+        m_Accumulators[2] = seed;
+        m_Accumulators[3] = seed - s_Prime64_1;
+    }
+
+    void XxHash64::Update(const uint8* data, size_t length)
+    {
+        m_TotalLength += length;
+
+        if (m_BufferSize > 0)
+        {
+            size_t count = sizeof(m_Buffer) - m_BufferSize;
+            if (count > length)
+                count = length;
+
+            memcpy(m_Buffer + m_BufferSize, data, count);
+            m_BufferSize += count;
+            data += count;
+            length -= count;
+
+            if (m_BufferSize < sizeof(m_Buffer))
+                return;
+
+            for (int32 i = 0; i < 4; i++)
+            {
+                m_Accumulators[i] =
+                    XxRound(m_Accumulators[i], Read64(m_Buffer + i * 8));
+            }
+
+            m_BufferSize = 0;
+        }
+
+        // NOTE(patrik): The four lanes don't depend on each other so the
+        // cpu runs their multiplies in parallel
+        uint64 v1 = m_Accumulators[0];
+        uint64 v2 = m_Accumulators[1];
+        uint64 v3 = m_Accumulators[2];
+        uint64 v4 = m_Accumulators[3];
+
+        while (length >= 32)
+        {
+            v1 = XxRound(v1, Read64(data));
+            v2 = XxRound(v2, Read64(data + 8));
+            v3 = XxRound(v3, Read64(data + 16));
+            v4 = XxRound(v4, Read64(data + 24));
+
+            data += 32;
+            length -= 32;
+        }
+
+        m_Accumulators[0] = v1;
+        m_Accumulators[1] = v2;
+        m_Accumulators[2] = v3;
+        m_Accumulators[3] = v4;
+
+        memcpy(m_Buffer, data, length);
+        m_BufferSize = length;
+    }
+
+    uint64 XxHash64::Finish() const
+    {
+        uint64 hash;
+        if (m_TotalLength >= 32)
+        {
+            const uint64* v = m_Accumulators;
+            hash = RotateLeft(v[0], 1) + RotateLeft(v[1], 7) +
+                   RotateLeft(v[2], 12) + RotateLeft(v[3], 18);
+
+            for (int32 i = 0; i < 4; i++)
+                hash = XxMergeRound(hash, v[i]);
+        }
+        else
+        {
+            hash = m_Seed + s_Prime64_5;
+        }
+
+        hash += m_TotalLength;
+
+        const uint8* data = m_Buffer;
+        size_t length = m_BufferSize;
+
+        while (length >= 8)
+        {
+            hash ^= XxRound(0, Read64(data));
+            hash = RotateLeft(hash, 27) * s_Prime64_1 + s_Prime64_4;
+            data += 8;
+            length -= 8;
+        }
+
+        if (length >= 4)
+        {
+            hash ^= (uint64)Read32(data) * s_Prime64_1;
+            hash = RotateLeft(hash, 23) * s_Prime64_2 + s_Prime64_3;
+            data += 4;
+            length -= 4;
+        }
+
+        while (length > 0)
+        {
+            hash ^= *data * s_Prime64_5;
+            hash = RotateLeft(hash, 11) * s_Prime64_1;
+            data++;
+            length--;
+        }
+
+        hash ^= hash >> 33;
+        hash *= s_Prime64_2;
+        hash ^= hash >> 29;
+        hash *= s_Prime64_3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    uint64 XxHash64::Compute(const uint8* data, size_t length, uint64 seed)
+    {
+        XxHash64 hash(seed);
+        hash.Update(data, length);
+        return hash.Finish();
+    }
+
+    const uint32 Sha256::s_RoundConstants[64] = {
+        0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1,
+        0x923F82A4, 0xAB1C5ED5, 0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+        0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174, 0xE49B69C1, 0xEFBE4786,
+        0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+        0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147,
+        0x06CA6351, 0x14292967, 0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+        0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85, 0xA2BFE8A1, 0xA81A664B,
+        0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+        0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A,
+        0x5B9CCA4F, 0x682E6FF3, 0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+        0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2};
+
+    Sha256::Sha256() : m_BufferSize(0), m_TotalLength(0)
+    {
+        static const uint32 s_InitialState[8] = {
+            0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+            0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19};
+
+        memcpy(m_State, s_InitialState, sizeof(m_State));
+    }
+
+    void Sha256::Update(const uint8* data, size_t length)
+    {
+        m_TotalLength += length;
+
+        if (m_BufferSize > 0)
+        {
+            size_t count = BLOCK_SIZE - m_BufferSize;
+            if (count > length)
+                count = length;
+
+            memcpy(m_Buffer + m_BufferSize, data, count);
+            m_BufferSize += count;
+            data += count;
+            length -= count;
+
+            if (m_BufferSize < BLOCK_SIZE)
+                return;
+
+            Compress(m_State, m_Buffer, 1);
+            m_BufferSize = 0;
+        }
+
+        size_t blockCount = length / BLOCK_SIZE;
+        if (blockCount > 0)
+        {
+            Compress(m_State, data, blockCount);
+            data += blockCount * BLOCK_SIZE;
+            length -= blockCount * BLOCK_SIZE;
+        }
+
+        memcpy(m_Buffer, data, length);
+        m_BufferSize = length;
+    }
+
+    void Sha256::Finish(uint8 digest[DIGEST_SIZE]) const
+    {
+        uint32 state[8];
+        memcpy(state, m_State, sizeof(state));
+
+        // NOTE(patrik): The padding is a one bit, zeros and the length in
+        // bits at the end of the last block
+        uint8 blocks[BLOCK_SIZE * 2] = {};
+        memcpy(blocks, m_Buffer, m_BufferSize);
+        blocks[m_BufferSize] = 0x80;
+
+        size_t blockCount = m_BufferSize + 1 + 8 <= BLOCK_SIZE ? 1 : 2;
+        uint64 bitLength = m_TotalLength * 8;
+        for (int32 i = 0; i < 8; i++)
+        {
+            blocks[blockCount * BLOCK_SIZE - 1 - i] =
+                (uint8)(bitLength >> (i * 8));
+        }
+
+        Compress(state, blocks, blockCount);
+
+        for (int32 i = 0; i < 8; i++)
+        {
+            digest[i * 4] = (uint8)(state[i] >> 24);
+            digest[i * 4 + 1] = (uint8)(state[i] >> 16);
+            digest[i * 4 + 2] = (uint8)(state[i] >> 8);
+            digest[i * 4 + 3] = (uint8)state[i];
+        }
+    }
+
+    void Sha256::Compute(const uint8* data, size_t length,
+                         uint8 digest[DIGEST_SIZE])
+    {
+        Sha256 hash;
+        hash.Update(data, length);
+        hash.Finish(digest);
+    }
+
+    static uint32 RotateRight(uint32 value, int32 count)
+    {
+        return (value >> count) | (value << (32 - count));
+    }
+
+    void Sha256::CompressScalar(uint32 state[8], const uint8* blocks,
+                                size_t blockCount)
+    {
+        for (size_t block = 0; block < blockCount; block++)
+        {
+            const uint8* data = blocks + block * BLOCK_SIZE;
+
+            uint32 w[64];
+            for (int32 i = 0; i < 16; i++)
+                w[i] = Read32BigEndian(data + i * 4);
+
+            for (int32 i = 16; i < 64; i++)
+            {
+                uint32 s0 = RotateRight(w[i - 15], 7) ^
+                            RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32 s1 = RotateRight(w[i - 2], 17) ^
+                            RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            uint32 a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32 e = state[4], f = state[5], g = state[6], h = state[7];
+
+            for (int32 i = 0; i < 64; i++)
+            {
+                uint32 s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^
+                            RotateRight(e, 25);
+                uint32 choose = (e & f) ^ (~e & g);
+                uint32 t1 = h + s1 + choose + s_RoundConstants[i] + w[i];
+
+                uint32 s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^
+                            RotateRight(a, 22);
+                uint32 majority = (a & b) ^ (a & c) ^ (b & c);
+                uint32 t2 = s0 + majority;
+
+                h = g;
+                g = f;
+                f = e;
+                e = d + t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 + t2;
+            }
+
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+            state[5] += f;
+            state[6] += g;
+            state[7] += h;
+        }
+    }
+
+    void Sha256::Compress(uint32 state[8], const uint8* blocks,
+                          size_t blockCount)
+    {
+        static const Sha256CompressFunc s_Compress = SelectSha256();
+        s_Compress(state, blocks, blockCount);
+    }
+
+} // namespace scripter
@@ -0,0 +1,137 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+
+namespace scripter {
+
+    typedef uint32 (*Crc32cUpdateFunc)(uint32 crc, const uint8* data,
+                                       size_t length);
+    typedef void (*Sha256CompressFunc)(uint32 state[8], const uint8* blocks,
+                                       size_t blockCount);
+
+    /**
+     * Defined in HashSse.cpp and HashSha.cpp, return nullptr if the compiler
+     * can't build for the instructions
+     */
+    Crc32cUpdateFunc GetSse42Crc32c();
+    Sha256CompressFunc GetShaNiSha256();
+
+    /**
+     * Crc32c
+     *
+     * The Castagnoli CRC used by iSCSI, ext4 and many storage formats, uses
+     * the crc32 instruction of SSE4.2 when the cpu has it
+     */
+    class Crc32c
+    {
+    private:
+        uint32 m_Crc;
+
+    public:
+        /**
+         * @param seed the CRC of the data before, to continue a checksum
+         */
+        Crc32c(uint32 seed = 0);
+
+        void Update(const uint8* data, size_t length);
+        uint32 GetValue() const { return ~m_Crc; }
+
+        static uint32 Compute(const uint8* data, size_t length,
+                              uint32 seed = 0);
+
+        static uint32 UpdateScalar(uint32 crc, const uint8* data,
+                                   size_t length);
+    };
+
+    /**
+     * XxHash64
+     *
+     * The 64 bit xxHash, a fast non cryptographic hash
+     */
+    class XxHash64
+    {
+    private:
+        uint64 m_Accumulators[4];
+        uint8 m_Buffer[32];
+        size_t m_BufferSize;
+        uint64 m_TotalLength;
+        uint64 m_Seed;
+
+    public:
+        XxHash64(uint64 seed = 0);
+
+        void Update(const uint8* data, size_t length);
+
+        /**
+         * Returns the hash of the data so far, more data can be added after
+         */
+        uint64 Finish() const;
+
+        static uint64 Compute(const uint8* data, size_t length,
+                              uint64 seed = 0);
+    };
+
+    /**
+     * Sha256
+     *
+     * SHA-256, uses the SHA extensions when the cpu has them
+     */
+    class Sha256
+    {
+    public:
+        static const size_t DIGEST_SIZE = 32;
+        static const size_t BLOCK_SIZE = 64;
+
+        static const uint32 s_RoundConstants[64];
+
+    private:
+        uint32 m_State[8];
+        uint8 m_Buffer[BLOCK_SIZE];
+        size_t m_BufferSize;
+        uint64 m_TotalLength;
+
+    public:
+        Sha256();
+
+        void Update(const uint8* data, size_t length);
+
+        /**
+         * Writes the digest of the data so far, more data can be added after
+         */
+        void Finish(uint8 digest[DIGEST_SIZE]) const;
+
+        static void Compute(const uint8* data, size_t length,
+                            uint8 digest[DIGEST_SIZE]);
+
+        static void CompressScalar(uint32 state[8], const uint8* blocks,
+                                   size_t blockCount);
+
+    private:
+        static void Compress(uint32 state[8], const uint8* blocks,
+                             size_t blockCount);
+    };
+
+} // namespace scripter
@@ -0,0 +1,134 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(__clang__)
+#pragma clang attribute push(                                                  \
+    __attribute__((target("sha,sse4.1,ssse3"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("sha,sse4.1,ssse3")
+#endif
+#define SCRIPTER_HASH_SHA
+#endif
+
+#include "scripter/utils/Hash.h"
+
+#ifdef SCRIPTER_HASH_SHA
+#include <immintrin.h>
+#endif
+
+namespace scripter {
+
+#ifdef SCRIPTER_HASH_SHA
+
+    namespace {
+
+        void CompressSha256ShaNi(uint32 state[8], const uint8* blocks,
+                                 size_t blockCount)
+        {
+            const __m128i byteSwap =
+                _mm_set_epi64x(0x0C0D0E0F08090A0Bll, 0x0405060700010203ll);
+            const uint32* roundConstants = Sha256::s_RoundConstants;
+
+            // NOTE(patrik): The instructions want the state as ABEF and CDGH
+            __m128i tmp = _mm_loadu_si128((const __m128i*)state);
+            __m128i s1 = _mm_loadu_si128((const __m128i*)(state + 4));
+
+            tmp = _mm_shuffle_epi32(tmp, 0xB1);
+            s1 = _mm_shuffle_epi32(s1, 0x1B);
+            __m128i s0 = _mm_alignr_epi8(tmp, s1, 8);
+            s1 = _mm_blend_epi16(s1, tmp, 0xF0);
+
+            for (size_t block = 0; block < blockCount; block++)
+            {
+                const __m128i* data = (const __m128i*)(blocks + block * 64);
+                __m128i abef = s0;
+                __m128i cdgh = s1;
+                __m128i m[4];
+
+                // NOTE(patrik): Four rounds per iteration, the message
+                // schedule for the rounds ahead is computed on the way
+#if defined(__clang__)
+#pragma clang loop unroll(full)
+#elif defined(__GNUC__)
+#pragma GCC unroll 16
+#endif
+                for (int32 k = 0; k < 16; k++)
+                {
+                    if (k < 4)
+                    {
+                        m[k] = _mm_shuffle_epi8(_mm_loadu_si128(data + k),
+                                                byteSwap);
+                    }
+
+                    __m128i constants = _mm_loadu_si128(
+                        (const __m128i*)(roundConstants + k * 4));
+                    __m128i msg = _mm_add_epi32(m[k & 3], constants);
+                    s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+
+                    if (k >= 3 && k <= 14)
+                    {
+                        __m128i next = _mm_add_epi32(
+                            m[(k + 1) & 3],
+                            _mm_alignr_epi8(m[k & 3], m[(k - 1) & 3], 4));
+                        m[(k + 1) & 3] = _mm_sha256msg2_epu32(next, m[k & 3]);
+                    }
+
+                    msg = _mm_shuffle_epi32(msg, 0x0E);
+                    s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+
+                    if (k >= 1 && k <= 12)
+                    {
+                        m[(k - 1) & 3] =
+                            _mm_sha256msg1_epu32(m[(k - 1) & 3], m[k & 3]);
+                    }
+                }
+
+                s0 = _mm_add_epi32(s0, abef);
+                s1 = _mm_add_epi32(s1, cdgh);
+            }
+
+            tmp = _mm_shuffle_epi32(s0, 0x1B);
+            s1 = _mm_shuffle_epi32(s1, 0xB1);
+            s0 = _mm_blend_epi16(tmp, s1, 0xF0);
+            s1 = _mm_alignr_epi8(s1, tmp, 8);
+
+            _mm_storeu_si128((__m128i*)state, s0);
+            _mm_storeu_si128((__m128i*)(state + 4), s1);
+        }
+
+    } // namespace
+
+    Sha256CompressFunc GetShaNiSha256() { return CompressSha256ShaNi; }
+
+#else
+
+    Sha256CompressFunc GetShaNiSha256() { return nullptr; }
+
+#endif
+
+} // namespace scripter
+
+#if defined(SCRIPTER_HASH_SHA) && defined(__clang__)
+#pragma clang attribute pop
+#endif
@@ -0,0 +1,105 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse4.2"))),               \
+                             apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("sse4.2")
+#endif
+#define SCRIPTER_HASH_SSE42
+#endif
+
+#include "scripter/utils/Hash.h"
+
+#ifdef SCRIPTER_HASH_SSE42
+#include <nmmintrin.h>
+#include <string.h>
+#endif
+
+namespace scripter {
+
+#ifdef SCRIPTER_HASH_SSE42
+
+    namespace {
+
+        uint32 UpdateCrc32cSse42(uint32 crc, const uint8* data, size_t length)
+        {
+            // NOTE(patrik): The crc32 instruction does the same polynomial as
+            // CRC32C, the head is done a byte at a time so the words are
+            // aligned
+            while (length > 0 && ((uintptr_t)data & 7) != 0)
+            {
+                crc = _mm_crc32_u8(crc, *data);
+                data++;
+                length--;
+            }
+
+#if defined(__x86_64__)
+            uint64 crc64 = crc;
+            while (length >= 8)
+            {
+                uint64 word;
+                memcpy(&word, data, sizeof(word));
+                crc64 = _mm_crc32_u64(crc64, word);
+                data += 8;
+                length -= 8;
+            }
+            crc = (uint32)crc64;
+#endif
+
+            while (length >= 4)
+            {
+                uint32 word;
+                memcpy(&word, data, sizeof(word));
+                crc = _mm_crc32_u32(crc, word);
+                data += 4;
+                length -= 4;
+            }
+
+            while (length > 0)
+            {
+                crc = _mm_crc32_u8(crc, *data);
+                data++;
+                length--;
+            }
+
+            return crc;
+        }
+
+    } // namespace
+
+    Crc32cUpdateFunc GetSse42Crc32c() { return UpdateCrc32cSse42; }
+
+#else
+
+    Crc32cUpdateFunc GetSse42Crc32c() { return nullptr; }
+
+#endif
+
+} // namespace scripter
+
+#if defined(SCRIPTER_HASH_SSE42) && defined(__clang__)
+#pragma clang attribute pop
+#endif
@@ -0,0 +1,139 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/utils/Json.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace scripter {
+
+    void Json::AppendString(String& out, const char* value)
+    {
+        AppendString(out, value, strlen(value));
+    }
+
+    static void AppendEscape(String& out, char c)
+    {
+        switch (c)
+        {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+            {
+                char buffer[8];
+                snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                out += buffer;
+                break;
+            }
+        }
+    }
+
+    void Json::AppendString(String& out, const char* value, size_t length)
+    {
+        out += '"';
+
+        // NOTE(patrik): The characters that don't need escaping are appended
+        // in runs
+        const char* end = value + length;
+        const char* run = value;
+        for (const char* c = value; c < end; c++)
+        {
+            if (*c != '"' && *c != '\\' && (uint8)*c >= 0x20)
+                continue;
+
+            out.append(run, c - run);
+            run = c + 1;
+
+            AppendEscape(out, *c);
+        }
+
+        out.append(run, end - run);
+        out += '"';
+    }
+
+    void Json::AppendString(String& out, const uint16* value, size_t length)
+    {
+        out += '"';
+
+        for (size_t i = 0; i < length; i++)
+        {
+            uint32 c = value[i];
+            if (c < 0x80)
+            {
+                if (c == '"' || c == '\\' || c < 0x20)
+                    AppendEscape(out, (char)c);
+                else
+                    out += (char)c;
+
+                continue;
+            }
+
+            if (c >= 0xD800 && c <= 0xDFFF)
+            {
+                uint32 low = i + 1 < length ? value[i + 1] : 0;
+                if (c <= 0xDBFF && low >= 0xDC00 && low <= 0xDFFF)
+                {
+                    c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                    i++;
+                }
+                else
+                {
+                    // NOTE(patrik): A lone surrogate has no UTF-8 form so it's
+                    // escaped like JSON.stringify does
+                    char buffer[8];
+                    snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    out += buffer;
+                    continue;
+                }
+            }
+
+            if (c < 0x800)
+            {
+                out += (char)(0xC0 | (c >> 6));
+                out += (char)(0x80 | (c & 0x3F));
+            }
+            else if (c < 0x10000)
+            {
+                out += (char)(0xE0 | (c >> 12));
+                out += (char)(0x80 | ((c >> 6) & 0x3F));
+                out += (char)(0x80 | (c & 0x3F));
+            }
+            else
+            {
+                out += (char)(0xF0 | (c >> 18));
+                out += (char)(0x80 | ((c >> 12) & 0x3F));
+                out += (char)(0x80 | ((c >> 6) & 0x3F));
+                out += (char)(0x80 | (c & 0x3F));
+            }
+        }
+
+        out += '"';
+    }
+
+} // namespace scripter
@@ -28,11 +28,19 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <unistd.h>
+
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
 #include <linux/limits.h>
 
 namespace scripter {
 
-    static char buffer[PATH_MAX] = {};
+    static std::shared_mutex s_FullPathMutex;
+    static std::unordered_map<String, String> s_FullPaths;
 
     String Path::GetFileName(const String& path)
     {
@@ -57,14 +65,42 @@ namespace scripter {
 
     String Path::GetFullPath(const String& path)
     {
-        memset(buffer, 0, PATH_MAX);
+        // NOTE(patrik): Relative paths are cached with the working directory
+        // so changing the directory doesn't return stale paths
+        String key = path;
+        if (path.empty() || path[0] != '/')
+        {
+            char directory[PATH_MAX];
+            if (getcwd(directory, PATH_MAX))
+                key = Append(directory, path);
+        }
+
+        {
+            std::shared_lock<std::shared_mutex> lock(s_FullPathMutex);
+
+            auto it = s_FullPaths.find(key);
+            if (it != s_FullPaths.end())
+                return it->second;
+        }
+
+        char buffer[PATH_MAX];
+        if (!realpath(key.c_str(), buffer))
+            return String();
 
-        realpath(path.c_str(), buffer);
         String result(buffer);
 
+        std::unique_lock<std::shared_mutex> lock(s_FullPathMutex);
+        s_FullPaths[key] = result;
+
         return result;
     }
 
+    void Path::ClearCache()
+    {
+        std::unique_lock<std::shared_mutex> lock(s_FullPathMutex);
+        s_FullPaths.clear();
+    }
+
     String Path::Append(const String& path, const String& path2)
     {
         String result = path;
@@ -75,4 +111,55 @@ namespace scripter {
         return result;
     }
 
-} // namespace scripter
\ No newline at end of file
+    String Path::Normalize(const String& path)
+    {
+        bool absolute = !path.empty() && path[0] == '/';
+
+        std::vector<String> parts;
+        size_t start = 0;
+        while (start <= path.length())
+        {
+            size_t end = path.find('/', start);
+            if (end == String::npos)
+                end = path.length();
+
+            String part = path.substr(start, end - start);
+            if (part == "..")
+            {
+                if (!parts.empty() && parts.back() != "..")
+                    parts.pop_back();
+                else if (!absolute)
+                    parts.push_back(part);
+            }
+            else if (!part.empty() && part != ".")
+            {
+                parts.push_back(part);
+            }
+
+            start = end + 1;
+        }
+
+        String result = absolute ? "/" : "";
+        for (size_t i = 0; i < parts.size(); i++)
+        {
+            if (i != 0)
+                result.append(1, '/');
+            result.append(parts[i]);
+        }
+
+        return result;
+    }
+
+    String Path::GetAbsolutePath(const String& path)
+    {
+        if (!path.empty() && path[0] == '/')
+            return Normalize(path);
+
+        char directory[PATH_MAX] = {};
+        if (!getcwd(directory, PATH_MAX))
+            return Normalize(path);
+
+        return Normalize(Append(directory, path));
+    }
+
+} // namespace scripter
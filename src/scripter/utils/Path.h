@@ -36,8 +36,21 @@ namespace scripter {
         static String GetFileName(const String& path);
         static String GetFileExtension(const String& path);
         static String GetDirectoryPath(const String& path);
+        /**
+         * Returns the canonical absolute path or an empty string if the path
+         * doesn't exist, the results are cached until ClearCache is called.
+         * Safe to call from any thread
+         */
         static String GetFullPath(const String& path);
         static String Append(const String& path, const String& path2);
+        static String Normalize(const String& path);
+        static String GetAbsolutePath(const String& path);
+
+        /**
+         * Forgets the cached full paths, call this when files have been
+         * moved or links changed
+         */
+        static void ClearCache();
     };
 
 } // namespace scripter
\ No newline at end of file
@@ -0,0 +1,61 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/utils/ScratchBuffer.h"
+
+#include <memory>
+#include <vector>
+
+namespace scripter {
+
+    // NOTE(patrik): Buffers that grew past this are freed instead of kept so
+    // one huge document doesn't hold on to its memory for the thread's life
+    static const size_t s_MaxPooledCapacity = 16 * 1024 * 1024;
+
+    static thread_local std::vector<std::unique_ptr<String>> t_FreeBuffers;
+
+    ScratchBuffer::ScratchBuffer()
+    {
+        if (t_FreeBuffers.empty())
+        {
+            m_Buffer = new String();
+            return;
+        }
+
+        m_Buffer = t_FreeBuffers.back().release();
+        t_FreeBuffers.pop_back();
+    }
+
+    ScratchBuffer::~ScratchBuffer()
+    {
+        if (m_Buffer->capacity() > s_MaxPooledCapacity)
+        {
+            delete m_Buffer;
+            return;
+        }
+
+        m_Buffer->clear();
+        t_FreeBuffers.emplace_back(m_Buffer);
+    }
+
+} // namespace scripter
@@ -0,0 +1,76 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/utils/SearchPath.h"
+
+#include "scripter/utils/File.h"
+#include "scripter/utils/Path.h"
+
+#include <mutex>
+
+namespace scripter {
+
+    SearchPath::SearchPath() {}
+
+    SearchPath::SearchPath(const std::vector<String>& directories)
+        : m_Directories(directories)
+    {
+    }
+
+    void SearchPath::Add(const String& directory)
+    {
+        std::unique_lock<std::shared_mutex> lock(m_Mutex);
+        m_Directories.push_back(directory);
+    }
+
+    std::vector<String> SearchPath::GetDirectories() const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_Mutex);
+        return m_Directories;
+    }
+
+    String SearchPath::Find(const String& fileName,
+                            const String& firstDirectory) const
+    {
+        if (!firstDirectory.empty())
+        {
+            String filePath = Path::Append(firstDirectory, fileName);
+            if (File::Exists(filePath))
+                return Path::GetFullPath(filePath);
+        }
+
+        std::shared_lock<std::shared_mutex> lock(m_Mutex);
+        for (const String& directory : m_Directories)
+        {
+            if (directory.empty())
+                continue;
+
+            String filePath = Path::Append(directory, fileName);
+            if (File::Exists(filePath))
+                return Path::GetFullPath(filePath);
+        }
+
+        return String();
+    }
+
+} // namespace scripter
@@ -0,0 +1,67 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+
+#include <shared_mutex>
+#include <vector>
+
+namespace scripter {
+
+    /**
+     * SearchPath
+     *
+     * A list of directories searched in order for a file, used by the module
+     * importers. Directories can be added while other threads search
+     */
+    class SearchPath
+    {
+    private:
+        mutable std::shared_mutex m_Mutex;
+        std::vector<String> m_Directories;
+
+    public:
+        SearchPath();
+        SearchPath(const std::vector<String>& directories);
+
+        /**
+         * Adds a directory to the end of the search path
+         */
+        void Add(const String& directory);
+
+        std::vector<String> GetDirectories() const;
+
+        /**
+         * Returns the full path of the file in the first directory that has
+         * it or an empty string if no directory has it
+         * @param fileName the relative path of the file
+         * @param firstDirectory a directory searched before the others, ex.
+         * the directory of the importing script
+         */
+        String Find(const String& fileName,
+                    const String& firstDirectory = String()) const;
+    };
+
+} // namespace scripter
@@ -0,0 +1,222 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/utils/TaskScheduler.h"
+
+#include "scripter/Logger.h"
+
+#include "scripter/utils/ThreadPool.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace scripter {
+
+    // NOTE(patrik): Used to find the queue of the current worker, the
+    // scheduler is stored too in case there's more than one scheduler
+    static thread_local TaskScheduler* t_Scheduler = nullptr;
+    static thread_local int32 t_WorkerIndex = -1;
+
+    TaskScheduler::TaskScheduler(int32 threadCount, bool pinThreads)
+        : m_PendingTasks(0), m_NextWorker(0), m_Running(true)
+    {
+        if (threadCount <= 0)
+            threadCount = ThreadPool::GetDefaultThreadCount();
+
+        for (int32 i = 0; i < threadCount; i++)
+            m_Workers.push_back(new Worker());
+
+        int32 coreCount = ThreadPool::GetDefaultThreadCount();
+        for (int32 i = 0; i < threadCount; i++)
+        {
+            Worker* worker = m_Workers[i];
+            worker->thread = std::thread(&TaskScheduler::WorkerLoop, this, i);
+
+            if (pinThreads)
+            {
+                cpu_set_t cpuSet;
+                CPU_ZERO(&cpuSet);
+                CPU_SET(i % coreCount, &cpuSet);
+
+                if (pthread_setaffinity_np(worker->thread.native_handle(),
+                                           sizeof(cpuSet), &cpuSet) != 0)
+                {
+                    SCRIPTER_LOG_WARNING("Could not pin worker {0} to core {1}",
+                                         i, i % coreCount);
+                }
+            }
+        }
+
+        m_TimerThread = std::thread(&TaskScheduler::TimerLoop, this);
+    }
+
+    TaskScheduler::~TaskScheduler()
+    {
+        m_Running.store(false);
+
+        {
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+            m_SleepCondition.notify_all();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_TimerMutex);
+            m_TimerCondition.notify_all();
+        }
+
+        // NOTE(patrik): Every thread has to be stopped before any worker is
+        // deleted, the workers steal from each other and the timer thread
+        // submits to them
+        for (Worker* worker : m_Workers)
+            worker->thread.join();
+
+        m_TimerThread.join();
+
+        for (Worker* worker : m_Workers)
+            delete worker;
+
+        m_Workers.clear();
+    }
+
+    void TaskScheduler::Submit(Task task, TaskPriority priority)
+    {
+        int32 index = t_Scheduler == this
+                          ? t_WorkerIndex
+                          : (int32)(m_NextWorker.fetch_add(1) %
+                                    m_Workers.size());
+
+        Worker* worker = m_Workers[index];
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->queues[(int32)priority].push_back(std::move(task));
+        }
+
+        m_PendingTasks.fetch_add(1);
+
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+        m_SleepCondition.notify_one();
+    }
+
+    void TaskScheduler::SubmitDelayed(Task task, double delayInSeconds,
+                                      TaskPriority priority)
+    {
+        auto delay = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::duration<double>(delayInSeconds));
+        auto deadline = std::chrono::steady_clock::now() + delay;
+
+        std::lock_guard<std::mutex> lock(m_TimerMutex);
+        m_DelayedTasks.emplace(deadline,
+                               DelayedTask{std::move(task), priority});
+        m_TimerCondition.notify_one();
+    }
+
+    bool TaskScheduler::TryPop(int32 workerIndex, Task* task)
+    {
+        int32 workerCount = (int32)m_Workers.size();
+
+        for (int32 priority = 0; priority < PRIORITY_COUNT; priority++)
+        {
+            // NOTE(patrik): The worker takes its own newest task first and
+            // steals the oldest tasks from the others
+            {
+                Worker* worker = m_Workers[workerIndex];
+                std::lock_guard<std::mutex> lock(worker->mutex);
+
+                std::deque<Task>& queue = worker->queues[priority];
+                if (!queue.empty())
+                {
+                    *task = std::move(queue.back());
+                    queue.pop_back();
+                    return true;
+                }
+            }
+
+            for (int32 i = 1; i < workerCount; i++)
+            {
+                Worker* victim = m_Workers[(workerIndex + i) % workerCount];
+                std::lock_guard<std::mutex> lock(victim->mutex);
+
+                std::deque<Task>& queue = victim->queues[priority];
+                if (!queue.empty())
+                {
+                    *task = std::move(queue.front());
+                    queue.pop_front();
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    void TaskScheduler::WorkerLoop(int32 workerIndex)
+    {
+        t_Scheduler = this;
+        t_WorkerIndex = workerIndex;
+
+        while (m_Running.load())
+        {
+            Task task;
+            if (TryPop(workerIndex, &task))
+            {
+                m_PendingTasks.fetch_sub(1);
+                task();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_SleepMutex);
+            m_SleepCondition.wait(lock, [this]() {
+                return m_PendingTasks.load() > 0 || !m_Running.load();
+            });
+        }
+    }
+
+    void TaskScheduler::TimerLoop()
+    {
+        std::unique_lock<std::mutex> lock(m_TimerMutex);
+
+        while (m_Running.load())
+        {
+            if (m_DelayedTasks.empty())
+            {
+                m_TimerCondition.wait(lock);
+                continue;
+            }
+
+            auto first = m_DelayedTasks.begin();
+            if (first->first > std::chrono::steady_clock::now())
+            {
+                m_TimerCondition.wait_until(lock, first->first);
+                continue;
+            }
+
+            DelayedTask delayed = std::move(first->second);
+            m_DelayedTasks.erase(first);
+
+            lock.unlock();
+            Submit(std::move(delayed.task), delayed.priority);
+            lock.lock();
+        }
+    }
+
+} // namespace scripter
@@ -0,0 +1,118 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace scripter {
+
+    enum class TaskPriority
+    {
+        High,
+        Low
+    };
+
+    /**
+     * TaskScheduler
+     *
+     * A work stealing pool of worker threads, every worker has its own
+     * queues and takes work from the other workers when its own queues are
+     * empty. High priority tasks are always run before low priority tasks
+     */
+    class TaskScheduler
+    {
+    public:
+        typedef std::function<void()> Task;
+
+    private:
+        static const int32 PRIORITY_COUNT = 2;
+
+        struct Worker
+        {
+            std::thread thread;
+            std::mutex mutex;
+            std::deque<Task> queues[PRIORITY_COUNT];
+        };
+
+        struct DelayedTask
+        {
+            Task task;
+            TaskPriority priority;
+        };
+
+        std::vector<Worker*> m_Workers;
+        std::atomic<int64> m_PendingTasks;
+        std::atomic<uint32> m_NextWorker;
+        std::atomic<bool> m_Running;
+
+        std::mutex m_SleepMutex;
+        std::condition_variable m_SleepCondition;
+
+        std::thread m_TimerThread;
+        std::mutex m_TimerMutex;
+        std::condition_variable m_TimerCondition;
+        std::multimap<std::chrono::steady_clock::time_point, DelayedTask>
+            m_DelayedTasks;
+
+    public:
+        /**
+         * Constructor
+         * @param threadCount the number of workers, 0 uses the number of
+         * cores
+         * @param pinThreads pins every worker to its own core
+         */
+        TaskScheduler(int32 threadCount, bool pinThreads);
+        ~TaskScheduler();
+
+        /**
+         * Queues a task, tasks submitted from a worker are queued on the same
+         * worker
+         */
+        void Submit(Task task, TaskPriority priority);
+
+        /**
+         * Queues a task after a delay
+         */
+        void SubmitDelayed(Task task, double delayInSeconds,
+                           TaskPriority priority);
+
+        int32 GetThreadCount() const { return (int32)m_Workers.size(); }
+
+    private:
+        bool TryPop(int32 workerIndex, Task* task);
+        void WorkerLoop(int32 workerIndex);
+        void TimerLoop();
+    };
+
+} // namespace scripter
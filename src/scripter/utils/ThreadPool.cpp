@@ -0,0 +1,110 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/utils/ThreadPool.h"
+
+namespace scripter {
+
+    ThreadPool::ThreadPool(int32 threadCount)
+        : m_ActiveTasks(0), m_Running(true)
+    {
+        if (threadCount <= 0)
+            threadCount = GetDefaultThreadCount();
+
+        for (int32 i = 0; i < threadCount; i++)
+        {
+            m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Running = false;
+        }
+
+        m_TaskCondition.notify_all();
+
+        for (std::thread& worker : m_Workers)
+        {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::Submit(Task task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Tasks.push_back(std::move(task));
+        }
+
+        m_TaskCondition.notify_one();
+    }
+
+    void ThreadPool::WaitIdle()
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_IdleCondition.wait(
+            lock, [this]() { return m_Tasks.empty() && m_ActiveTasks == 0; });
+    }
+
+    int32 ThreadPool::GetDefaultThreadCount()
+    {
+        int32 count = (int32)std::thread::hardware_concurrency();
+        return count > 0 ? count : 1;
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        while (true)
+        {
+            Task task;
+
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_TaskCondition.wait(
+                    lock, [this]() { return !m_Running || !m_Tasks.empty(); });
+
+                // NOTE(patrik): The queue is drained before the worker stops
+                if (m_Tasks.empty())
+                    return;
+
+                task = std::move(m_Tasks.front());
+                m_Tasks.pop_front();
+                m_ActiveTasks++;
+            }
+
+            task();
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_ActiveTasks--;
+
+                if (m_Tasks.empty() && m_ActiveTasks == 0)
+                    m_IdleCondition.notify_all();
+            }
+        }
+    }
+
+} // namespace scripter
@@ -0,0 +1,83 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace scripter {
+
+    /**
+     * ThreadPool
+     *
+     * A simple pool of worker threads that runs the submitted tasks in order
+     */
+    class ThreadPool
+    {
+    public:
+        typedef std::function<void()> Task;
+
+    private:
+        std::vector<std::thread> m_Workers;
+        std::deque<Task> m_Tasks;
+
+        std::mutex m_Mutex;
+        std::condition_variable m_TaskCondition;
+        std::condition_variable m_IdleCondition;
+
+        int32 m_ActiveTasks;
+        bool m_Running;
+
+    public:
+        ThreadPool(int32 threadCount);
+        ~ThreadPool();
+
+        /**
+         * Queues a task to be run on one of the workers
+         */
+        void Submit(Task task);
+
+        /**
+         * Blocks until all the queued tasks are done
+         */
+        void WaitIdle();
+
+        int32 GetThreadCount() const { return (int32)m_Workers.size(); }
+
+        /**
+         * Returns the number of threads to use if nothing else is specified
+         */
+        static int32 GetDefaultThreadCount();
+
+    private:
+        void WorkerLoop();
+    };
+
+} // namespace scripter
@@ -0,0 +1,162 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/utils/Utf8.h"
+
+#include "scripter/utils/CpuFeatures.h"
+
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace scripter {
+
+    static Utf8ValidateFunc SelectValidator()
+    {
+        Utf8ValidateFunc validator = nullptr;
+        if (CpuFeatures::HasSse42())
+            validator = GetSse42Utf8Validator();
+
+        return validator ? validator : Utf8::IsValidScalar;
+    }
+
+    bool Utf8::IsAscii(const uint8* data, size_t length)
+    {
+        size_t i = 0;
+
+#ifdef __SSE2__
+        // NOTE(patrik): The high bits of 64 bytes are or'd together before
+        // they're checked so the loop has only one branch
+        for (; i + 64 <= length; i += 64)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(data + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(data + i + 16));
+            __m128i c = _mm_loadu_si128((const __m128i*)(data + i + 32));
+            __m128i d = _mm_loadu_si128((const __m128i*)(data + i + 48));
+
+            __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+            if (_mm_movemask_epi8(any))
+                return false;
+        }
+
+        for (; i + 16 <= length; i += 16)
+        {
+            __m128i chunk = _mm_loadu_si128((const __m128i*)(data + i));
+            if (_mm_movemask_epi8(chunk))
+                return false;
+        }
+#endif
+
+        for (; i < length; i++)
+        {
+            if (data[i] >= 0x80)
+                return false;
+        }
+
+        return true;
+    }
+
+    bool Utf8::IsValid(const uint8* data, size_t length)
+    {
+        static const Utf8ValidateFunc s_Validator = SelectValidator();
+        return s_Validator(data, length);
+    }
+
+    bool Utf8::IsValidScalar(const uint8* data, size_t length)
+    {
+        size_t i = 0;
+        while (i < length)
+        {
+            // NOTE(patrik): Most text is ASCII so 8 bytes are skipped at once
+            if (i + 8 <= length)
+            {
+                uint64 word;
+                memcpy(&word, data + i, sizeof(word));
+                if ((word & 0x8080808080808080ull) == 0)
+                {
+                    i += 8;
+                    continue;
+                }
+            }
+
+            uint8 lead = data[i];
+            if (lead < 0x80)
+            {
+                i++;
+                continue;
+            }
+
+            size_t count;
+            uint8 low = 0x80;
+            uint8 high = 0xBF;
+
+            if (lead >= 0xC2 && lead <= 0xDF)
+            {
+                count = 1;
+            }
+            else if (lead >= 0xE0 && lead <= 0xEF)
+            {
+                count = 2;
+
+                // NOTE(patrik): The second byte limits rule out the overlong
+                // forms and the surrogates
+                if (lead == 0xE0)
+                    low = 0xA0;
+                else if (lead == 0xED)
+                    high = 0x9F;
+            }
+            else if (lead >= 0xF0 && lead <= 0xF4)
+            {
+                count = 3;
+
+                if (lead == 0xF0)
+                    low = 0x90;
+                else if (lead == 0xF4)
+                    high = 0x8F;
+            }
+            else
+            {
+                return false;
+            }
+
+            if (length - i <= count)
+                return false;
+
+            if (data[i + 1] < low || data[i + 1] > high)
+                return false;
+
+            for (size_t j = 2; j <= count; j++)
+            {
+                if ((data[i + j] & 0xC0) != 0x80)
+                    return false;
+            }
+
+            i += count + 1;
+        }
+
+        return true;
+    }
+
+} // namespace scripter
@@ -0,0 +1,64 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+
+namespace scripter {
+
+    typedef bool (*Utf8ValidateFunc)(const uint8* data, size_t length);
+
+    /**
+     * Defined in Utf8Sse.cpp, returns nullptr if the compiler can't build
+     * for SSE4.2
+     */
+    Utf8ValidateFunc GetSse42Utf8Validator();
+
+    /**
+     * Utf8
+     *
+     * Checks of UTF-8 text, uses the vector instructions of the cpu when it
+     * has them
+     */
+    class Utf8
+    {
+    private:
+        Utf8();
+
+    public:
+        static bool IsAscii(const uint8* data, size_t length);
+
+        /**
+         * Returns true if the data is valid UTF-8, overlong forms,
+         * surrogates and code points above U+10FFFF are invalid
+         */
+        static bool IsValid(const uint8* data, size_t length);
+
+        /**
+         * The scalar validation, used when the cpu has no SSE4.2
+         */
+        static bool IsValidScalar(const uint8* data, size_t length);
+    };
+
+} // namespace scripter
@@ -0,0 +1,203 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse4.2"))),               \
+                             apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("sse4.2")
+#endif
+#define SCRIPTER_UTF8_SSE42
+#endif
+
+#include "scripter/utils/Utf8.h"
+
+#ifdef SCRIPTER_UTF8_SSE42
+#include <smmintrin.h>
+#include <string.h>
+#endif
+
+namespace scripter {
+
+#ifdef SCRIPTER_UTF8_SSE42
+
+    namespace {
+
+        // NOTE(patrik): The lookup validation of Keiser and Lemire, every
+        // byte is checked together with the byte before it through three
+        // table lookups. An error is a bit that is set in all three tables
+        const uint8 TOO_SHORT = 1 << 0;
+        const uint8 TOO_LONG = 1 << 1;
+        const uint8 OVERLONG_3 = 1 << 2;
+        const uint8 TOO_LARGE = 1 << 3;
+        const uint8 SURROGATE = 1 << 4;
+        const uint8 OVERLONG_2 = 1 << 5;
+        const uint8 TOO_LARGE_1000 = 1 << 6;
+        const uint8 OVERLONG_4 = 1 << 6;
+        const uint8 TWO_CONTS = 1 << 7;
+        const uint8 CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+        inline __m128i ShiftRight4(__m128i value)
+        {
+            return _mm_and_si128(_mm_srli_epi16(value, 4), _mm_set1_epi8(0x0F));
+        }
+
+        inline __m128i CheckSpecialCases(__m128i input, __m128i prev1)
+        {
+            // The high nibble of the previous byte
+            const __m128i byte1HighTable = _mm_setr_epi8(
+                TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                TOO_LONG, TOO_LONG, TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+                TOO_SHORT | OVERLONG_2, TOO_SHORT,
+                TOO_SHORT | OVERLONG_3 | SURROGATE,
+                TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+
+            // The low nibble of the previous byte
+            const __m128i byte1LowTable = _mm_setr_epi8(
+                CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+                CARRY | OVERLONG_2, CARRY, CARRY, CARRY | TOO_LARGE,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+                CARRY | TOO_LARGE | TOO_LARGE_1000,
+                CARRY | TOO_LARGE | TOO_LARGE_1000);
+
+            // The high nibble of the current byte
+            const __m128i byte2HighTable = _mm_setr_epi8(
+                TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 |
+                    TOO_LARGE_1000 | OVERLONG_4,
+                TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+                TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+            __m128i byte1High =
+                _mm_shuffle_epi8(byte1HighTable, ShiftRight4(prev1));
+            __m128i byte1Low = _mm_shuffle_epi8(
+                byte1LowTable, _mm_and_si128(prev1, _mm_set1_epi8(0x0F)));
+            __m128i byte2High =
+                _mm_shuffle_epi8(byte2HighTable, ShiftRight4(input));
+
+            return _mm_and_si128(_mm_and_si128(byte1High, byte1Low),
+                                 byte2High);
+        }
+
+        inline __m128i CheckBlock(__m128i input, __m128i previous)
+        {
+            __m128i prev1 = _mm_alignr_epi8(input, previous, 15);
+            __m128i special = CheckSpecialCases(input, prev1);
+
+            // NOTE(patrik): The third and fourth bytes of a sequence need to
+            // be continuations, the special cases only see two bytes
+            __m128i prev2 = _mm_alignr_epi8(input, previous, 14);
+            __m128i prev3 = _mm_alignr_epi8(input, previous, 13);
+
+            __m128i isThirdByte =
+                _mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80)));
+            __m128i isFourthByte =
+                _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80)));
+            __m128i must23 = _mm_and_si128(_mm_or_si128(isThirdByte,
+                                                        isFourthByte),
+                                           _mm_set1_epi8((char)0x80));
+
+            return _mm_xor_si128(must23, special);
+        }
+
+        /**
+         * Non zero if the block ends in the middle of a sequence
+         */
+        inline __m128i CheckIncomplete(__m128i input)
+        {
+            const __m128i maxValue = _mm_setr_epi8(
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+
+            return _mm_subs_epu8(input, maxValue);
+        }
+
+        bool IsValidSse42(const uint8* data, size_t length)
+        {
+            __m128i error = _mm_setzero_si128();
+            __m128i previous = _mm_setzero_si128();
+            __m128i incomplete = _mm_setzero_si128();
+
+            size_t i = 0;
+            while (i < length)
+            {
+                __m128i input;
+                if (i + 16 <= length)
+                {
+                    input = _mm_loadu_si128((const __m128i*)(data + i));
+                }
+                else
+                {
+                    // NOTE(patrik): The tail is padded with zeros, they're
+                    // ASCII so a sequence cut off by the end is an error
+                    uint8 tail[16] = {};
+                    memcpy(tail, data + i, length - i);
+                    input = _mm_loadu_si128((const __m128i*)tail);
+                }
+
+                if (_mm_movemask_epi8(input) == 0)
+                {
+                    error = _mm_or_si128(error, incomplete);
+                    incomplete = _mm_setzero_si128();
+                }
+                else
+                {
+                    error = _mm_or_si128(error, CheckBlock(input, previous));
+                    incomplete = CheckIncomplete(input);
+                }
+
+                previous = input;
+                i += 16;
+            }
+
+            error = _mm_or_si128(error, incomplete);
+            return _mm_testz_si128(error, error);
+        }
+
+    } // namespace
+
+    Utf8ValidateFunc GetSse42Utf8Validator() { return IsValidSse42; }
+
+#else
+
+    Utf8ValidateFunc GetSse42Utf8Validator() { return nullptr; }
+
+#endif
+
+} // namespace scripter
+
+#if defined(SCRIPTER_UTF8_SSE42) && defined(__clang__)
+#pragma clang attribute pop
+#endif
@@ -0,0 +1,221 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scripter/utils/VectorKernels.h"
+
+#include "scripter/utils/CpuFeatures.h"
+#include "scripter/utils/VectorKernelsImpl.h"
+
+#include <math.h>
+
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace scripter {
+
+    namespace {
+
+        /**
+         * One element at a time, used when the cpu has none of the
+         * instruction sets
+         */
+        template <typename T>
+        struct ScalarOps
+        {
+            typedef T Scalar;
+            typedef T Vec;
+            typedef typename KernelAccum<T>::Type Accum;
+            typedef bool NanMask;
+
+            static const size_t Width = 1;
+
+            static Vec Load(const T* p) { return *p; }
+            static void Store(T* p, Vec v) { *p = v; }
+            static Vec Set(T v) { return v; }
+
+            static Vec Add(Vec a, Vec b) { return scripter::Add(a, b); }
+            static Vec Mul(Vec a, Vec b) { return scripter::Mul(a, b); }
+            static Vec Min(Vec a, Vec b) { return b < a ? b : a; }
+            static Vec Max(Vec a, Vec b) { return b > a ? b : a; }
+
+            static Accum AccumZero() { return 0; }
+            static Accum AccumAdd(Accum a, Accum b) { return a + b; }
+
+            static void Accumulate(Accum& acc, Vec v) { acc += v; }
+            static void MulAccumulate(Accum& acc, Vec a, Vec b)
+            {
+                acc += (Accum)a * (Accum)b;
+            }
+
+            static Accum Reduce(Accum acc) { return acc; }
+
+            static NanMask NoNan() { return false; }
+            static NanMask AddNan(NanMask mask, Vec v)
+            {
+                return mask || IsNan(v);
+            }
+            static bool AnyNan(NanMask mask) { return mask; }
+        };
+
+        static const VectorKernelSet s_ScalarKernels = {
+            "scalar", MakeKernelTable<ScalarOps<float>>(),
+            MakeKernelTable<ScalarOps<double>>(),
+            MakeKernelTable<ScalarOps<int32>>()};
+
+        static const VectorKernelSet* SelectKernels()
+        {
+            const VectorKernelSet* kernels = nullptr;
+
+            if (CpuFeatures::HasAvx2())
+                kernels = GetAvx2VectorKernels();
+
+            if (!kernels && CpuFeatures::HasSse42())
+                kernels = GetSse42VectorKernels();
+
+            return kernels ? kernels : GetScalarVectorKernels();
+        }
+
+        template <typename T>
+        void FloatPrefixSum(T* values, size_t count)
+        {
+            // NOTE(patrik): Kept in order so the sums are rounded the same
+            // way as a javascript loop, every sum depends on the one before
+            // so vectors wouldn't help much anyway
+            T sum = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                sum += values[i];
+                values[i] = sum;
+            }
+        }
+
+    } // namespace
+
+    const VectorKernelSet* GetScalarVectorKernels() { return &s_ScalarKernels; }
+
+    const VectorKernelSet& VectorKernels::Get()
+    {
+        static const VectorKernelSet* s_Kernels = SelectKernels();
+        return *s_Kernels;
+    }
+
+    void VectorKernels::PrefixSum(float* values, size_t count)
+    {
+        FloatPrefixSum(values, count);
+    }
+
+    void VectorKernels::PrefixSum(double* values, size_t count)
+    {
+        FloatPrefixSum(values, count);
+    }
+
+    void VectorKernels::PrefixSum(int32* values, size_t count)
+    {
+        size_t i = 0;
+        uint32 sum = 0;
+
+#ifdef __SSE2__
+        // NOTE(patrik): Integer sums are exact so the vector can be scanned
+        // in two shifted adds, the last lane carries into the next vector
+        __m128i carry = _mm_setzero_si128();
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i value = _mm_loadu_si128((const __m128i*)(values + i));
+            value = _mm_add_epi32(value, _mm_slli_si128(value, 4));
+            value = _mm_add_epi32(value, _mm_slli_si128(value, 8));
+            value = _mm_add_epi32(value, carry);
+
+            _mm_storeu_si128((__m128i*)(values + i), value);
+            carry = _mm_shuffle_epi32(value, _MM_SHUFFLE(3, 3, 3, 3));
+        }
+
+        if (i > 0)
+            sum = (uint32)values[i - 1];
+#endif
+
+        for (; i < count; i++)
+        {
+            sum += (uint32)values[i];
+            values[i] = (int32)sum;
+        }
+    }
+
+    template <typename T>
+    void VectorKernels::Histogram(const T* values, size_t count, double min,
+                                  double max, uint32* bins, size_t binCount)
+    {
+        if (binCount == 0)
+            return;
+
+        // NOTE(patrik): A range wider than the largest double is computed
+        // with halved values so the offsets don't overflow to infinity
+        double factor = isinf(max - min) ? 0.5 : 1.0;
+        double scaledMin = min * factor;
+        double range = max * factor - scaledMin;
+        double scale = range > 0.0 ? (double)binCount / range : 0.0;
+
+        // NOTE(patrik): Runs of values in the same bin would wait on the
+        // increment before, four sets of counters let them overlap
+        const size_t setCount = count >= 4 * binCount ? 4 : 1;
+        std::vector<uint32> counters(setCount > 1 ? setCount * binCount : 0);
+        uint32* sets = setCount > 1 ? counters.data() : bins;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            double value = (double)values[i];
+            if (!(value >= min && value <= max))
+                continue;
+
+            // NOTE(patrik): The comparison also catches NaN from an infinite
+            // bound, converting NaN to an integer is undefined
+            double position = (value * factor - scaledMin) * scale;
+            size_t bin = position < (double)binCount ? (size_t)position
+                                                      : binCount - 1;
+
+            sets[(i & (setCount - 1)) * binCount + bin]++;
+        }
+
+        if (setCount == 1)
+            return;
+
+        for (size_t set = 0; set < setCount; set++)
+        {
+            for (size_t bin = 0; bin < binCount; bin++)
+                bins[bin] += sets[set * binCount + bin];
+        }
+    }
+
+    template void VectorKernels::Histogram<float>(const float*, size_t,
+                                                  double, double, uint32*,
+                                                  size_t);
+    template void VectorKernels::Histogram<double>(const double*, size_t,
+                                                   double, double, uint32*,
+                                                   size_t);
+    template void VectorKernels::Histogram<int32>(const int32*, size_t,
+                                                  double, double, uint32*,
+                                                  size_t);
+
+} // namespace scripter
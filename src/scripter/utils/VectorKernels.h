@@ -0,0 +1,124 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/Common.h"
+
+namespace scripter {
+
+    /**
+     * The kernels for one element type, the sums and the dot products are
+     * accumulated in doubles for floats and in 64 bit integers for int32
+     */
+    template <typename T>
+    struct VectorKernelTable
+    {
+        double (*sum)(const T* values, size_t count);
+        double (*dot)(const T* a, const T* b, size_t count);
+
+        /** y = alpha * x + y */
+        void (*axpy)(T alpha, const T* x, T* y, size_t count);
+        void (*scale)(T* values, T factor, size_t count);
+
+        /**
+         * Returns infinity and -infinity for no values and NaN for both if
+         * any value is NaN
+         */
+        void (*minMax)(const T* values, size_t count, double* min,
+                       double* max);
+    };
+
+    /**
+     * The kernels built for one instruction set
+     */
+    struct VectorKernelSet
+    {
+        const char* name;
+        VectorKernelTable<float> f32;
+        VectorKernelTable<double> f64;
+        VectorKernelTable<int32> i32;
+    };
+
+    /**
+     * Defined by the translation units of the instruction sets, return
+     * nullptr if the compiler can't build for the instruction set
+     */
+    const VectorKernelSet* GetAvx2VectorKernels();
+    const VectorKernelSet* GetSse42VectorKernels();
+    const VectorKernelSet* GetScalarVectorKernels();
+
+    /**
+     * VectorKernels
+     *
+     * Math kernels over arrays of floats, doubles and int32s. The kernels for
+     * the best instruction set the cpu supports are picked the first time
+     * they're used. Integer math wraps around like the int32 typed arrays
+     */
+    class VectorKernels
+    {
+    private:
+        VectorKernels();
+
+    public:
+        static const VectorKernelSet& Get();
+
+        template <typename T>
+        static const VectorKernelTable<T>& GetTable();
+
+        /**
+         * Replaces every value with the sum of it and the values before it
+         */
+        static void PrefixSum(float* values, size_t count);
+        static void PrefixSum(double* values, size_t count);
+        static void PrefixSum(int32* values, size_t count);
+
+        /**
+         * Counts the values into bins of the same width between min and max,
+         * max goes in the last bin. NaN and values outside the range aren't
+         * counted
+         */
+        template <typename T>
+        static void Histogram(const T* values, size_t count, double min,
+                              double max, uint32* bins, size_t binCount);
+    };
+
+    template <>
+    inline const VectorKernelTable<float>& VectorKernels::GetTable<float>()
+    {
+        return Get().f32;
+    }
+
+    template <>
+    inline const VectorKernelTable<double>& VectorKernels::GetTable<double>()
+    {
+        return Get().f64;
+    }
+
+    template <>
+    inline const VectorKernelTable<int32>& VectorKernels::GetTable<int32>()
+    {
+        return Get().i32;
+    }
+
+} // namespace scripter
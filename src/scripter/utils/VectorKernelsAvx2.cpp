@@ -0,0 +1,242 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))),                 \
+                             apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx2")
+#endif
+#define SCRIPTER_VECTOR_KERNELS_AVX2
+#endif
+
+#include "scripter/utils/VectorKernelsImpl.h"
+
+#ifdef SCRIPTER_VECTOR_KERNELS_AVX2
+#include <immintrin.h>
+#endif
+
+namespace scripter {
+
+#ifdef SCRIPTER_VECTOR_KERNELS_AVX2
+
+    namespace {
+
+        struct Avx2Double
+        {
+            typedef double Scalar;
+            typedef __m256d Vec;
+            typedef __m256d Accum;
+            typedef __m256d NanMask;
+
+            static const size_t Width = 4;
+
+            static Vec Load(const double* p) { return _mm256_loadu_pd(p); }
+            static void Store(double* p, Vec v) { _mm256_storeu_pd(p, v); }
+            static Vec Set(double v) { return _mm256_set1_pd(v); }
+
+            static Vec Add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+            static Vec Mul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+            static Vec Min(Vec a, Vec b) { return _mm256_min_pd(a, b); }
+            static Vec Max(Vec a, Vec b) { return _mm256_max_pd(a, b); }
+
+            static Accum AccumZero() { return _mm256_setzero_pd(); }
+            static Accum AccumAdd(Accum a, Accum b) { return Add(a, b); }
+
+            static void Accumulate(Accum& acc, Vec v) { acc = Add(acc, v); }
+            static void MulAccumulate(Accum& acc, Vec a, Vec b)
+            {
+                acc = Add(acc, Mul(a, b));
+            }
+
+            static double Reduce(Accum acc)
+            {
+                __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(acc),
+                                         _mm256_extractf128_pd(acc, 1));
+                sum = _mm_add_sd(sum, _mm_unpackhi_pd(sum, sum));
+                return _mm_cvtsd_f64(sum);
+            }
+
+            static NanMask NoNan() { return _mm256_setzero_pd(); }
+            static NanMask AddNan(NanMask mask, Vec v)
+            {
+                return _mm256_or_pd(mask, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+            }
+            static bool AnyNan(NanMask mask)
+            {
+                return _mm256_movemask_pd(mask) != 0;
+            }
+        };
+
+        struct Avx2Float
+        {
+            typedef float Scalar;
+            typedef __m256 Vec;
+            typedef __m256 NanMask;
+
+            // NOTE(patrik): The floats are summed as doubles like javascript
+            // would, half of the vector in each accumulator
+            struct Accum
+            {
+                __m256d low;
+                __m256d high;
+            };
+
+            static const size_t Width = 8;
+
+            static Vec Load(const float* p) { return _mm256_loadu_ps(p); }
+            static void Store(float* p, Vec v) { _mm256_storeu_ps(p, v); }
+            static Vec Set(float v) { return _mm256_set1_ps(v); }
+
+            static Vec Add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+            static Vec Mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+            static Vec Min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+            static Vec Max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+
+            static __m256d Low(Vec v)
+            {
+                return _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+            }
+            static __m256d High(Vec v)
+            {
+                return _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+            }
+
+            static Accum AccumZero()
+            {
+                return {_mm256_setzero_pd(), _mm256_setzero_pd()};
+            }
+            static Accum AccumAdd(Accum a, Accum b)
+            {
+                return {_mm256_add_pd(a.low, b.low),
+                        _mm256_add_pd(a.high, b.high)};
+            }
+
+            static void Accumulate(Accum& acc, Vec v)
+            {
+                acc.low = _mm256_add_pd(acc.low, Low(v));
+                acc.high = _mm256_add_pd(acc.high, High(v));
+            }
+            static void MulAccumulate(Accum& acc, Vec a, Vec b)
+            {
+                acc.low = _mm256_add_pd(acc.low, _mm256_mul_pd(Low(a), Low(b)));
+                acc.high =
+                    _mm256_add_pd(acc.high, _mm256_mul_pd(High(a), High(b)));
+            }
+
+            static double Reduce(Accum acc)
+            {
+                return Avx2Double::Reduce(_mm256_add_pd(acc.low, acc.high));
+            }
+
+            static NanMask NoNan() { return _mm256_setzero_ps(); }
+            static NanMask AddNan(NanMask mask, Vec v)
+            {
+                return _mm256_or_ps(mask, _mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+            }
+            static bool AnyNan(NanMask mask)
+            {
+                return _mm256_movemask_ps(mask) != 0;
+            }
+        };
+
+        struct Avx2Int32
+        {
+            typedef int32 Scalar;
+            typedef __m256i Vec;
+            typedef __m256i Accum;
+            typedef bool NanMask;
+
+            static const size_t Width = 8;
+
+            static Vec Load(const int32* p)
+            {
+                return _mm256_loadu_si256((const __m256i*)p);
+            }
+            static void Store(int32* p, Vec v)
+            {
+                _mm256_storeu_si256((__m256i*)p, v);
+            }
+            static Vec Set(int32 v) { return _mm256_set1_epi32(v); }
+
+            static Vec Add(Vec a, Vec b) { return _mm256_add_epi32(a, b); }
+            static Vec Mul(Vec a, Vec b) { return _mm256_mullo_epi32(a, b); }
+            static Vec Min(Vec a, Vec b) { return _mm256_min_epi32(a, b); }
+            static Vec Max(Vec a, Vec b) { return _mm256_max_epi32(a, b); }
+
+            // NOTE(patrik): The sums are 64 bit so they can't overflow
+            static Accum AccumZero() { return _mm256_setzero_si256(); }
+            static Accum AccumAdd(Accum a, Accum b)
+            {
+                return _mm256_add_epi64(a, b);
+            }
+
+            static void Accumulate(Accum& acc, Vec v)
+            {
+                acc = _mm256_add_epi64(
+                    acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+                acc = _mm256_add_epi64(
+                    acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+            }
+            static void MulAccumulate(Accum& acc, Vec a, Vec b)
+            {
+                // NOTE(patrik): mul_epi32 multiplies the even lanes into 64
+                // bit products, the odd lanes are shifted down first
+                __m256i even = _mm256_mul_epi32(a, b);
+                __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32),
+                                               _mm256_srli_epi64(b, 32));
+                acc = _mm256_add_epi64(acc, _mm256_add_epi64(even, odd));
+            }
+
+            static int64 Reduce(Accum acc)
+            {
+                int64 lanes[4];
+                _mm256_storeu_si256((__m256i*)lanes, acc);
+                return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+            }
+
+            static NanMask NoNan() { return false; }
+            static NanMask AddNan(NanMask mask, Vec v) { return false; }
+            static bool AnyNan(NanMask mask) { return false; }
+        };
+
+        static const VectorKernelSet s_Avx2Kernels = {
+            "avx2", MakeKernelTable<Avx2Float>(),
+            MakeKernelTable<Avx2Double>(), MakeKernelTable<Avx2Int32>()};
+
+    } // namespace
+
+    const VectorKernelSet* GetAvx2VectorKernels() { return &s_Avx2Kernels; }
+
+#else
+
+    const VectorKernelSet* GetAvx2VectorKernels() { return nullptr; }
+
+#endif
+
+} // namespace scripter
+
+#if defined(SCRIPTER_VECTOR_KERNELS_AVX2) && defined(__clang__)
+#pragma clang attribute pop
+#endif
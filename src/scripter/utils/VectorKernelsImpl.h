@@ -0,0 +1,242 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "scripter/utils/VectorKernels.h"
+
+// NOTE(patrik): This is included by the translation units of every
+// instruction set, each of them compiles the kernels with its own target.
+// Everything is in an anonymous namespace so the linker can't merge a
+// function built for AVX2 with the one the scalar kernels call
+
+namespace scripter { namespace {
+
+    template <typename T>
+    struct KernelAccum
+    {
+        typedef double Type;
+    };
+
+    template <>
+    struct KernelAccum<int32>
+    {
+        typedef int64 Type;
+    };
+
+    inline float MulAdd(float a, float x, float y) { return a * x + y; }
+    inline double MulAdd(double a, double x, double y) { return a * x + y; }
+    inline int32 MulAdd(int32 a, int32 x, int32 y)
+    {
+        return (int32)((uint32)a * (uint32)x + (uint32)y);
+    }
+
+    inline float Add(float a, float b) { return a + b; }
+    inline double Add(double a, double b) { return a + b; }
+    inline int32 Add(int32 a, int32 b)
+    {
+        return (int32)((uint32)a + (uint32)b);
+    }
+
+    inline float Mul(float a, float b) { return a * b; }
+    inline double Mul(double a, double b) { return a * b; }
+    inline int32 Mul(int32 a, int32 b)
+    {
+        return (int32)((uint32)a * (uint32)b);
+    }
+
+    template <typename T>
+    inline bool IsNan(T value)
+    {
+        return value != value;
+    }
+
+    // NOTE(patrik): Ops is the instruction set, Vec holds Width elements and
+    // Accum holds partial sums in the accumulation type
+
+    template <typename Ops>
+    double SumKernel(const typename Ops::Scalar* values, size_t count)
+    {
+        typedef typename Ops::Scalar T;
+        const size_t width = Ops::Width;
+
+        // NOTE(patrik): Two accumulators so the adds of one iteration don't
+        // wait on each other
+        typename Ops::Accum acc0 = Ops::AccumZero();
+        typename Ops::Accum acc1 = Ops::AccumZero();
+
+        size_t i = 0;
+        for (; i + 2 * width <= count; i += 2 * width)
+        {
+            Ops::Accumulate(acc0, Ops::Load(values + i));
+            Ops::Accumulate(acc1, Ops::Load(values + i + width));
+        }
+
+        for (; i + width <= count; i += width)
+            Ops::Accumulate(acc0, Ops::Load(values + i));
+
+        typename KernelAccum<T>::Type result =
+            Ops::Reduce(Ops::AccumAdd(acc0, acc1));
+
+        for (; i < count; i++)
+            result += values[i];
+
+        return (double)result;
+    }
+
+    template <typename Ops>
+    double DotKernel(const typename Ops::Scalar* a,
+                     const typename Ops::Scalar* b, size_t count)
+    {
+        typedef typename Ops::Scalar T;
+        typedef typename KernelAccum<T>::Type Accum;
+        const size_t width = Ops::Width;
+
+        typename Ops::Accum acc0 = Ops::AccumZero();
+        typename Ops::Accum acc1 = Ops::AccumZero();
+
+        size_t i = 0;
+        for (; i + 2 * width <= count; i += 2 * width)
+        {
+            Ops::MulAccumulate(acc0, Ops::Load(a + i), Ops::Load(b + i));
+            Ops::MulAccumulate(acc1, Ops::Load(a + i + width),
+                               Ops::Load(b + i + width));
+        }
+
+        for (; i + width <= count; i += width)
+            Ops::MulAccumulate(acc0, Ops::Load(a + i), Ops::Load(b + i));
+
+        Accum result = Ops::Reduce(Ops::AccumAdd(acc0, acc1));
+        for (; i < count; i++)
+            result += (Accum)a[i] * (Accum)b[i];
+
+        return (double)result;
+    }
+
+    template <typename Ops>
+    void AxpyKernel(typename Ops::Scalar alpha, const typename Ops::Scalar* x,
+                    typename Ops::Scalar* y, size_t count)
+    {
+        const size_t width = Ops::Width;
+        typename Ops::Vec alphaVec = Ops::Set(alpha);
+
+        size_t i = 0;
+        for (; i + width <= count; i += width)
+        {
+            Ops::Store(y + i, Ops::Add(Ops::Mul(alphaVec, Ops::Load(x + i)),
+                                       Ops::Load(y + i)));
+        }
+
+        for (; i < count; i++)
+            y[i] = MulAdd(alpha, x[i], y[i]);
+    }
+
+    template <typename Ops>
+    void ScaleKernel(typename Ops::Scalar* values,
+                     typename Ops::Scalar factor, size_t count)
+    {
+        const size_t width = Ops::Width;
+        typename Ops::Vec factorVec = Ops::Set(factor);
+
+        size_t i = 0;
+        for (; i + width <= count; i += width)
+            Ops::Store(values + i, Ops::Mul(Ops::Load(values + i), factorVec));
+
+        for (; i < count; i++)
+            values[i] = Mul(values[i], factor);
+    }
+
+    template <typename Ops>
+    void MinMaxKernel(const typename Ops::Scalar* values, size_t count,
+                      double* min, double* max)
+    {
+        typedef typename Ops::Scalar T;
+        const size_t width = Ops::Width;
+
+        if (count == 0)
+        {
+            *min = __builtin_inf();
+            *max = -__builtin_inf();
+            return;
+        }
+
+        // NOTE(patrik): The min and max instructions don't agree with
+        // javascript on NaN so NaN is tracked on the side
+        typename Ops::Vec minVec = Ops::Set(values[0]);
+        typename Ops::Vec maxVec = minVec;
+        typename Ops::NanMask nan = Ops::NoNan();
+
+        size_t i = 0;
+        for (; i + width <= count; i += width)
+        {
+            typename Ops::Vec value = Ops::Load(values + i);
+            minVec = Ops::Min(minVec, value);
+            maxVec = Ops::Max(maxVec, value);
+            nan = Ops::AddNan(nan, value);
+        }
+
+        T minLanes[width];
+        T maxLanes[width];
+        Ops::Store(minLanes, minVec);
+        Ops::Store(maxLanes, maxVec);
+
+        T minValue = minLanes[0];
+        T maxValue = maxLanes[0];
+        for (size_t lane = 1; lane < width; lane++)
+        {
+            minValue = minLanes[lane] < minValue ? minLanes[lane] : minValue;
+            maxValue = maxLanes[lane] > maxValue ? maxLanes[lane] : maxValue;
+        }
+
+        bool hasNan = Ops::AnyNan(nan);
+        for (; i < count; i++)
+        {
+            T value = values[i];
+            hasNan = hasNan || IsNan(value);
+            minValue = value < minValue ? value : minValue;
+            maxValue = value > maxValue ? value : maxValue;
+        }
+
+        if (hasNan || IsNan(values[0]))
+        {
+            *min = __builtin_nan("");
+            *max = __builtin_nan("");
+            return;
+        }
+
+        *min = (double)minValue;
+        *max = (double)maxValue;
+    }
+
+    /**
+     * Constexpr so the tables are filled in at compile time, no code built
+     * for an instruction set runs before the cpu has been checked
+     */
+    template <typename Ops>
+    constexpr VectorKernelTable<typename Ops::Scalar> MakeKernelTable()
+    {
+        return {SumKernel<Ops>, DotKernel<Ops>, AxpyKernel<Ops>,
+                ScaleKernel<Ops>, MinMaxKernel<Ops>};
+    }
+
+}} // namespace scripter::
@@ -0,0 +1,224 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2019 Patrik M. Rosenström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse4.2"))),               \
+                             apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("sse4.2")
+#endif
+#define SCRIPTER_VECTOR_KERNELS_SSE42
+#endif
+
+#include "scripter/utils/VectorKernelsImpl.h"
+
+#ifdef SCRIPTER_VECTOR_KERNELS_SSE42
+#include <smmintrin.h>
+#endif
+
+namespace scripter {
+
+#ifdef SCRIPTER_VECTOR_KERNELS_SSE42
+
+    namespace {
+
+        struct SseDouble
+        {
+            typedef double Scalar;
+            typedef __m128d Vec;
+            typedef __m128d Accum;
+            typedef __m128d NanMask;
+
+            static const size_t Width = 2;
+
+            static Vec Load(const double* p) { return _mm_loadu_pd(p); }
+            static void Store(double* p, Vec v) { _mm_storeu_pd(p, v); }
+            static Vec Set(double v) { return _mm_set1_pd(v); }
+
+            static Vec Add(Vec a, Vec b) { return _mm_add_pd(a, b); }
+            static Vec Mul(Vec a, Vec b) { return _mm_mul_pd(a, b); }
+            static Vec Min(Vec a, Vec b) { return _mm_min_pd(a, b); }
+            static Vec Max(Vec a, Vec b) { return _mm_max_pd(a, b); }
+
+            static Accum AccumZero() { return _mm_setzero_pd(); }
+            static Accum AccumAdd(Accum a, Accum b) { return Add(a, b); }
+
+            static void Accumulate(Accum& acc, Vec v) { acc = Add(acc, v); }
+            static void MulAccumulate(Accum& acc, Vec a, Vec b)
+            {
+                acc = Add(acc, Mul(a, b));
+            }
+
+            static double Reduce(Accum acc)
+            {
+                acc = _mm_add_sd(acc, _mm_unpackhi_pd(acc, acc));
+                return _mm_cvtsd_f64(acc);
+            }
+
+            static NanMask NoNan() { return _mm_setzero_pd(); }
+            static NanMask AddNan(NanMask mask, Vec v)
+            {
+                return _mm_or_pd(mask, _mm_cmpunord_pd(v, v));
+            }
+            static bool AnyNan(NanMask mask) { return _mm_movemask_pd(mask); }
+        };
+
+        struct SseFloat
+        {
+            typedef float Scalar;
+            typedef __m128 Vec;
+            typedef __m128 NanMask;
+
+            // NOTE(patrik): Summed as doubles, see the AVX2 kernels
+            struct Accum
+            {
+                __m128d low;
+                __m128d high;
+            };
+
+            static const size_t Width = 4;
+
+            static Vec Load(const float* p) { return _mm_loadu_ps(p); }
+            static void Store(float* p, Vec v) { _mm_storeu_ps(p, v); }
+            static Vec Set(float v) { return _mm_set1_ps(v); }
+
+            static Vec Add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+            static Vec Mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+            static Vec Min(Vec a, Vec b) { return _mm_min_ps(a, b); }
+            static Vec Max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+
+            static __m128d Low(Vec v) { return _mm_cvtps_pd(v); }
+            static __m128d High(Vec v)
+            {
+                return _mm_cvtps_pd(_mm_movehl_ps(v, v));
+            }
+
+            static Accum AccumZero()
+            {
+                return {_mm_setzero_pd(), _mm_setzero_pd()};
+            }
+            static Accum AccumAdd(Accum a, Accum b)
+            {
+                return {_mm_add_pd(a.low, b.low), _mm_add_pd(a.high, b.high)};
+            }
+
+            static void Accumulate(Accum& acc, Vec v)
+            {
+                acc.low = _mm_add_pd(acc.low, Low(v));
+                acc.high = _mm_add_pd(acc.high, High(v));
+            }
+            static void MulAccumulate(Accum& acc, Vec a, Vec b)
+            {
+                acc.low = _mm_add_pd(acc.low, _mm_mul_pd(Low(a), Low(b)));
+                acc.high = _mm_add_pd(acc.high, _mm_mul_pd(High(a), High(b)));
+            }
+
+            static double Reduce(Accum acc)
+            {
+                return SseDouble::Reduce(_mm_add_pd(acc.low, acc.high));
+            }
+
+            static NanMask NoNan() { return _mm_setzero_ps(); }
+            static NanMask AddNan(NanMask mask, Vec v)
+            {
+                return _mm_or_ps(mask, _mm_cmpunord_ps(v, v));
+            }
+            static bool AnyNan(NanMask mask) { return _mm_movemask_ps(mask); }
+        };
+
+        struct SseInt32
+        {
+            typedef int32 Scalar;
+            typedef __m128i Vec;
+            typedef __m128i Accum;
+            typedef bool NanMask;
+
+            static const size_t Width = 4;
+
+            static Vec Load(const int32* p)
+            {
+                return _mm_loadu_si128((const __m128i*)p);
+            }
+            static void Store(int32* p, Vec v)
+            {
+                _mm_storeu_si128((__m128i*)p, v);
+            }
+            static Vec Set(int32 v) { return _mm_set1_epi32(v); }
+
+            static Vec Add(Vec a, Vec b) { return _mm_add_epi32(a, b); }
+            static Vec Mul(Vec a, Vec b) { return _mm_mullo_epi32(a, b); }
+            static Vec Min(Vec a, Vec b) { return _mm_min_epi32(a, b); }
+            static Vec Max(Vec a, Vec b) { return _mm_max_epi32(a, b); }
+
+            static Accum AccumZero() { return _mm_setzero_si128(); }
+            static Accum AccumAdd(Accum a, Accum b)
+            {
+                return _mm_add_epi64(a, b);
+            }
+
+            static void Accumulate(Accum& acc, Vec v)
+            {
+                acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(v));
+                acc = _mm_add_epi64(
+                    acc, _mm_cvtepi32_epi64(_mm_srli_si128(v, 8)));
+            }
+            static void MulAccumulate(Accum& acc, Vec a, Vec b)
+            {
+                __m128i even = _mm_mul_epi32(a, b);
+                __m128i odd = _mm_mul_epi32(_mm_srli_epi64(a, 32),
+                                            _mm_srli_epi64(b, 32));
+                acc = _mm_add_epi64(acc, _mm_add_epi64(even, odd));
+            }
+
+            static int64 Reduce(Accum acc)
+            {
+                int64 lanes[2];
+                _mm_storeu_si128((__m128i*)lanes, acc);
+                return lanes[0] + lanes[1];
+            }
+
+            static NanMask NoNan() { return false; }
+            static NanMask AddNan(NanMask mask, Vec v) { return false; }
+            static bool AnyNan(NanMask mask) { return false; }
+        };
+
+        static const VectorKernelSet s_SseKernels = {
+            "sse4.2", MakeKernelTable<SseFloat>(),
+            MakeKernelTable<SseDouble>(), MakeKernelTable<SseInt32>()};
+
+    } // namespace
+
+    const VectorKernelSet* GetSse42VectorKernels() { return &s_SseKernels; }
+
+#else
+
+    const VectorKernelSet* GetSse42VectorKernels() { return nullptr; }
+
+#endif
+
+} // namespace scripter
+
+#if defined(SCRIPTER_VECTOR_KERNELS_SSE42) && defined(__clang__)
+#pragma clang attribute pop
+#endif
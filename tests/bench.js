@@ -0,0 +1,25 @@
+// Timing helpers shared by the benchmarks, import with
+// importModule("bench")
+
+addExport(time);
+addExport(compare);
+
+function time(func, iterations) {
+    func();
+
+    let start = Date.now();
+    for (let i = 0; i < iterations; i++) {
+        func();
+    }
+
+    return (Date.now() - start) / iterations;
+}
+
+function compare(name, jsFunc, nativeFunc, iterations) {
+    let jsTime = time(jsFunc, iterations);
+    let nativeTime = time(nativeFunc, iterations);
+
+    console.info(name + ": js " + jsTime.toFixed(3) + " ms, native " +
+                 nativeTime.toFixed(3) + " ms, " +
+                 (jsTime / nativeTime).toFixed(1) + "x");
+}
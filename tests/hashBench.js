@@ -0,0 +1,112 @@
+// Compares the hash module with the same hashes written in javascript,
+// run with: Scripter --script tests/hashBench.js
+
+function makeCrc32cTable() {
+    let table = new Uint32Array(256);
+    for (let i = 0; i < 256; i++) {
+        let crc = i;
+        for (let bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >>> 1) ^ 0x82f63b78 : crc >>> 1;
+        }
+        table[i] = crc;
+    }
+
+    return table;
+}
+
+function crc32c(table, bytes) {
+    let crc = 0xffffffff;
+    for (let i = 0; i < bytes.length; i++) {
+        crc = (crc >>> 8) ^ table[(crc ^ bytes[i]) & 0xff];
+    }
+
+    return (crc ^ 0xffffffff) >>> 0;
+}
+
+const K = new Uint32Array([
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+]);
+
+// Only hashes whole blocks, enough to time the compression
+function sha256Blocks(bytes) {
+    let h = new Uint32Array([
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    ]);
+    let w = new Uint32Array(64);
+    let rotr = (x, n) => (x >>> n) | (x << (32 - n));
+
+    for (let offset = 0; offset + 64 <= bytes.length; offset += 64) {
+        for (let i = 0; i < 16; i++) {
+            let p = offset + i * 4;
+            w[i] = (bytes[p] << 24) | (bytes[p + 1] << 16) |
+                   (bytes[p + 2] << 8) | bytes[p + 3];
+        }
+        for (let i = 16; i < 64; i++) {
+            let s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^
+                     (w[i - 15] >>> 3);
+            let s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^
+                     (w[i - 2] >>> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        let a = h[0], b = h[1], c = h[2], d = h[3];
+        let e = h[4], f = h[5], g = h[6], hh = h[7];
+        for (let i = 0; i < 64; i++) {
+            let s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            let t1 = (hh + s1 + ((e & f) ^ (~e & g)) + K[i] + w[i]) | 0;
+            let s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            let t2 = (s0 + ((a & b) ^ (a & c) ^ (b & c))) | 0;
+            hh = g; g = f; f = e; e = (d + t1) | 0;
+            d = c; c = b; b = a; a = (t1 + t2) | 0;
+        }
+
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+        h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+    }
+
+    return h;
+}
+
+function main(args) {
+    let bench = importModule("bench");
+    let hash = importModule("hash");
+
+    console.assert(hash.crc32c("123456789") === 0xe3069283, "crc32c");
+    console.assert(hash.xxhash64("abc") === "44bc2cf5ad770999", "xxhash64");
+    console.assert(hash.sha256("abc") ===
+                   "ba7816bf8f01cfea414140de5dae2223" +
+                   "b00361a396177a9cb410ff61f20015ad", "sha256");
+
+    let bytes = new Uint8Array(1 << 22);
+    for (let i = 0; i < bytes.length; i++) {
+        bytes[i] = (i * 2654435761) >>> 24;
+    }
+
+    let hasher = new hash.Hasher("sha256");
+    for (let i = 0; i < bytes.length; i += 1000) {
+        hasher.update(bytes.subarray(i, i + 1000));
+    }
+    console.assert(hasher.digest() === hash.sha256(bytes), "Hasher");
+    console.assert(new hash.Hasher("crc32c").update(bytes).digest() ===
+                   hash.crc32c(bytes), "crc32c Hasher");
+
+    let table = makeCrc32cTable();
+    console.assert(crc32c(table, bytes) === hash.crc32c(bytes), "crc32c");
+
+    console.info("Uint8Array x " + bytes.length);
+    bench.compare("  crc32c", () => crc32c(table, bytes),
+                  () => hash.crc32c(bytes), 10);
+    bench.compare("  sha256", () => sha256Blocks(bytes),
+                  () => hash.sha256(bytes), 5);
+}
@@ -0,0 +1,167 @@
+// Checks the json module against JSON.parse and JSON.stringify,
+// run with: Scripter --script tests/jsonTest.js
+
+function same(a, b) {
+    if (typeof a !== typeof b) {
+        return false;
+    }
+
+    if (a === null || b === null || typeof a !== "object") {
+        return Object.is(a, b);
+    }
+
+    if (Array.isArray(a) !== Array.isArray(b)) {
+        return false;
+    }
+
+    let aKeys = Object.keys(a);
+    let bKeys = Object.keys(b);
+    if (aKeys.length !== bKeys.length) {
+        return false;
+    }
+
+    for (let i = 0; i < aKeys.length; i++) {
+        if (aKeys[i] !== bKeys[i] || !same(a[aKeys[i]], b[bKeys[i]])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+function throws(func, type) {
+    try {
+        func();
+    } catch (e) {
+        return e instanceof type;
+    }
+
+    return false;
+}
+
+function nest(depth) {
+    let value = 1;
+    for (let i = 0; i < depth; i++) {
+        value = i % 2 ? [value] : { a: value };
+    }
+
+    return value;
+}
+
+function checkParse(json, text) {
+    console.assert(same(json.parse(text), JSON.parse(text)),
+                   "parse " + text);
+}
+
+function checkStringify(json, value, name) {
+    let expected = JSON.stringify(value);
+    let result = json.stringify(value);
+
+    // NOTE: Numbers can be written with a different exponent so the output
+    // is compared as values, strings are compared exactly
+    console.assert(result === expected ||
+                   (result !== undefined && expected !== undefined &&
+                    same(JSON.parse(result), JSON.parse(expected))),
+                   "stringify " + name);
+}
+
+function main(args) {
+    let json = importModule("json");
+
+    let texts = [
+        "null", "true", "false", "0", "-0", "1", "-1", "0.5", "-1.25e-7",
+        "1e21", "123456789012345678901234567890", "1e400", "-1e400", "1e-400",
+        "\"\"", "\"abc\"", "\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"",
+        "\"\\u0000\\u001f\\u00e9\\u20ac\"", "\"\\ud83d\\ude00\"",
+        "\"\\ud800\"", "\"\\udc00\"", "\"a\\ud800b\\udbffc\"",
+        "\"\\ude00\\ud83d\"", "\"\\ud800\\u0041\"", "\"\\ud800\\ud800\"",
+        "\"é€😀\"", "[]", "{}", " [1, [2, [3]], {\"a\": [null]}] ",
+        "{\"a\": 1, \"a\": 2}", "{\"\\ud800\": \"x\", \"b\": {\"c\": \"d\"}}",
+        "{\"2\": 1, \"1\": 2, \"x\": 3}"
+    ];
+
+    for (let text of texts) {
+        checkParse(json, text);
+    }
+
+    let deep = JSON.stringify(nest(500));
+    checkParse(json, deep);
+
+    let bad = [
+        "", "[", "[1,]", "{\"a\"}", "01", "1.", "-", "\"\\x\"", "\"\\u12\"",
+        "\"a\nb\"", "tru", "[1] 2", "[".repeat(10000) + "]".repeat(10000)
+    ];
+
+    for (let text of bad) {
+        console.assert(throws(() => json.parse(text), SyntaxError),
+                       "parse error " + text);
+    }
+
+    let values = {
+        "null": null, "true": true, "number": 1.5, "negative zero": -0,
+        "infinity": 1e400, "nan": NaN, "big": 1e21, "small": 1.5e-7,
+        "integer": 9007199254740991, "string": "a\"b\\c\n\u0001\u007f",
+        "unicode": "é€😀", "lone high": "a\ud800b", "lone low": "\udc00",
+        "reversed": "\ude00\ud83d", "trailing high": "x\udbff",
+        "undefined": undefined, "function": () => 1, "symbol": Symbol("x"),
+        "array": [1, undefined, () => 1, "x", [null]],
+        "object": { a: 1, b: undefined, c: { "\ud800": [true] } },
+        "boxed": [new Number(2), new String("s"), new Boolean(false)],
+        "toJSON": { a: { toJSON: (key) => "key " + key }, b: new Date(0) },
+        "array toJSON": [{ toJSON: (key) => typeof key + " " + key }],
+        "deep": nest(500)
+    };
+
+    for (let name in values) {
+        checkStringify(json, values[name], name);
+    }
+
+    let circular = { a: [] };
+    circular.a.push(circular);
+    console.assert(throws(() => json.stringify(circular), TypeError),
+                   "stringify circular");
+    console.assert(throws(() => json.stringify(1n), TypeError),
+                   "stringify BigInt");
+
+    for (let text of texts) {
+        let value = JSON.parse(text);
+        console.assert(same(json.parse(json.stringify(value)),
+                            JSON.parse(JSON.stringify(value))),
+                       "round trip " + text);
+    }
+
+    let parser = new json.Parser();
+    console.assert(same(parser.push("{\"a\":1}\n[2,"), [{ a: 1 }]),
+                   "push complete line");
+    console.assert(same(parser.push("3]\n\n\"\\ud800\"\n4"),
+                        [[2, 3], "\ud800"]), "push split line");
+    console.assert(same(parser.flush(), [4]), "flush last line");
+    console.assert(same(parser.flush(), []), "flush empty");
+
+    let error = null;
+    try {
+        parser.push("1\n2\n{bad\n3\n");
+    } catch (e) {
+        error = e;
+    }
+
+    console.assert(error instanceof SyntaxError, "push error");
+    console.assert(error !== null && same(error.values, [1, 2]),
+                   "push error values");
+    console.assert(same(parser.push("\n"), [3]), "push after error");
+
+    error = null;
+    try {
+        parser.push("5\n[");
+        parser.flush();
+    } catch (e) {
+        error = e;
+    }
+
+    console.assert(error instanceof SyntaxError, "flush error");
+    console.assert(error !== null && same(error.values, []),
+                   "flush error values");
+    console.assert(same(parser.flush(), []), "flush after error");
+
+    console.info("json tests done");
+}
@@ -0,0 +1,8 @@
+import { add, sub } from "./math.js";
+
+console.info("add:", add(4, 10));
+console.info("sub:", sub(10, 4));
+
+import("./math").then(math => {
+    console.info("dynamic add:", math.add(1, 2));
+});
@@ -3,6 +3,6 @@ function main(args) {
     //test.wow();
 
     let mod = importModule("testModule");
-    console.info(mod.addFunc(4, 10));
+    console.info(mod.add(4, 10));
 
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+// Compares the vecmath kernels with the same loops written in javascript,
+// run with: Scripter --script tests/vecmathBench.js
+
+function fill(array, seed) {
+    for (let i = 0; i < array.length; i++) {
+        seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+        array[i] = (seed % 2000) - 1000;
+    }
+
+    return array;
+}
+
+function benchType(bench, vecmath, type, size, iterations) {
+    let x = fill(new type(size), 1);
+    let y = fill(new type(size), 2);
+
+    console.info(type.name + " x " + size);
+
+    bench.compare("  sum", () => {
+        let sum = 0;
+        for (let i = 0; i < x.length; i++) {
+            sum += x[i];
+        }
+        return sum;
+    }, () => vecmath.sum(x), iterations);
+
+    bench.compare("  dot", () => {
+        let sum = 0;
+        for (let i = 0; i < x.length; i++) {
+            sum += x[i] * y[i];
+        }
+        return sum;
+    }, () => vecmath.dot(x, y), iterations);
+
+    bench.compare("  axpy", () => {
+        for (let i = 0; i < x.length; i++) {
+            y[i] += 3 * x[i];
+        }
+    }, () => vecmath.axpy(3, x, y), iterations);
+
+    bench.compare("  scale", () => {
+        for (let i = 0; i < y.length; i++) {
+            y[i] *= -1;
+        }
+    }, () => vecmath.scale(y, -1), iterations);
+
+    bench.compare("  min/max", () => {
+        let min = Infinity;
+        let max = -Infinity;
+        for (let i = 0; i < x.length; i++) {
+            min = Math.min(min, x[i]);
+            max = Math.max(max, x[i]);
+        }
+        return [min, max];
+    }, () => [vecmath.min(x), vecmath.max(x)], iterations);
+
+    bench.compare("  prefixSum", () => {
+        for (let i = 1; i < y.length; i++) {
+            y[i] += y[i - 1];
+        }
+    }, () => vecmath.prefixSum(y), iterations);
+
+    bench.compare("  histogram", () => {
+        let bins = new Uint32Array(64);
+        let scale = 64 / 2000;
+        for (let i = 0; i < x.length; i++) {
+            let bin = Math.floor((x[i] + 1000) * scale);
+            bins[bin < 64 ? bin : 63]++;
+        }
+        return bins;
+    }, () => vecmath.histogram(x, 64, -1000, 1000), iterations);
+
+    let a = fill(new type(1000), 3);
+    let b = fill(new type(1000), 4);
+    let expected = 0;
+    for (let i = 0; i < a.length; i++) {
+        expected += a[i] * b[i];
+    }
+    console.assert(vecmath.dot(a, b) === expected, "dot is wrong");
+}
+
+function main(args) {
+    let bench = importModule("bench");
+    let vecmath = importModule("vecmath");
+    console.info("vecmath backend:", vecmath.backend());
+
+    benchType(bench, vecmath, Float32Array, 1 << 20, 50);
+    benchType(bench, vecmath, Float64Array, 1 << 20, 50);
+    benchType(bench, vecmath, Int32Array, 1 << 20, 50);
+}